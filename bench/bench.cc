@@ -0,0 +1,348 @@
+// Google Benchmark sweep of the Bits<N> operations over a set of widths.
+//
+// Every operation is measured three ways:
+//
+//    mango   Bits<N>
+//    limbs   a hand-written loop over a plain std::array<uint64_t, L>
+//    int128  unsigned __int128, for the widths where the result fits
+//
+// Benchmarks are named <operation>/<implementation>/<width>, e.g.
+// `bench --benchmark_filter='add/.*/64$'`. Time is reported as ns/op, the
+// bytes/op counter is the size of the operands plus the size of the result.
+
+#include <array>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <cstdio>
+
+#include "mango/bits.h"
+
+using mango::Bits;
+using u128 = mango::uint128_t;
+typedef int i128 __attribute__((mode(TI)));
+
+enum class Op {
+  add,
+  add_wrap,
+  sub,
+  mul_wrap,
+  cmp,
+  sign_extend,
+  concat,
+  shr,
+  extract,
+  flip_bit
+};
+
+constexpr const char *op_name(const Op op) {
+  switch (op) {
+  case Op::add:
+    return "add";
+  case Op::add_wrap:
+    return "add_wrap";
+  case Op::mul_wrap:
+    return "mul_wrap";
+  case Op::sub:
+    return "sub";
+  case Op::cmp:
+    return "cmp";
+  case Op::sign_extend:
+    return "sign_extend";
+  case Op::concat:
+    return "concat";
+  case Op::shr:
+    return "shr";
+  case Op::extract:
+    return "extract";
+  case Op::flip_bit:
+    return "flip_bit";
+  }
+  return "?";
+}
+
+// shr shifts by N / 2, extract takes bits [N - 1 - N / 4, N / 4],
+// sign_extend adds 64 bits and flip_bit flips the top bit
+template <uint16_t N> constexpr uint16_t SHIFT = N / 2;
+template <uint16_t N> constexpr uint16_t EX_LOW = N / 4;
+template <uint16_t N> constexpr uint16_t EX_HIGH = N - 1 - N / 4;
+
+template <uint16_t N>
+std::array<uint64_t, Bits<N>::LIMBS> random_limbs(uint64_t s) {
+  std::array<uint64_t, Bits<N>::LIMBS> out{};
+  for (auto &v : out) {
+    s = s * 6364136223846793005ULL + 1442695040888963407ULL;
+    v = s ^ (s >> 29);
+  }
+  out[out.size() - 1] &= Bits<N>::TOP_MASK;
+  return out;
+}
+
+/////////////// mango ///////////////
+
+template <Op op, uint16_t N>
+auto mango_op(const Bits<N> &a, const Bits<N> &b) {
+  if constexpr (op == Op::add) {
+    return a + b;
+  } else if constexpr (op == Op::add_wrap) {
+    return a.add_wrap(b);
+  } else if constexpr (op == Op::mul_wrap) {
+    return a.mul_wrap(b);
+  } else if constexpr (op == Op::sub) {
+    return a - b;
+  } else if constexpr (op == Op::cmp) {
+    return a.cmp(b);
+  } else if constexpr (op == Op::sign_extend) {
+    return a.template sign_extend<N + 64>();
+  } else if constexpr (op == Op::concat) {
+    return a.concat(b);
+  } else if constexpr (op == Op::shr) {
+    return a.template shr<SHIFT<N>>();
+  } else if constexpr (op == Op::extract) {
+    return a.template extract<EX_HIGH<N>, EX_LOW<N>>();
+  } else {
+    return a.template flip_bit<N - 1>();
+  }
+}
+
+/////////////// hand-written limb loops ///////////////
+
+template <uint16_t N> struct Limbs {
+  constexpr static uint16_t L = (N + 63) / 64;
+  constexpr static uint64_t TOP =
+      (N % 64 == 0) ? ~uint64_t(0) : (uint64_t(1) << (N % 64)) - 1;
+  std::array<uint64_t, L> v{};
+};
+
+// a >> s truncated to W bits
+template <uint16_t W, uint16_t N>
+Limbs<W> shift_right(const Limbs<N> &a, const uint16_t s) {
+  Limbs<W> r;
+  const uint16_t q = s / 64;
+  const uint16_t t = s % 64;
+  for (uint16_t i = 0; i < Limbs<W>::L; i++) {
+    const uint64_t lo = (i + q < Limbs<N>::L) ? a.v[i + q] : 0;
+    const uint64_t hi = (i + q + 1 < Limbs<N>::L) ? a.v[i + q + 1] : 0;
+    r.v[i] = (t == 0) ? lo : ((lo >> t) | (hi << (64 - t)));
+  }
+  r.v[Limbs<W>::L - 1] &= Limbs<W>::TOP;
+  return r;
+}
+
+template <Op op, uint16_t N>
+auto limbs_op(const Limbs<N> &a, const Limbs<N> &b) {
+  constexpr uint16_t L = Limbs<N>::L;
+  if constexpr (op == Op::add) {
+    Limbs<N + 1> r;
+    uint64_t c = 0;
+    for (uint16_t i = 0; i < L; i++) {
+      const uint64_t s = a.v[i] + c;
+      const uint64_t c1 = s < c;
+      r.v[i] = s + b.v[i];
+      c = c1 | (r.v[i] < s);
+    }
+    if constexpr (Limbs<N + 1>::L > L) {
+      r.v[L] = c;
+    }
+    return r;
+  } else if constexpr (op == Op::add_wrap) {
+    Limbs<N> r;
+    uint64_t c = 0;
+    for (uint16_t i = 0; i < L; i++) {
+      const uint64_t s = a.v[i] + c;
+      const uint64_t c1 = s < c;
+      r.v[i] = s + b.v[i];
+      c = c1 | (r.v[i] < s);
+    }
+    r.v[L - 1] &= Limbs<N>::TOP;
+    return r;
+  } else if constexpr (op == Op::mul_wrap) {
+    // schoolbook, only the products that land in the low L limbs
+    Limbs<N> r;
+    for (uint16_t i = 0; i < L; i++) {
+      u128 carry = 0;
+      for (uint16_t j = 0; i + j < L; j++) {
+        const u128 t = u128(a.v[i]) * b.v[j] + r.v[i + j] + carry;
+        r.v[i + j] = uint64_t(t);
+        carry = t >> 64;
+      }
+    }
+    r.v[L - 1] &= Limbs<N>::TOP;
+    return r;
+  } else if constexpr (op == Op::sub) {
+    Limbs<N + 1> r;
+    uint64_t borrow = 0;
+    for (uint16_t i = 0; i < L; i++) {
+      const uint64_t d = a.v[i] - b.v[i];
+      const uint64_t b1 = a.v[i] < b.v[i];
+      r.v[i] = d - borrow;
+      borrow = b1 | (d < borrow);
+    }
+    if constexpr (Limbs<N + 1>::L > L) {
+      r.v[L] = uint64_t(0) - borrow;
+    }
+    r.v[Limbs<N + 1>::L - 1] &= Limbs<N + 1>::TOP;
+    return r;
+  } else if constexpr (op == Op::cmp) {
+    for (uint16_t i = L; i-- > 0;) {
+      if (a.v[i] != b.v[i]) {
+        return (a.v[i] < b.v[i]) ? -1 : 1;
+      }
+    }
+    return 0;
+  } else if constexpr (op == Op::sign_extend) {
+    Limbs<N + 64> r;
+    const uint64_t fill =
+        uint64_t(0) - ((a.v[(N - 1) / 64] >> ((N - 1) % 64)) & 1);
+    for (uint16_t i = 0; i < Limbs<N + 64>::L; i++) {
+      r.v[i] = (i < L) ? a.v[i] : fill;
+    }
+    r.v[L - 1] |= fill & ~Limbs<N>::TOP;
+    r.v[Limbs<N + 64>::L - 1] &= Limbs<N + 64>::TOP;
+    return r;
+  } else if constexpr (op == Op::concat) {
+    Limbs<2 * N> r;
+    constexpr uint16_t q = N / 64;
+    constexpr uint16_t t = N % 64;
+    for (uint16_t i = 0; i < L; i++) {
+      r.v[i] = b.v[i];
+    }
+    for (uint16_t i = 0; i < L; i++) {
+      r.v[i + q] |= a.v[i] << t;
+      if (t != 0 && i + q + 1 < Limbs<2 * N>::L) {
+        r.v[i + q + 1] |= a.v[i] >> (64 - t);
+      }
+    }
+    return r;
+  } else if constexpr (op == Op::shr) {
+    if constexpr (N - SHIFT<N> == 0) {
+      return Limbs<1>{};
+    } else {
+      return shift_right<N - SHIFT<N>>(a, SHIFT<N>);
+    }
+  } else if constexpr (op == Op::extract) {
+    return shift_right<EX_HIGH<N> - EX_LOW<N> + 1>(a, EX_LOW<N>);
+  } else {
+    Limbs<N> r = a;
+    r.v[(N - 1) / 64] ^= uint64_t(1) << ((N - 1) % 64);
+    return r;
+  }
+}
+
+/////////////// unsigned __int128 ///////////////
+
+constexpr u128 mask128(const uint16_t bits) {
+  return (bits >= 128) ? ~u128(0) : (u128(1) << bits) - 1;
+}
+
+// widths where the result of op fits in 128 bits (add and sub wrap at N = 128)
+template <Op op, uint16_t N> constexpr bool fits_int128() {
+  if constexpr (op == Op::sign_extend || op == Op::concat) {
+    return N <= 64;
+  } else {
+    return N <= 128;
+  }
+}
+
+template <Op op, uint16_t N> auto int128_op(const u128 a, const u128 b) {
+  if constexpr (op == Op::add) {
+    return (a + b) & mask128(N + 1);
+  } else if constexpr (op == Op::add_wrap) {
+    return (a + b) & mask128(N);
+  } else if constexpr (op == Op::mul_wrap) {
+    return (a * b) & mask128(N);
+  } else if constexpr (op == Op::sub) {
+    return (a - b) & mask128(N + 1);
+  } else if constexpr (op == Op::cmp) {
+    return int(a > b) - int(a < b);
+  } else if constexpr (op == Op::sign_extend) {
+    return u128(i128(a << (128 - N)) >> (128 - N)) & mask128(N + 64);
+  } else if constexpr (op == Op::concat) {
+    return (a << N) | b;
+  } else if constexpr (op == Op::shr) {
+    return a >> SHIFT<N>;
+  } else if constexpr (op == Op::extract) {
+    return (a >> EX_LOW<N>) & mask128(EX_HIGH<N> - EX_LOW<N> + 1);
+  } else {
+    return a ^ (u128(1) << (N - 1));
+  }
+}
+
+/////////////// driver ///////////////
+
+template <typename F, typename T>
+void measure(benchmark::State &state, F f, const T &a_, const T &b_) {
+  T a = a_;
+  T b = b_;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(a);
+    benchmark::DoNotOptimize(b);
+    auto r = f(a, b);
+    benchmark::DoNotOptimize(r);
+  }
+  state.counters["bytes/op"] = double(2 * sizeof(T) + sizeof(f(a, b)));
+}
+
+const char *bench_name(char (&buf)[64], const Op op, const char *impl,
+                       const uint16_t n) {
+  snprintf(buf, sizeof(buf), "%s/%s/%u", op_name(op), impl, n);
+  return buf;
+}
+
+template <Op op, uint16_t N> void register_op() {
+  char name[64];
+
+  benchmark::RegisterBenchmark(
+      bench_name(name, op, "mango", N), [](benchmark::State &state) {
+        measure(state, mango_op<op, N>, Bits<N>{random_limbs<N>(1)},
+                Bits<N>{random_limbs<N>(2)});
+      });
+
+  benchmark::RegisterBenchmark(
+      bench_name(name, op, "limbs", N), [](benchmark::State &state) {
+        measure(state, limbs_op<op, N>, Limbs<N>{random_limbs<N>(1)},
+                Limbs<N>{random_limbs<N>(2)});
+      });
+
+  if constexpr (fits_int128<op, N>()) {
+    benchmark::RegisterBenchmark(
+        bench_name(name, op, "int128", N), [](benchmark::State &state) {
+          const auto a = random_limbs<N>(1);
+          const auto b = random_limbs<N>(2);
+          measure(state, int128_op<op, N>,
+                  (u128(Bits<N>{a}.get(1)) << 64) | a[0],
+                  (u128(Bits<N>{b}.get(1)) << 64) | b[0]);
+        });
+  }
+}
+
+template <Op op> void register_widths() {
+  register_op<op, 1>();
+  register_op<op, 63>();
+  register_op<op, 64>();
+  register_op<op, 65>();
+  register_op<op, 128>();
+  register_op<op, 256>();
+  register_op<op, 1024>();
+  register_op<op, 4096>();
+}
+
+int main(int argc, char **argv) {
+  register_widths<Op::add>();
+  register_widths<Op::add_wrap>();
+  register_widths<Op::mul_wrap>();
+  register_widths<Op::sub>();
+  register_widths<Op::cmp>();
+  register_widths<Op::sign_extend>();
+  register_widths<Op::concat>();
+  register_widths<Op::shr>();
+  register_widths<Op::extract>();
+  register_widths<Op::flip_bit>();
+
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+    return 1;
+  }
+  benchmark::RunSpecifiedBenchmarks();
+  benchmark::Shutdown();
+  return 0;
+}
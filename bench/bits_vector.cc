@@ -0,0 +1,115 @@
+// Bulk throughput of BitsVector<N> (columns) against a loop over
+// std::vector<Bits<N>> (rows), in elements per cycle (per ns when there is
+// no cycle counter).
+//
+//    c++ -std=c++23 -O2 -march=native -I. bench/bits_vector.cc  # make vector
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "mango/bits_vector.h"
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+constexpr const char *unit = "elements/cycle";
+inline uint64_t ticks() { return __rdtsc(); }
+#else
+constexpr const char *unit = "elements/ns";
+inline uint64_t ticks() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+#endif
+
+using namespace mango;
+
+constexpr size_t count = 1 << 16;
+constexpr int reps = 20;
+
+template <typename T> inline void keep(const T &v) {
+  asm volatile("" : : "g"(&v) : "memory");
+}
+
+template <typename F> double throughput(F f) {
+  f(); // warm up, page in the outputs
+  const uint64_t start = ticks();
+  for (int i = 0; i < reps; i++) {
+    f();
+  }
+  return double(count) * reps / double(ticks() - start);
+}
+
+template <uint16_t N> Bits<N> element(uint64_t s) {
+  typename Bits<N>::Limbs limbs{};
+  for (auto &v : limbs) {
+    s = s * 6364136223846793005ULL + 1442695040888963407ULL;
+    v = s ^ (s >> 29);
+  }
+  return Bits<N>{limbs};
+}
+
+template <uint16_t N> void run() {
+  std::vector<Bits<N>> ra, rb;
+  BitsVector<N> ca, cb;
+  for (size_t j = 0; j < count; j++) {
+    ra.push_back(element<N>(j));
+    rb.push_back(element<N>(j + count));
+    ca.push_back(ra.back());
+    cb.push_back(rb.back());
+  }
+
+  const double row_add = throughput([&] {
+    std::vector<decltype(ra[0] + rb[0])> out(count);
+    for (size_t j = 0; j < count; j++) {
+      out[j] = ra[j] + rb[j];
+    }
+    keep(out);
+  });
+  const double col_add = throughput([&] { keep(ca + cb); });
+
+  const double row_and = throughput([&] {
+    std::vector<Bits<N>> out(count);
+    for (size_t j = 0; j < count; j++) {
+      out[j] = ra[j] & rb[j];
+    }
+    keep(out);
+  });
+  const double col_and = throughput([&] { keep(ca & cb); });
+
+  const double row_lt = throughput([&] {
+    std::vector<Bits<1>> out(count);
+    for (size_t j = 0; j < count; j++) {
+      out[j] = Bits<1>{ra[j].cmp(rb[j]) == Cmp::LT};
+    }
+    keep(out);
+  });
+  const double col_lt = throughput([&] { keep(ca.lt(cb)); });
+
+  const double row_pop = throughput([&] {
+    std::vector<uint16_t> out(count);
+    for (size_t j = 0; j < count; j++) {
+      out[j] = ra[j].count_ones();
+    }
+    keep(out);
+  });
+  const double col_pop = throughput([&] { keep(ca.popcount()); });
+
+  printf("%5u %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f %8.3f\n", N, row_add,
+         col_add, row_and, col_and, row_lt, col_lt, row_pop, col_pop);
+}
+
+int main() {
+  printf("%s, %zu elements\n", unit, count);
+  printf("%5s %8s %8s %8s %8s %8s %8s %8s %8s\n", "width", "add/row",
+         "add/col", "and/row", "and/col", "lt/row", "lt/col", "pop/row",
+         "pop/col");
+  run<32>();
+  run<64>();
+  run<128>();
+  run<256>();
+  run<1024>();
+  return 0;
+}
@@ -0,0 +1,39 @@
+// Translation unit for bench/compile_time.sh: compile-time range arithmetic on
+// BENCH_WIDTH-bit values, compiled once per width.
+
+#include "mango/int.h"
+#include "mango/nat.h"
+
+#ifndef BENCH_WIDTH
+#define BENCH_WIDTH 256
+#endif
+
+using namespace mango;
+
+using Max = decltype((Nat<1>{} << Nat<BENCH_WIDTH>{}) - Nat<1>{});
+
+// a chain of Nat operations, each with a new BENCH_WIDTH-bit intermediate value
+constexpr auto chain() {
+  constexpr auto a = Max{} >> Nat<3>{};
+  constexpr auto b = (a + Max{}) - (a >> Nat<5>{});
+  constexpr auto c = (b << Nat<7>{}).template trim<BENCH_WIDTH>();
+  constexpr auto d = (c + b + a) >> Nat<BENCH_WIDTH / 2>{};
+  return (c.cmp(d) == Cmp::GT) ? c.bit_size() : d.bit_size();
+}
+
+static_assert(chain() > 0);
+
+// range math of Int operations at this width
+auto add(const UnsignedInt<BENCH_WIDTH> a, const UnsignedInt<BENCH_WIDTH> b,
+         const UnsignedInt<BENCH_WIDTH / 2> c) {
+  return a + b + c;
+}
+
+auto mul(const UnsignedInt<BENCH_WIDTH / 2> a,
+         const SignedInt<BENCH_WIDTH / 2> b) {
+  return a * b;
+}
+
+auto div(const UnsignedInt<BENCH_WIDTH> a, const Int<Nat<3>, Nat<1000>> b) {
+  return a / b;
+}
@@ -0,0 +1,57 @@
+#!/bin/bash
+#
+# Compile bench/compile_time.cc once per width and report the compile time,
+# the number of mango::Nat classes the compiler created and its memory use.
+#
+# The last column is the memory from the TOTAL line of -ftime-report with gcc,
+# and the class instantiation time from -ftime-trace with clang.
+#
+# usage: bench/compile_time.sh [compiler] [output directory] [widths...]
+
+set -e
+
+CXX=${1:-c++}
+OUT=${2:-build/compile_time}
+shift 2 || shift $#
+WIDTHS=${*:-64 256 1024 2048 4096}
+FLAGS="-std=c++23 -O2 -I."
+
+mkdir -p "${OUT}"
+
+if ${CXX} --version | grep -q clang; then
+  CLANG=1
+  LAST=instantiate
+else
+  LAST=memory
+fi
+
+printf "%6s %8s %8s %12s\n" width seconds classes ${LAST}
+for w in ${WIDTHS}; do
+  src="${OUT}/compile_time_${w}.o"
+  start=$(date +%s.%N)
+  if [ -n "${CLANG}" ]; then
+    ${CXX} ${FLAGS} -DBENCH_WIDTH=${w} -ftime-trace -c bench/compile_time.cc \
+      -o "${src}"
+    trace="${src%.o}.json"
+    last=$(python3 -c "import json, sys
+events = json.load(open(sys.argv[1]))['traceEvents']
+us = sum(e.get('dur', 0) for e in events
+         if e.get('name') == 'Total InstantiateClass')
+print('%.2fs' % (us / 1e6))" "${trace}")
+    # clang has no class dump, count the instantiated Nat specializations
+    classes=$(python3 -c "import json, sys
+events = json.load(open(sys.argv[1]))['traceEvents']
+print(sum(1 for e in events if e.get('name') == 'InstantiateClass'
+          and 'Nat<' in e.get('args', {}).get('detail', '')))" "${trace}")
+  else
+    ${CXX} ${FLAGS} -DBENCH_WIDTH=${w} -ftime-report -fdump-lang-class \
+      -dumpbase "${src%.o}" -c bench/compile_time.cc -o "${src}" \
+      2>"${src%.o}.time"
+    last=$(awk '/^ TOTAL/ { print $NF }' "${src%.o}.time")
+    classes=$(grep -c '^Class mango::Nat<' "${src%.o}".*class || true)
+  fi
+  end=$(date +%s.%N)
+
+  secs=$(awk "BEGIN { printf \"%.2f\", ${end} - ${start} }")
+  printf "%6s %8s %8s %12s\n" "${w}" "${secs}" "${classes}" "${last}"
+done
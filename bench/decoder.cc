@@ -0,0 +1,138 @@
+// Instruction decode throughput of Decoder<...> against a linear scan over
+// the same patterns, in words per cycle (per ns when there is no cycle
+// counter): match alone and decode, which also dispatches to the handler.
+//
+//    c++ -std=c++23 -O3 -march=native -I. bench/decoder.cc  # make decoder
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "mango/decoder.h"
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+constexpr const char *unit = "words/cycle";
+inline uint64_t ticks() { return __rdtsc(); }
+#else
+constexpr const char *unit = "words/ns";
+inline uint64_t ticks() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+#endif
+
+using namespace mango;
+
+template <uint64_t M, uint64_t V> using Enc = MaskedBits<32, Nat<M>, Nat<V>>;
+
+// A64 base instructions, specific encodings before the general ones
+using A64 = Decoder<
+    Enc<0xffffffff, 0xd503201f>, // nop
+    Enc<0xfffff01f, 0xd503201f>, // hint
+    Enc<0xfffffc1f, 0xd65f0000>, // ret
+    Enc<0xfffffc1f, 0xd61f0000>, // br
+    Enc<0xfffffc1f, 0xd63f0000>, // blr
+    Enc<0x7f800000, 0x11000000>, // add (immediate)
+    Enc<0x7f800000, 0x31000000>, // adds (immediate)
+    Enc<0x7f800000, 0x51000000>, // sub (immediate)
+    Enc<0x7f800000, 0x71000000>, // subs (immediate)
+    Enc<0x7f200000, 0x0b000000>, // add (shifted register)
+    Enc<0x7f200000, 0x2b000000>, // adds (shifted register)
+    Enc<0x7f200000, 0x4b000000>, // sub (shifted register)
+    Enc<0x7f200000, 0x6b000000>, // subs (shifted register)
+    Enc<0x7f200000, 0x0a000000>, // and (shifted register)
+    Enc<0x7f200000, 0x2a000000>, // orr (shifted register)
+    Enc<0x7f200000, 0x4a000000>, // eor (shifted register)
+    Enc<0x7f800000, 0x12000000>, // and (immediate)
+    Enc<0x7f800000, 0x32000000>, // orr (immediate)
+    Enc<0x7f800000, 0x52000000>, // eor (immediate)
+    Enc<0x7f800000, 0x12800000>, // movn
+    Enc<0x7f800000, 0x52800000>, // movz
+    Enc<0x7f800000, 0x72800000>, // movk
+    Enc<0x7f800000, 0x13000000>, // sbfm
+    Enc<0x7f800000, 0x53000000>, // ubfm
+    Enc<0x9f000000, 0x10000000>, // adr
+    Enc<0x9f000000, 0x90000000>, // adrp
+    Enc<0xfc000000, 0x14000000>, // b
+    Enc<0xfc000000, 0x94000000>, // bl
+    Enc<0xff000010, 0x54000000>, // b.cond
+    Enc<0x7f000000, 0x34000000>, // cbz
+    Enc<0x7f000000, 0x35000000>, // cbnz
+    Enc<0x7f000000, 0x36000000>, // tbz
+    Enc<0x7f000000, 0x37000000>, // tbnz
+    Enc<0xbfc00000, 0xb9400000>, // ldr (unsigned offset)
+    Enc<0xbfc00000, 0xb9000000>, // str (unsigned offset)
+    Enc<0xffc00000, 0x39400000>, // ldrb (unsigned offset)
+    Enc<0xffc00000, 0x39000000>, // strb (unsigned offset)
+    Enc<0x7fc00000, 0x29400000>, // ldp (signed offset)
+    Enc<0x7fc00000, 0x29000000>, // stp (signed offset)
+    Enc<0x7fe00c00, 0x1a800000>, // csel
+    Enc<0x7fe00c00, 0x1a800400>, // csinc
+    Enc<0x7fe08000, 0x1b000000>, // madd
+    Enc<0x7fe08000, 0x1b008000>, // msub
+    Enc<0x7fe0fc00, 0x1ac00800>, // udiv
+    Enc<0x7fe0fc00, 0x1ac00c00>, // sdiv
+    Enc<0, 0>>;                  // undefined
+
+uint16_t linear_match(const uint32_t w) {
+  for (uint16_t i = 0; i < A64::COUNT; i++) {
+    if ((w & A64::PATTERNS[i].mask) == A64::PATTERNS[i].value) {
+      return i;
+    }
+  }
+  return A64::COUNT;
+}
+
+template <typename F>
+double throughput(const std::vector<uint32_t> &words, F f) {
+  uint64_t sum = 0;
+  for (const uint32_t w : words) {
+    sum += f(w);
+  }
+  const uint64_t start = ticks();
+  for (int r = 0; r < 10; r++) {
+    for (const uint32_t w : words) {
+      sum += f(w);
+    }
+  }
+  const uint64_t end = ticks();
+  asm volatile("" : : "g"(sum) : "memory");
+  return double(words.size()) * 10 / double(end - start);
+}
+
+int main() {
+  // every pattern equally often with random free bits
+  std::vector<uint32_t> words(1 << 16);
+  uint64_t s = 1;
+  for (auto &w : words) {
+    s = s * 6364136223846793005ULL + 1442695040888963407ULL;
+    const auto &p = A64::PATTERNS[(s >> 7) % A64::COUNT];
+    w = uint32_t(((s >> 32) & ~p.mask) | p.value);
+    if (A64::match(Bits<32>{w}) != linear_match(w)) {
+      printf("mismatch for %08x\n", w);
+      return 1;
+    }
+  }
+
+  printf("%zu patterns, %zu nodes, %zu table entries, depth %u, %s\n",
+         size_t(A64::COUNT), A64::SIZES[0], A64::SIZES[1],
+         unsigned(A64::DEPTH), unit);
+  printf("%-8s %8.3f\n", "linear", throughput(words, linear_match));
+  printf("%-8s %8.3f\n", "decoder", throughput(words, [](const uint32_t w) {
+           return A64::match(Bits<32>{w});
+         }));
+  // match and call a handler instantiated for each pattern
+  printf("%-8s %8.3f\n", "decode", throughput(words, [](const uint32_t w) {
+           return A64::decode(
+               Bits<32>{w},
+               [](const auto ins) {
+                 using Ins = decltype(ins);
+                 return uint16_t(ins.bits.get(0) >> Ins::mask.bit_size() % 8);
+               },
+               [](const Bits<32> &) { return uint16_t(0); });
+         }));
+  return 0;
+}
@@ -0,0 +1,107 @@
+// Cost of a runtime width: (a * b + c) ^ a with Bits<N>, and with DynBits
+// whose wide temporaries come from the heap or from a monotonic arena that
+// is reset every iteration, in cycles per expression (ns when there is no
+// cycle counter).
+//
+//    c++ -std=c++23 -O3 -march=native -I. bench/dyn_bits.cc  # make dyn
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory_resource>
+#include <vector>
+
+#include "mango/dyn_bits.h"
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+constexpr const char *unit = "cycles";
+inline uint64_t ticks() { return __rdtsc(); }
+#else
+constexpr const char *unit = "ns";
+inline uint64_t ticks() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+#endif
+
+using namespace mango;
+
+constexpr size_t count = 1 << 12;
+constexpr int reps = 20;
+
+template <typename T> inline void keep(const T &v) {
+  asm volatile("" : : "g"(&v) : "memory");
+}
+
+// the best of a few runs, this is a noisy measurement
+template <typename F> double per_op(F f) {
+  double best = 0;
+  for (int k = 0; k < 5; k++) {
+    f();
+    const uint64_t start = ticks();
+    for (int i = 0; i < reps; i++) {
+      f();
+    }
+    const double t = double(ticks() - start) / (double(count) * reps);
+    best = (k == 0 || t < best) ? t : best;
+  }
+  return best;
+}
+
+template <uint16_t N> Bits<N> element(uint64_t s) {
+  typename Bits<N>::Limbs limbs{};
+  for (auto &v : limbs) {
+    s = s * 6364136223846793005ULL + 1442695040888963407ULL;
+    v = s ^ (s >> 29);
+  }
+  return Bits<N>{limbs};
+}
+
+template <uint16_t N> void run() {
+  std::vector<Bits<N>> a, b, c;
+  std::vector<DynBits> da, db, dc;
+  for (size_t j = 0; j < count; j++) {
+    a.push_back(element<N>(3 * j));
+    b.push_back(element<N>(3 * j + 1));
+    c.push_back(element<N>(3 * j + 2));
+    da.emplace_back(a.back());
+    db.emplace_back(b.back());
+    dc.emplace_back(c.back());
+  }
+
+  const double fixed = per_op([&] {
+    for (size_t j = 0; j < count; j++) {
+      keep((a[j] * b[j] + c[j]) ^ a[j]);
+    }
+  });
+  const double heap = per_op([&] {
+    for (size_t j = 0; j < count; j++) {
+      keep((da[j] * db[j] + dc[j]) ^ da[j]);
+    }
+  });
+  alignas(64) std::array<std::byte, 1 << 14> buffer;
+  std::pmr::monotonic_buffer_resource arena{buffer.data(), buffer.size()};
+  const double pooled = per_op([&] {
+    for (size_t j = 0; j < count; j++) {
+      const DynBits x{da[j], &arena};
+      keep((x * db[j] + dc[j]) ^ da[j]);
+      arena.release();
+    }
+  });
+
+  printf("%6u %10.1f %10.1f %10.1f\n", unsigned(N), fixed, heap, pooled);
+}
+
+int main() {
+  printf("%s per (a * b + c) ^ a\n", unit);
+  printf("%6s %10s %10s %10s\n", "N", "Bits<N>", "heap", "arena");
+  run<32>();
+  run<64>();
+  run<100>();
+  run<256>();
+  run<1024>();
+  return 0;
+}
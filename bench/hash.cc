@@ -0,0 +1,116 @@
+// Hashing Bits<N> keys: mango::hash one key at a time and with hash_batch,
+// against a boost style hash_combine over the limbs, in cycles per key (ns
+// when there is no cycle counter), and the time to fill an unordered_set
+// with either hash.
+//
+//    c++ -std=c++23 -O3 -march=native -I. bench/hash.cc  # make hash
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <span>
+#include <unordered_set>
+#include <vector>
+
+#include "mango/hash.h"
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+constexpr const char *unit = "cycles";
+inline uint64_t ticks() { return __rdtsc(); }
+#else
+constexpr const char *unit = "ns";
+inline uint64_t ticks() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+#endif
+
+using namespace mango;
+
+constexpr size_t count = 1 << 14;
+
+template <typename T> inline void keep(const T &v) {
+  asm volatile("" : : "g"(&v) : "memory");
+}
+
+// the best of a few runs, this is a noisy measurement
+template <typename F> double per_key(F f) {
+  double best = 0;
+  for (int k = 0; k < 5; k++) {
+    f();
+    const uint64_t start = ticks();
+    f();
+    const double t = double(ticks() - start) / double(count);
+    best = (k == 0 || t < best) ? t : best;
+  }
+  return best;
+}
+
+template <uint16_t N> struct Combine {
+  size_t operator()(const Bits<N> &x) const noexcept {
+    size_t h = 0;
+    for (uint16_t i = 0; i < Bits<N>::LIMBS; i++) {
+      h ^= x.get(i) + 0x9e3779b97f4a7c15 + (h << 6) + (h >> 2);
+    }
+    return h;
+  }
+};
+
+template <uint16_t N> Bits<N> element(uint64_t s) {
+  typename Bits<N>::Limbs limbs{};
+  for (auto &v : limbs) {
+    s = s * 6364136223846793005ULL + 1442695040888963407ULL;
+    v = s ^ (s >> 29);
+  }
+  return Bits<N>{limbs};
+}
+
+template <uint16_t N> void run() {
+  std::vector<Bits<N>> keys;
+  for (size_t j = 0; j < count; j++) {
+    keys.push_back(element<N>(j));
+  }
+  std::vector<uint64_t> out(count);
+
+  const double single = per_key([&] {
+    for (size_t j = 0; j < count; j++) {
+      out[j] = hash(keys[j], 1);
+    }
+    keep(out);
+  });
+  const double batch = per_key([&] {
+    hash_batch(std::span{keys}, std::span{out}, 1);
+    keep(out);
+  });
+  const double combine = per_key([&] {
+    for (size_t j = 0; j < count; j++) {
+      out[j] = Combine<N>{}(keys[j]);
+    }
+    keep(out);
+  });
+  const double set = per_key([&] {
+    std::unordered_set<Bits<N>> s(keys.begin(), keys.end());
+    keep(s);
+  });
+  const double set_combine = per_key([&] {
+    std::unordered_set<Bits<N>, Combine<N>> s(keys.begin(), keys.end());
+    keep(s);
+  });
+
+  printf("%6u %8.1f %8.1f %8.1f %10.1f %10.1f\n", unsigned(N), single, batch,
+         combine, set, set_combine);
+}
+
+int main() {
+  printf("%s per key\n", unit);
+  printf("%6s %8s %8s %8s %10s %10s\n", "N", "hash", "batch", "combine",
+         "set", "set/comb");
+  run<32>();
+  run<64>();
+  run<256>();
+  run<1024>();
+  run<4096>();
+  return 0;
+}
@@ -0,0 +1,98 @@
+// Runtime comparison of the flat limb-array Bits<N> (mango/bits.h) and the
+// original recursive layout (bench/recursive_bits.h).
+//
+// The layout is picked at compile time so that compile time and code size can
+// be measured per layout as well, see bench/layout.sh (`make layout`):
+//
+//    c++ -std=c++23 -O2 -I. bench/layout.cc                 # flat
+//    c++ -std=c++23 -O2 -I. -DMANGO_RECURSIVE bench/layout.cc # recursive
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+#ifdef MANGO_RECURSIVE
+#include "bench/recursive_bits.h"
+namespace impl = mango::recursive;
+constexpr const char *layout = "recursive";
+#else
+#include "mango/bits.h"
+namespace impl = mango;
+constexpr const char *layout = "flat";
+#endif
+
+template <uint16_t N> using B = impl::Bits<N>;
+
+template <typename T> inline void keep(const T &v) {
+  asm volatile("" : : "g"(&v) : "memory");
+}
+
+// one out-of-line function per (operation, width) so each shows up as its own
+// symbol in `objdump -d`
+
+template <uint16_t N>
+[[gnu::noinline]] auto op_add(const B<N> &a, const B<N> &b) {
+  return a + b;
+}
+
+template <uint16_t N>
+[[gnu::noinline]] auto op_sub(const B<N> &a, const B<N> &b) {
+  return a - b;
+}
+
+template <uint16_t N>
+[[gnu::noinline]] auto op_cmp(const B<N> &a, const B<N> &b) {
+  return a.cmp(b);
+}
+
+template <uint16_t N> [[gnu::noinline]] auto op_not(const B<N> &a) {
+  return ~a;
+}
+
+template <uint16_t N> [[gnu::noinline]] auto op_shr(const B<N> &a) {
+  return a.template shr<N / 2 + 3>();
+}
+
+template <uint16_t N>
+[[gnu::noinline]] auto op_concat(const B<N> &a, const B<N> &b) {
+  return a.concat(b);
+}
+
+template <typename F> double time_ns(F f) {
+  constexpr int reps = 20000;
+  const auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < reps; i++) {
+    f();
+  }
+  const auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double, std::nano>(end - start).count() / reps;
+}
+
+template <uint16_t N> void run() {
+  const B<N> a = ~B<N>{0};
+  const B<N> b{B<N - 64>{0x1234}, 0x5678};
+
+  const double add = time_ns([&] { keep(op_add<N>(a, b)); });
+  const double sub = time_ns([&] { keep(op_sub<N>(a, b)); });
+  const double cmp = time_ns([&] { keep(op_cmp<N>(a, b)); });
+  const double inv = time_ns([&] { keep(op_not<N>(a)); });
+  const double shr = time_ns([&] { keep(op_shr<N>(a)); });
+  const double cat = time_ns([&] { keep(op_concat<N>(a, b)); });
+
+  printf("%-9s %5u %8.1f %8.1f %8.1f %8.1f %8.1f %8.1f\n", layout, N, add,
+         sub, cmp, inv, shr, cat);
+}
+
+int main() {
+  printf("%-9s %5s %8s %8s %8s %8s %8s %8s   (ns/op)\n", "layout", "width",
+         "add", "sub", "cmp", "~", "shr", "concat");
+  run<64>();
+  run<128>();
+  run<256>();
+  run<512>();
+  run<1024>();
+  run<2048>();
+  run<4096>();
+  run<8192>();
+  return 0;
+}
@@ -0,0 +1,33 @@
+#!/bin/bash
+#
+# Compile bench/layout.cc once per Bits<N> layout and report compile time,
+# generated code size and runtime.
+#
+# usage: bench/layout.sh [compiler] [output directory]
+
+set -e
+
+CXX=${1:-c++}
+OUT=${2:-build/layout}
+FLAGS="-std=c++23 -O2 -I."
+
+mkdir -p "${OUT}"
+
+for layout in flat recursive; do
+  if [ "${layout}" = recursive ]; then
+    DEFS="-DMANGO_RECURSIVE"
+  else
+    DEFS=""
+  fi
+
+  start=$(date +%s.%N)
+  ${CXX} ${FLAGS} ${DEFS} bench/layout.cc -o "${OUT}/layout_${layout}"
+  end=$(date +%s.%N)
+
+  insns=$(objdump -d --no-show-raw-insn "${OUT}/layout_${layout}" |
+    grep -c '^ *[0-9a-f]*:')
+
+  secs=$(awk "BEGIN { printf \"%.2f\", ${end} - ${start} }")
+  echo "== ${layout}: compile ${secs}s, ${insns} instructions"
+  "${OUT}/layout_${layout}"
+done
@@ -0,0 +1,101 @@
+// Modular multiplication with ModBits<M> (Montgomery and Barrett) against
+// the generic (a * b) % m through Knuth division, for a 256-bit prime and an
+// odd 1024-bit modulus, in cycles per multiplication (ns when there is no
+// cycle counter). Each step depends on the previous one, like in pow.
+//
+//    c++ -std=c++23 -O3 -march=native -I. bench/mod_bits.cc  # make mod
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+#include "mango/mod_bits.h"
+
+#if defined(__x86_64__)
+#include <x86intrin.h>
+constexpr const char *unit = "cycles";
+inline uint64_t ticks() { return __rdtsc(); }
+#else
+constexpr const char *unit = "ns";
+inline uint64_t ticks() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+#endif
+
+using namespace mango;
+
+constexpr int count = 1 << 14;
+
+template <typename T> inline void keep(const T &v) {
+  asm volatile("" : : "g"(&v) : "memory");
+}
+
+// the best of a few runs, this is a noisy measurement
+template <typename F> double per_op(F f) {
+  double best = 0;
+  for (int k = 0; k < 5; k++) {
+    const uint64_t start = ticks();
+    f();
+    const double t = double(ticks() - start) / count;
+    best = (k == 0 || t < best) ? t : best;
+  }
+  return best;
+}
+
+template <uint16_t L> constexpr std::array<uint64_t, L> limbs(uint64_t s) {
+  std::array<uint64_t, L> out{};
+  for (auto &v : out) {
+    s = s * 6364136223846793005ULL + 1442695040888963407ULL;
+    v = s ^ (s >> 29);
+  }
+  out[0] |= 1;
+  return out;
+}
+
+template <typename M> void run(const char *name) {
+  using Mont = ModBits<M, ModReduction::MONTGOMERY>;
+  using Barrett = ModBits<M, ModReduction::BARRETT>;
+  constexpr uint16_t W = Mont::WIDTH;
+  const Bits<W> m = Mont::MODULUS;
+  const Bits<W> a{Bits<W>{limbs<Bits<W>::LIMBS>(1)} % m};
+  const Bits<W> b{Bits<W>{limbs<Bits<W>::LIMBS>(2)} % m};
+
+  const double generic = per_op([&] {
+    Bits<W> x = a;
+    for (int i = 0; i < count; i++) {
+      x = Bits<W>{(x * b) % m};
+    }
+    keep(x);
+  });
+  const auto modular = [&](auto zero) {
+    using F = decltype(zero);
+    return per_op([&] {
+      F x{a};
+      const F y{b};
+      for (int i = 0; i < count; i++) {
+        x = x * y;
+      }
+      keep(x);
+    });
+  };
+  const double mont = modular(Mont{});
+  const double barrett = modular(Barrett{});
+
+  printf("%-10s %6u %10.1f %10.1f %10.1f\n", name, unsigned(W), generic,
+         mont, barrett);
+}
+
+constexpr auto m1024 = limbs<16>(3);
+
+int main() {
+  printf("%s per a * b mod m\n", unit);
+  printf("%-10s %6s %10s %10s %10s\n", "modulus", "bits", "(a*b)%m",
+         "Montgomery", "Barrett");
+  run<Nat<0xfffffffefffffc2f, ~0ULL, ~0ULL, ~0ULL>>("secp256k1");
+  run<Nat<0xffffffffffffffed, ~0ULL, ~0ULL, 0x7fffffffffffffff>>("2^255-19");
+  run<decltype(to_nat<m1024>())>("random");
+  return 0;
+}
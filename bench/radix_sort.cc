@@ -0,0 +1,90 @@
+// Sorting spans of Bits<N> and Int keys: std::sort with cmp against
+// mango::radix_sort on one thread and on every hardware thread, in ms for
+// the whole span. The count defaults to 4M keys:
+//
+//    c++ -std=c++23 -O3 -march=native -pthread -I. bench/radix_sort.cc
+//    ./a.out 100000000               # make radix RADIX_COUNT=100000000
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mango/radix_sort.h"
+
+using namespace mango;
+
+template <typename F> double ms(F f) {
+  const auto start = std::chrono::steady_clock::now();
+  f();
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+// the Bits<N> that radix_sort orders K by
+template <typename K>
+using KeyBits = std::remove_cvref_t<decltype(radix_bits(std::declval<K>()))>;
+
+template <typename K> K element(uint64_t s) {
+  typename KeyBits<K>::Limbs limbs{};
+  for (auto &v : limbs) {
+    s = s * 6364136223846793005ULL + 1442695040888963407ULL;
+    v = s ^ (s >> 29);
+  }
+  if constexpr (std::is_same_v<K, KeyBits<K>>) {
+    return K{limbs};
+  } else {
+    K x;
+    x.biased_bits = KeyBits<K>{limbs[0] % 1000000};
+    return x;
+  }
+}
+
+template <typename K>
+void run(const char *name, const size_t count, const unsigned threads) {
+  std::vector<K> keys;
+  for (size_t j = 0; j < count; j++) {
+    keys.push_back(element<K>(j));
+  }
+
+  auto a = keys;
+  const double std_sort = ms([&] {
+    std::sort(a.begin(), a.end(), [](const K &x, const K &y) {
+      return x.cmp(y) == Cmp::LT;
+    });
+  });
+  auto b = keys;
+  const double radix = ms([&] { radix_sort(std::span{b}); });
+  auto c = keys;
+  const double parallel = ms([&] { radix_sort(std::span{c}, threads); });
+
+  for (size_t j = 0; j < count; j++) {
+    if (!(radix_bits(a[j]) == radix_bits(b[j])) ||
+        !(radix_bits(a[j]) == radix_bits(c[j]))) {
+      printf("%s: wrong order at %zu\n", name, j);
+      exit(1);
+    }
+  }
+  printf("%-12s %10.1f %10.1f %10.1f\n", name, std_sort, radix, parallel);
+}
+
+int main(int argc, const char *argv[]) {
+  const size_t count = (argc > 1) ? strtoull(argv[1], nullptr, 10) : 4 << 20;
+  const unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+  printf("%zu keys, ms\n", count);
+  printf("%-12s %10s %10s %7s x%-2u\n", "key", "std::sort", "radix", "radix",
+         threads);
+  run<Bits<32>>("Bits<32>", count, threads);
+  run<Bits<64>>("Bits<64>", count, threads);
+  run<Int<Nat<0>, Nat<999999>>>("Int<0,1e6>", count, threads);
+  run<Bits<128>>("Bits<128>", count, threads);
+  run<Bits<256>>("Bits<256>", count, threads);
+  return 0;
+}
@@ -1,7 +1,11 @@
 #include <mango/bits.h>
+#include <mango/bits_view.h>
+#include <mango/hash.h>
 #include <mango/int.h>
 #include <mango/masked_bits.h>
+#include <mango/mod_bits.h>
 #include <mango/nat.h>
+#include <mango/packed_record.h>
 
 using namespace mango;
 
@@ -11,10 +15,88 @@ auto add(const Bits<7> &a, const Bits<12> &b) { return a + b; }
 
 auto add(const Bits<66> &a, const Bits<61> &b) { return a + b; }
 
+auto add(const Bits<256> &a, const Bits<256> &b) { return a + b; }
+
+auto sign_extend(const Bits<32> a) { return a.sign_extend<65>(); }
+
+auto sub(const Bits<256> &a, const Bits<256> &b) { return a - b; }
+
+auto add_wrap(const Bits<256> &a, const Bits<256> &b) { return a.add_wrap(b); }
+
+auto sub_wrap(const Bits<100> &a, const Bits<100> &b) { return a.sub_wrap(b); }
+
+auto mul(const Bits<64> &a, const Bits<64> &b) { return a * b; }
+
+auto mul(const Bits<128> &a, const Bits<128> &b) { return a * b; }
+
+auto mul_wrap(const Bits<128> &a, const Bits<128> &b) { return a.mul_wrap(b); }
+
+auto mul(const SignedInt<8> a, const SignedInt<8> b) noexcept { return a * b; }
+
+auto div(const Bits<256> &a, const Bits<128> &b) { return a / b; }
+
+auto div10(const Bits<64> &a) { return a / Nat<10>{}; }
+
+auto mod10(const Bits<64> &a) { return a % Nat<10>{}; }
+
+auto shl(const Bits<256> &a, const Int<Nat<>, Nat<255>> s) { return a.shl(s); }
+
+auto rotr(const Bits<256> &a, const Int<Nat<>, Nat<255>> s) {
+  return a.rotr(s);
+}
+
+auto bit_and(const Bits<512> &a, const Bits<512> &b) { return a & b; }
+
+auto bit_xor(const Bits<1024> &a, const Bits<300> &b) { return a ^ b; }
+
+auto andnot(const Bits<256> &a, const Bits<256> &b) { return a.andnot(b); }
+
+auto popcount(const Bits<4096> &a) { return mango::popcount(a); }
+
+auto countl_zero(const Bits<256> &a) { return mango::countl_zero(a); }
+
 auto add(const UnsignedInt<12> a, const UnsignedInt<5> b) noexcept {
   return a + b;
 }
 
+auto sub(const UnsignedInt<64> a, const UnsignedInt<64> b) noexcept {
+  return a - b;
+}
+
+auto maximum(const SignedInt<32> a, const SignedInt<32> b) noexcept {
+  return mango::max(a, b);
+}
+
+auto clamp(const Int<Neg<1000>, Nat<100000>> x) noexcept {
+  return x.clamp<Nat<>, Nat<255>>();
+}
+
+auto saturate(const SignedInt<64> x) noexcept {
+  return x.saturate_signed<16>();
+}
+
+using Row = PackedRecord<Field<"kind", Bits<3>>, Field<"delta", SignedInt<12>>,
+                         Field<"count", UnsignedInt<20>>>;
+
+auto row_delta(const Bits<Row::WIDTH> b) noexcept {
+  return Row{b, true}.get<"delta">();
+}
+
+auto row_set_count(const Bits<Row::WIDTH> b,
+                   const UnsignedInt<20> c) noexcept {
+  Row r{b, true};
+  r.set<"count">(c);
+  return r.bits;
+}
+
+auto load_be32(const std::byte *p) {
+  return BitsView<32, std::endian::big>{std::span{p, 4}}.load();
+}
+
+auto load_le64(const std::byte *p) {
+  return BitsView<64>{std::span{p, 9}, 3}.load();
+}
+
 auto flip_bit(const Bits<129> b) noexcept { return b.flip_bit<128>(); }
 
 auto shr(const Nat<0x12345678, 0xf0f0f0f0f0> x) noexcept {
@@ -36,3 +118,35 @@ template auto adc<MaskedBits<32, Nat<0x80000000>, Nat<0x80000000>>>(
     const MaskedBits<32, Nat<0x80000000>, Nat<0x80000000>> ins);
 template auto adc<MaskedBits<32, Nat<0x80000000>, Nat<0x00000000>>>(
     const MaskedBits<32, Nat<0x80000000>, Nat<0x00000000>> ins);
+
+using P127 = ModBits<Nat<~0ULL, 0x7fffffffffffffff>>;
+
+auto mod_add(const P127 &a, const P127 &b) noexcept { return a + b; }
+
+auto mod_mul(const P127 &a, const P127 &b) noexcept { return a * b; }
+
+auto add_one(const Bits<256> &a) noexcept { return a + Nat<1>{}; }
+
+auto mul_2_200(const Bits<256> &a) noexcept { return a * Nat<0, 0, 0, 256>{}; }
+
+auto cmp_wide(const Bits<64> &a) noexcept { return a.cmp(Nat<0, 1>{}); }
+
+auto eq_const(const Bits<256> &a) noexcept { return a == Nat<5, 0, 7>{}; }
+
+auto lt_wide(const Bits<256> &a, const Bits<256> &b) noexcept { return a < b; }
+
+auto lt_signed(const Bits<256> &a, const Bits<256> &b) noexcept {
+  return a.cmp_signed(b) == Cmp::LT;
+}
+
+auto eq_wide(const Bits<1024> &a, const Bits<1024> &b) noexcept {
+  return a == b;
+}
+
+auto hash_64(const Bits<64> &a) noexcept { return hash(a); }
+
+auto hash_256(const Bits<256> &a, const uint64_t seed) noexcept {
+  return hash(a, seed);
+}
+
+auto hash_1024(const Bits<1024> &a) noexcept { return hash(a); }
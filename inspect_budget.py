@@ -0,0 +1,125 @@
+#!/usr/bin/env python3
+"""Check the code generated for inspect.cc against per-function budgets.
+
+usage: inspect_budget.py <objdump> <budget file> <object or archive>...
+
+Every function in the objects is disassembled and measured:
+
+    insns     instructions, alignment padding excluded
+    branches  conditional and unconditional jumps
+    calls     call instructions
+    spills    stores to the stack frame (push, mov to (%rsp)/(%rbp))
+
+The budget file has one line per function: the demangled signature with
+`mango::` and the `(unsigned short)` / `(unsigned long)` casts of template
+arguments dropped, followed by the four limits (`*` for no limit). Lines
+starting with `#` are comments. The check fails when a function exceeds its
+budget or a budgeted function is missing. Only x86-64 objects are measured,
+other targets report the test as skipped.
+"""
+
+import re
+import subprocess
+import sys
+
+SKIP = 77  # meson's exit code for skipped tests
+
+METRICS = ("insns", "branches", "calls", "spills")
+
+FUNCTION = re.compile(r"^[0-9a-f]+ <(.*)>:$")
+INSTRUCTION = re.compile(r"^\s+[0-9a-f]+:\s+(\S+)\s*(.*)$")
+STACK_DEST = re.compile(r",\s*-?(0x[0-9a-f]+|\d+)?\(%r[sb]p(,[^)]*)?\)\s*$")
+
+
+def normalize(name):
+    name = name.replace("mango::", "")
+    name = re.sub(r"\(unsigned (short|long)\)", "", name)
+    name = re.sub(r"(\d+)ul\b", r"\1", name)
+    return name
+
+
+def is_x86_64(objdump, path):
+    out = subprocess.run([objdump, "-f", path], capture_output=True, text=True,
+                         check=True).stdout
+    return "x86-64" in out
+
+
+def measure(objdump, paths):
+    functions = {}
+    current = None
+    for path in paths:
+        out = subprocess.run([objdump, "-d", "-C", "--no-show-raw-insn", path],
+                             capture_output=True, text=True, check=True).stdout
+        for line in out.splitlines():
+            m = FUNCTION.match(line)
+            if m:
+                current = functions.setdefault(normalize(m.group(1)),
+                                               dict.fromkeys(METRICS, 0))
+                continue
+            m = INSTRUCTION.match(line)
+            if not m or current is None:
+                continue
+            mnemonic, operands = m.groups()
+            if "nop" in mnemonic or "nop" in operands:
+                continue
+            current["insns"] += 1
+            if mnemonic.startswith("j"):
+                current["branches"] += 1
+            elif mnemonic.startswith("call"):
+                current["calls"] += 1
+            elif mnemonic.startswith("push") or (
+                    mnemonic.startswith("mov") and STACK_DEST.search(operands)):
+                current["spills"] += 1
+    return functions
+
+
+def read_budgets(path):
+    budgets = {}
+    with open(path) as f:
+        for n, line in enumerate(f, 1):
+            line = line.strip()
+            if not line or line.startswith("#"):
+                continue
+            fields = line.rsplit(None, len(METRICS))
+            if len(fields) != len(METRICS) + 1:
+                sys.exit(f"{path}:{n}: expected a name and {len(METRICS)} limits")
+            name, limits = fields[0], fields[1:]
+            budgets[name] = {
+                k: None if v == "*" else int(v) for k, v in zip(METRICS, limits)
+            }
+    return budgets
+
+
+def main():
+    if len(sys.argv) < 4:
+        sys.exit(__doc__)
+    objdump, budget_file, paths = sys.argv[1], sys.argv[2], sys.argv[3:]
+
+    if not all(is_x86_64(objdump, p) for p in paths):
+        print("not an x86-64 target, skipping")
+        return SKIP
+
+    functions = measure(objdump, paths)
+    budgets = read_budgets(budget_file)
+
+    failed = False
+    print(f"{'insns':>6} {'branch':>6} {'calls':>6} {'spills':>6}  function")
+    for name, got in sorted(functions.items()):
+        budget = budgets.get(name)
+        over = [k for k in METRICS
+                if budget and budget[k] is not None and got[k] > budget[k]]
+        mark = "  OVER BUDGET: " + ", ".join(
+            f"{k} {got[k]} > {budget[k]}" for k in over) if over else ""
+        print(" ".join(f"{got[k]:6}" for k in METRICS) + f"  {name}{mark}")
+        failed |= bool(over)
+
+    for name in budgets:
+        if name not in functions:
+            print(f"missing budgeted function: {name}")
+            failed = True
+
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
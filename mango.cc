@@ -1,11 +1,24 @@
 
 
+#include <algorithm>
 #include <iostream>
+#include <numeric>
+#include <sstream>
+#include <unordered_map>
+#include <unordered_set>
 
 #include "mango/bits.h"
+#include "mango/bits_vector.h"
+#include "mango/bits_view.h"
+#include "mango/decoder.h"
+#include "mango/dyn_bits.h"
+#include "mango/hash.h"
 #include "mango/int.h"
 #include "mango/masked_bits.h"
+#include "mango/mod_bits.h"
 #include "mango/nat.h"
+#include "mango/packed_record.h"
+#include "mango/radix_sort.h"
 #include <gtest/gtest.h>
 
 #include "inspect.cc"
@@ -14,20 +27,30 @@ using namespace mango;
 
 auto biso(const Bits<32> x) { return x.sign_extend<65>(); }
 
+template <uint16_t L>
+constexpr std::array<uint64_t, L> pseudo_random_limbs(uint64_t s) {
+  std::array<uint64_t, L> out{};
+  for (auto &v : out) {
+    s = s * 6364136223846793005ULL + 1442695040888963407ULL;
+    v = s ^ (s >> 29);
+  }
+  return out;
+}
+
 TEST(Bits, Simple) {
   const Bits<3> x{5};
   const Bits<64> y{77};
   const Bits<1000> big{x};
 
-  EXPECT_EQ(x.low, 5);
-  EXPECT_EQ(y.low, 77);
-  EXPECT_EQ(big.low, 5);
+  EXPECT_EQ(x.get_low(), 5);
+  EXPECT_EQ(y.get_low(), 77);
+  EXPECT_EQ(big.get_low(), 5);
 
   EXPECT_EQ(big.WIDTH, 1000);
 
   const auto c = x.concat(x);
   EXPECT_EQ(c.WIDTH, 6);
-  EXPECT_EQ(c.low, 0b101101);
+  EXPECT_EQ(c.get_low(), 0b101101);
 }
 
 TEST(Bits, DefaultConstructor) {
@@ -44,19 +67,19 @@ TEST(Bits, Constructor) {
     EXPECT_EQ(n.WIDTH, 2);
     EXPECT_EQ(n.SLACK, 62);
     EXPECT_EQ(n.MASK, 0x3);
-    EXPECT_EQ(n.high, Bits<0>{});
-    EXPECT_EQ(n.low, 1);
+    EXPECT_EQ(n.get_high(), Bits<0>{});
+    EXPECT_EQ(n.get_low(), 1);
   }
 
   Bits<7> n{5};
   EXPECT_EQ(n.WIDTH, 7);
   EXPECT_EQ(n.SLACK, 57);
   EXPECT_EQ(n.MASK, 0x7f);
-  EXPECT_EQ(n.high, Bits<0>{});
-  EXPECT_EQ(n.low, 5);
+  EXPECT_EQ(n.get_high(), Bits<0>{});
+  EXPECT_EQ(n.get_low(), 5);
 
   Bits<100> n2{17};
-  EXPECT_EQ(n2.low, 17);
+  EXPECT_EQ(n2.get_low(), 17);
   EXPECT_EQ(n2.WIDTH, 100);
   EXPECT_EQ(n2.SLACK, 0);
   EXPECT_EQ(n2.MASK, ~uint64_t{0});
@@ -64,7 +87,7 @@ TEST(Bits, Constructor) {
   EXPECT_EQ(h.WIDTH, 36);
   EXPECT_EQ(h.SLACK, 28);
   EXPECT_EQ(h.MASK, uint64_t{0xfffffffff});
-  EXPECT_EQ(h.low, 0);
+  EXPECT_EQ(h.get_low(), 0);
 }
 
 TEST(Bits, add) {
@@ -99,6 +122,25 @@ TEST(Bits, add) {
   }
 }
 
+TEST(Bits, add_carry) {
+  // the rhs limb and the incoming carry both overflow
+  const auto a = Bits<64>{5}.add<64, 1>(~Bits<64>{0});
+  EXPECT_EQ(a.WIDTH, 65);
+  EXPECT_EQ(a.get(0), 5);
+  EXPECT_EQ(a.get(1), 1);
+
+  const auto ones = ~Bits<128>{0};
+  const auto b = ones + ones;
+  EXPECT_EQ(b.WIDTH, 129);
+  EXPECT_EQ(b.get(0), ~uint64_t(1));
+  EXPECT_EQ(b.get(1), UINT64_MAX);
+  EXPECT_EQ(b.get(2), 1);
+
+  constexpr auto c = ~Bits<130>{0} + ~Bits<130>{0};
+  static_assert(c.get(0) == ~uint64_t(1));
+  static_assert(c.get(2) == 7);
+}
+
 TEST(Bits, concat) {
   const Bits<65> a{1};
   auto b = a.concat(a);
@@ -115,6 +157,57 @@ TEST(Bits, shr) {
   EXPECT_EQ(b.get(0), 1);
 }
 
+template <uint16_t N> bool bit(const Bits<N> &x, const uint64_t k) {
+  return (k < N) && (((x.get(k / 64) >> (k % 64)) & 1) == 1);
+}
+
+TEST(Bits, shl) {
+  const Bits<66> a{2, 77};
+  const auto b = a.shl<63>();
+  EXPECT_EQ(b.WIDTH, 129);
+  EXPECT_EQ(b.get(0), uint64_t(1) << 63);
+  EXPECT_EQ(b.get(1), 77 >> 1);
+  EXPECT_EQ(b.get(2), 1);
+  EXPECT_EQ(b.shr<63>(), a);
+  EXPECT_EQ(Bits<3>{5}.shl<128>().get(2), 5);
+  EXPECT_EQ(Bits<0>{}.shl<5>().WIDTH, 5);
+}
+
+TEST(Bits, shift_runtime) {
+  const Bits<130> x{pseudo_random_limbs<3>(11)};
+  for (uint64_t s = 0; s < 130; s++) {
+    const Int<Nat<>, Nat<129>> amount{Bits<8>{s}, true};
+    const auto l = x.shl(amount);
+    const auto r = x.shr(amount);
+    const auto rl = x.rotl(amount);
+    const auto rr = x.rotr(amount);
+    EXPECT_EQ(l.WIDTH, 259);
+    for (uint64_t k = 0; k < 259; k++) {
+      EXPECT_EQ(bit(l, k), (k >= s) && bit(x, k - s)) << s << " " << k;
+    }
+    for (uint64_t k = 0; k < 130; k++) {
+      EXPECT_EQ(bit(r, k), bit(x, k + s)) << s << " " << k;
+      EXPECT_EQ(bit(rr, k), bit(x, (k + s) % 130)) << s << " " << k;
+      EXPECT_EQ(bit(rl, k), bit(x, (k + 130 - s) % 130)) << s << " " << k;
+    }
+  }
+
+  const Bits<128> y{pseudo_random_limbs<2>(12)};
+  for (uint64_t s = 0; s < 128; s++) {
+    const auto rr = y.rotr(Int<Nat<>, Nat<127>>{Bits<7>{s}, true});
+    for (uint64_t k = 0; k < 128; k++) {
+      EXPECT_EQ(bit(rr, k), bit(y, (k + s) % 128)) << s << " " << k;
+    }
+  }
+
+  const auto z = Bits<5>{0b10011};
+  EXPECT_EQ(z.rotr<1>(), Bits<5>{0b11001});
+  EXPECT_EQ(z.rotl<2>(), Bits<5>{0b01110});
+  EXPECT_EQ((z.shl(Int<Nat<1>, Nat<3>>{Nat<3>{}})), Bits<8>{0b10011000});
+  EXPECT_EQ((z.shr(Int<Nat<1>, Nat<3>>{Nat<3>{}})), Bits<5>{0b10});
+  EXPECT_EQ((~Bits<64>{0}).rotl<4>(), ~Bits<64>{0});
+}
+
 TEST(Bits, extract) {
   const Bits<66> a{2, 77};
   const auto b = a.extract<65, 63>();
@@ -162,7 +255,7 @@ TEST(Bits, sub) {
       auto diff = Bits<2>{i} - Bits<2>{j};
       EXPECT_EQ(diff.WIDTH, 3);
 
-      EXPECT_EQ(int32_t(diff.sign_extend<64>().low), i - j);
+      EXPECT_EQ(int32_t(diff.sign_extend<64>().get_low()), i - j);
     }
   }
 
@@ -179,6 +272,402 @@ TEST(Bits, sub) {
   EXPECT_EQ(z2.get(2), 0);
 }
 
+TEST(Bits, sub_borrow) {
+  const auto a = Bits<128>{Bits<64>{1}, 0} - Bits<128>{1};
+  EXPECT_EQ(a.WIDTH, 129);
+  EXPECT_EQ(a.get(0), UINT64_MAX);
+  EXPECT_EQ(a.get(1), 0);
+  EXPECT_EQ(a.get(2), 0);
+
+  // (-1) - (2^127 - 1) with both operands read as two's complement
+  const auto b = ~Bits<128>{0} - Bits<128>{~Bits<127>{0}};
+  EXPECT_EQ(b.get(0), 0);
+  EXPECT_EQ(b.get(1), uint64_t(1) << 63);
+  EXPECT_EQ(b.get(2), 1);
+
+  constexpr auto c = Bits<3>{1} - Bits<200>{2};
+  static_assert(c.get(0) == UINT64_MAX);
+  static_assert(c.get(3) == 0x1ff);
+}
+
+TEST(Bits, mul) {
+  EXPECT_EQ((Bits<0>{} * Bits<7>{3}).WIDTH, 7);
+  EXPECT_EQ((Bits<3>{5} * Bits<4>{9}), Bits<7>{45});
+
+  const auto ones = ~Bits<64>{0};
+  const auto sq = ones * ones;
+  EXPECT_EQ(sq.WIDTH, 128);
+  EXPECT_EQ(sq.get(0), 1);
+  EXPECT_EQ(sq.get(1), ~uint64_t(1));
+
+  // (2^130 - 1) * 3 = 2^131 + 2^130 - 3
+  const auto p = ~Bits<130>{0} * Bits<2>{3};
+  EXPECT_EQ(p.WIDTH, 132);
+  EXPECT_EQ(p.get(0), ~uint64_t(2));
+  EXPECT_EQ(p.get(1), UINT64_MAX);
+  EXPECT_EQ(p.get(2), 0xb);
+
+  constexpr auto c = Bits<70>{Bits<6>{1}, 2} * Bits<70>{Bits<6>{3}, 4};
+  static_assert(c.get(0) == 8);
+  static_assert(c.get(1) == 10);
+  static_assert(c.get(2) == 3);
+}
+
+template <uint16_t LA, uint16_t LB> void check_mul_limbs() {
+  const auto a = pseudo_random_limbs<LA>(LA);
+  const auto b = pseudo_random_limbs<LB>(LB + 1);
+  std::array<uint64_t, LA + LB> expected{};
+  std::array<uint64_t, LA + LB> product{};
+  mul_schoolbook<LA, LB>(a.data(), b.data(), expected.data());
+  mul_limbs<LA, LB>(a.data(), b.data(), product.data());
+  EXPECT_EQ(product, expected) << LA << " x " << LB;
+}
+
+TEST(Bits, mul_karatsuba) {
+  constexpr uint16_t L = 2 * KARATSUBA_LIMBS + 3;
+  const Bits<64 * L> a{pseudo_random_limbs<L>(1)};
+  const Bits<64 * L> b{pseudo_random_limbs<L>(2)};
+  const Bits<64 * (L - 5)> c{pseudo_random_limbs<L - 5>(3)};
+
+  std::array<uint64_t, 2 * L> expected{};
+  mul_schoolbook<L, L>(a.limbs, b.limbs, expected.data());
+  const auto ab = a * b;
+  for (uint16_t i = 0; i < 2 * L; i++) {
+    EXPECT_EQ(ab.get(i), expected[i]);
+  }
+
+  mul_schoolbook<L, L - 5>(a.limbs, c.limbs, expected.data());
+  const auto ac = a * c;
+  for (uint16_t i = 0; i < 2 * L - 5; i++) {
+    EXPECT_EQ(ac.get(i), expected[i]);
+  }
+
+  const auto ones = ~Bits<64 * L>{0};
+  const auto sq = ones * ones;
+  EXPECT_EQ(sq.get(0), 1);
+  EXPECT_EQ(sq.get(L - 1), 0);
+  EXPECT_EQ(sq.get(L), ~uint64_t(1));
+  EXPECT_EQ(sq.get(2 * L - 1), UINT64_MAX);
+
+  // unbalanced operands are multiplied block by block
+  check_mul_limbs<32, 128>();
+  check_mul_limbs<128, 32>();
+  check_mul_limbs<40, 100>();
+  check_mul_limbs<70, 33>();
+  check_mul_limbs<33, 32>();
+}
+
+TEST(Bits, mul_add) {
+  const auto ones = ~Bits<64>{0};
+  const auto a = ones.mul_add(ones, ones);
+  EXPECT_EQ(a.WIDTH, 128);
+  EXPECT_EQ(a.get(0), 0);
+  EXPECT_EQ(a.get(1), UINT64_MAX);
+
+  const auto b = Bits<4>{3}.mul_add(Bits<4>{5}, ~Bits<100>{0});
+  EXPECT_EQ(b.WIDTH, 101);
+  EXPECT_EQ(b.get(0), 14);
+  EXPECT_EQ(b.get(1), 1ULL << 36);
+
+  EXPECT_EQ(Bits<0>{}.mul_add(Bits<3>{7}, Bits<5>{9}), Bits<5>{9});
+}
+
+template <uint16_t N, uint16_t M> void check_wrap(const uint64_t seed) {
+  const Bits<N> a{pseudo_random_limbs<Bits<N>::LIMBS>(seed)};
+  const Bits<M> b{pseudo_random_limbs<Bits<M>::LIMBS>(seed + 1)};
+  EXPECT_EQ(a.add_wrap(b), (a + b).template trim<N>());
+  EXPECT_EQ(a.sub_wrap(b), (a - b).template trim<N>());
+  EXPECT_EQ(a.mul_wrap(b), (a * b).template trim<N>());
+}
+
+TEST(Bits, wrap) {
+  EXPECT_EQ(Bits<8>{250}.add_wrap(Bits<8>{10}), Bits<8>{4});
+  EXPECT_EQ(Bits<8>{3}.sub_wrap(Bits<8>{5}), Bits<8>{254});
+  EXPECT_EQ(Bits<8>{16}.mul_wrap(Bits<8>{17}), Bits<8>{16});
+  // a narrower rhs is sign extended by sub_wrap, like by operator-
+  EXPECT_EQ(Bits<8>{0}.sub_wrap(Bits<4>{15}), Bits<8>{1});
+  EXPECT_EQ(Bits<8>{7}.add_wrap(Bits<0>{}), Bits<8>{7});
+
+  // acc = acc op x keeps its type
+  Bits<64> acc{1};
+  uint64_t ref = 1;
+  for (uint64_t i = 1; i < 100; i++) {
+    const uint64_t x = i * 0x9e3779b97f4a7c15ULL;
+    acc = acc.mul_wrap(Bits<64>{x}).add_wrap(Bits<64>{i}).sub_wrap(
+        Bits<64>{x >> 3});
+    ref = ref * x + i - (x >> 3);
+  }
+  EXPECT_EQ(acc, Bits<64>{ref});
+
+  constexpr auto c = Bits<130>{~uint64_t(0)}.mul_wrap(Bits<130>{3});
+  static_assert(c.WIDTH == 130);
+  EXPECT_EQ(c.get(1), 2);
+
+  check_wrap<1, 1>(1);
+  check_wrap<63, 64>(2);
+  check_wrap<65, 63>(3);
+  check_wrap<128, 128>(4);
+  check_wrap<200, 130>(5);
+  check_wrap<130, 200>(6);
+  check_wrap<2048, 2048>(7);
+}
+
+TEST(Bits, div) {
+  EXPECT_EQ(Bits<8>{200} / Bits<4>{7}, Bits<8>{28});
+  EXPECT_EQ(Bits<8>{200} % Bits<4>{7}, Bits<4>{4});
+  EXPECT_EQ((Bits<8>{200} % Bits<4>{7}).WIDTH, 4);
+
+  // (2^192 - 1) / (2^64 + 1) = 2^128 - 2^64, remainder 2^64 - 1
+  const auto ones = ~Bits<192>{0};
+  const Bits<65> d{Bits<1>{1}, 1};
+  const auto [q, r] = ones.divmod(d);
+  EXPECT_EQ(q.get(0), 0);
+  EXPECT_EQ(q.get(1), UINT64_MAX);
+  EXPECT_EQ(q.get(2), 0);
+  EXPECT_EQ(r.get(0), UINT64_MAX);
+  EXPECT_EQ(r.get(1), 0);
+
+  // single limb divisor
+  const auto [q1, r1] = ones.divmod(Bits<64>{10});
+  EXPECT_EQ(q1.get(2), UINT64_MAX / 10);
+  EXPECT_EQ(r1, Bits<4>{5});
+
+  // a * b + c recovered through division
+  constexpr uint16_t L = 9;
+  const Bits<64 * L> a{pseudo_random_limbs<L>(7)};
+  const Bits<64 * 4> b{pseudo_random_limbs<4>(8)};
+  const Bits<64 * 3> c{pseudo_random_limbs<3>(9)};
+  const auto [qq, rr] = a.mul_add(b, c).divmod(b);
+  EXPECT_EQ(qq.template trim<64 * L>(), a);
+  EXPECT_EQ(rr, c);
+
+  constexpr auto cq = Bits<130>{Bits<2>{3}, 0} / Bits<66>{Bits<2>{1}, 0};
+  static_assert(cq.get(0) == 3);
+}
+
+TEST(Bits, div_const) {
+  using R10 = Reciprocal<64, Nat<10>>;
+  EXPECT_EQ(R10::SHIFT, 67);
+  EXPECT_EQ(R10::MULTIPLIER_BITS, 64);
+  EXPECT_EQ(R10::multiplier.get(0), 0xCCCCCCCCCCCCCCCDULL);
+  using R7 = Reciprocal<64, Nat<7>>;
+  EXPECT_EQ(R7::MULTIPLIER_BITS, 65);
+
+  const auto x = ~Bits<64>{0};
+  EXPECT_EQ((x / Nat<10>{}).WIDTH, 61);
+  EXPECT_EQ((x / Nat<10>{}).get(0), UINT64_MAX / 10);
+  EXPECT_EQ((x % Nat<10>{}).WIDTH, 4);
+  EXPECT_EQ((x % Nat<10>{}).get(0), UINT64_MAX % 10);
+  EXPECT_EQ((x / Nat<4096>{}), x.shr<12>());
+  EXPECT_EQ((x % Nat<4096>{}), Bits<12>{0xfff});
+
+  for (const uint64_t v : {uint64_t(0), uint64_t(1), uint64_t(6), uint64_t(7),
+                           uint64_t(12345678901234567), UINT64_MAX - 1,
+                           UINT64_MAX}) {
+    EXPECT_EQ((Bits<64>{v} / Nat<7>{}).get(0), v / 7);
+    EXPECT_EQ((Bits<64>{v} % Nat<7>{}).get(0), v % 7);
+    EXPECT_EQ((Bits<64>{v} / Nat<1000000007>{}).get(0), v / 1000000007);
+    EXPECT_EQ((Bits<40>{v} / Nat<3>{}).get(0), (v & 0xffffffffff) / 3);
+  }
+
+  // wide dividend and a two limb divisor
+  const auto w = ~Bits<256>{0};
+  using D = Nat<5, 3>;
+  const auto [q, r] = w.divmod(to_bits(D{}));
+  EXPECT_EQ(w / D{}, q);
+  EXPECT_EQ(w % D{}, r);
+}
+
+template <uint16_t N, typename C> void check_constant(const uint64_t seed) {
+  const Bits<N> x{pseudo_random_limbs<Bits<N>::LIMBS>(seed)};
+  constexpr auto c = to_bits(C{});
+  constexpr uint16_t W = max<uint16_t>(N, c.WIDTH) + 1;
+  EXPECT_EQ(x + C{}, x + c);
+  EXPECT_EQ(x - C{}, x.template zero_extend<W>().sub_wrap(
+                        c.template zero_extend<W>()));
+  EXPECT_EQ(x + (-C{}), x - C{});
+  EXPECT_EQ(x - (-C{}), x + C{});
+  EXPECT_EQ(x * C{}, x * c);
+  EXPECT_EQ(x * (-C{}), Bits<N + c.WIDTH + 1>{}.sub_wrap(
+                           (x * c).template zero_extend<N + c.WIDTH + 1>()));
+  EXPECT_EQ(x.cmp(C{}), x.cmp(c));
+  EXPECT_EQ(x == C{}, x == c);
+  EXPECT_TRUE(c == C{});
+}
+
+TEST(Bits, constants) {
+  using P = Nat<0xffffffffffffffed, ~0ULL, ~0ULL, 0x7fffffffffffffff>;
+  EXPECT_EQ(Bits<8>{255} + Nat<1>{}, Bits<9>{256});
+  EXPECT_EQ(Bits<8>{3} - Nat<5>{}, Bits<9>{0x1fe});
+  EXPECT_EQ(Bits<8>{3} + Neg<5>{}, Bits<9>{0x1fe});
+  EXPECT_EQ(Bits<8>{200} * Nat<10>{}, Bits<12>{2000});
+  EXPECT_EQ(Bits<8>{3} * Neg<2>{}, Bits<11>{0x7fa});
+
+  // the largest magnitude, -(3 * 3) = -9 needs the sign bit above 4 bits
+  constexpr auto m = Bits<2>{3} * Neg<3>{};
+  static_assert(m.WIDTH == 5);
+  EXPECT_EQ(m, Bits<5>{0b10111});
+  EXPECT_TRUE(m.is_signed());
+  EXPECT_EQ((Bits<64>{~0ULL} * Neg<0, 1>{}).cmp_signed(Bits<1>{}), Cmp::LT);
+
+  // x - c takes x as unsigned, x - to_bits(c) sign extends both sides
+  for (uint64_t v = 0; v < 16; v++) {
+    const Bits<4> y{v};
+    EXPECT_EQ(y - Nat<1>{}, y.zero_extend<5>().sub_wrap(Bits<5>{1}));
+    EXPECT_EQ(y - Nat<1>{},
+              (y.zero_extend<5>() - to_bits(Nat<1>{}).zero_extend<2>())
+                  .trim<5>());
+    EXPECT_EQ(y + Neg<9>{},
+              (y.zero_extend<5>() - to_bits(Nat<9>{}).zero_extend<5>())
+                  .trim<5>());
+  }
+  EXPECT_EQ(Bits<4>{0} - Nat<1>{}, Bits<5>{0x1f});
+  EXPECT_EQ(Bits<4>{0} - to_bits(Nat<1>{}), Bits<5>{0x01});
+
+  // non-adjacent form: 2^255 - 19 = 2^255 - 2^4 - 2^2 + 2^0
+  using S = ShiftAdd<P>;
+  EXPECT_EQ(S::COUNT, 4);
+  EXPECT_EQ(S::term(0).shift, 0);
+  EXPECT_FALSE(S::term(0).negative);
+  EXPECT_EQ(S::term(1).shift, 2);
+  EXPECT_TRUE(S::term(1).negative);
+  EXPECT_EQ(S::term(3).shift, 255);
+  EXPECT_FALSE(S::term(3).negative);
+  EXPECT_EQ(ShiftAdd<Nat<7>>::COUNT, 2);
+  EXPECT_EQ(ShiftAdd<Nat<10>>::COUNT, 2);
+  EXPECT_EQ(ShiftAdd<Nat<>>::COUNT, 0);
+
+  // comparisons with constants wider than the value are known
+  static_assert(Bits<64>{~0ULL}.cmp(Nat<0, 1>{}) == Cmp::LT);
+  static_assert(!(Bits<64>{~0ULL} == Nat<0, 1>{}));
+  static_assert(Bits<4>{0}.cmp(Neg<1>{}) == Cmp::GT);
+  static_assert(Bits<4>{0} == Neg<>{});
+  static_assert(Bits<100>{7} * Nat<0, 0, 1>{} == Nat<0, 0, 7>{});
+
+  check_constant<1, Nat<1>>(1);
+  check_constant<64, Nat<10>>(2);
+  check_constant<64, Nat<0, 1>>(3);
+  check_constant<100, Nat<0x123456789abcdef, 3>>(4);
+  check_constant<256, P>(5);
+  check_constant<256, Nat<0, 0, 0, 256>>(6);
+  check_constant<256, Nat<1, 1>>(7);
+  check_constant<300, Nat<~0ULL, ~0ULL>>(8);
+  check_constant<1000, Nat<3>>(9);
+  check_constant<130, Nat<>>(10);
+  // x equal to the constant
+  const auto x = to_bits(P{});
+  EXPECT_TRUE(x == P{});
+  EXPECT_EQ(x.cmp(P{}), Cmp::EQ);
+  EXPECT_EQ((x - P{}).none(), true);
+}
+
+template <uint16_t N, uint16_t M> void check_bitwise(const uint64_t seed) {
+  const Bits<N> a{pseudo_random_limbs<Bits<N>::LIMBS>(seed)};
+  const Bits<M> b{pseudo_random_limbs<Bits<M>::LIMBS>(seed + 1)};
+
+  const auto x_and = a & b;
+  const auto x_or = a | b;
+  const auto x_xor = a ^ b;
+  const auto x_andnot = a.andnot(b);
+  EXPECT_EQ(x_and.WIDTH, min(N, M));
+  EXPECT_EQ(x_or.WIDTH, max(N, M));
+  EXPECT_EQ(x_xor.WIDTH, max(N, M));
+  EXPECT_EQ(x_andnot.WIDTH, N);
+
+  for (uint16_t i = 0; i <= Bits<max(N, M)>::LIMBS; i++) {
+    EXPECT_EQ(x_and.get(i), a.get(i) & b.get(i));
+    EXPECT_EQ(x_or.get(i), a.get(i) | b.get(i));
+    EXPECT_EQ(x_xor.get(i), a.get(i) ^ b.get(i));
+    EXPECT_EQ(x_andnot.get(i), a.get(i) & ~b.get(i));
+  }
+
+  // the constant evaluated path takes the scalar loop
+  constexpr Bits<N> ca{pseudo_random_limbs<Bits<N>::LIMBS>(7)};
+  constexpr Bits<M> cb{pseudo_random_limbs<Bits<M>::LIMBS>(8)};
+  constexpr auto c_xor = ca ^ cb;
+  constexpr auto c_andnot = ca.andnot(cb);
+  for (uint16_t i = 0; i < Bits<max(N, M)>::LIMBS; i++) {
+    EXPECT_EQ(c_xor.get(i), ca.get(i) ^ cb.get(i));
+    EXPECT_EQ(c_andnot.get(i), ca.get(i) & ~cb.get(i));
+  }
+}
+
+TEST(Bits, bitwise) {
+  EXPECT_EQ(Bits<8>{0b1100} & Bits<4>{0b1010}, Bits<4>{0b1000});
+  EXPECT_EQ(Bits<8>{0b1100} | Bits<4>{0b1010}, Bits<8>{0b1110});
+  EXPECT_EQ(Bits<8>{0b1100} ^ Bits<4>{0b1010}, Bits<8>{0b0110});
+  EXPECT_EQ(Bits<8>{0xfc}.andnot(Bits<4>{0b1010}), Bits<8>{0xf4});
+  EXPECT_EQ(Bits<0>{} | Bits<5>{3}, Bits<5>{3});
+  EXPECT_EQ(Bits<5>{3}.andnot(Bits<0>{}), Bits<5>{3});
+
+  check_bitwise<3, 70>(1);
+  check_bitwise<128, 128>(2);
+  check_bitwise<256, 256>(3);
+  check_bitwise<300, 1000>(4);
+  check_bitwise<1000, 300>(5);
+  check_bitwise<4096, 4096>(6);
+  check_bitwise<4095, 4033>(7);
+}
+
+TEST(Bits, count) {
+  const Bits<4096> zero{};
+  const auto one = Bits<4096>{}.flip_bit<3000>().template trim<4096>();
+  const auto ones = ~zero;
+
+  EXPECT_EQ(zero.count_ones(), 0);
+  EXPECT_EQ(ones.count_ones(), 4096);
+  EXPECT_EQ(one.count_ones(), 1);
+  EXPECT_EQ(zero.leading_zeros(), 4096);
+  EXPECT_EQ(zero.trailing_zeros(), 4096);
+  EXPECT_EQ(one.leading_zeros(), 1095);
+  EXPECT_EQ(one.trailing_zeros(), 3000);
+  EXPECT_EQ(Bits<70>{1}.leading_zeros(), 69);
+  EXPECT_EQ(Bits<70>{0}.trailing_zeros(), 70);
+
+  EXPECT_TRUE(zero.none());
+  EXPECT_FALSE(zero.any());
+  EXPECT_TRUE(one.any());
+  EXPECT_FALSE(one.all());
+  EXPECT_TRUE(ones.all());
+  EXPECT_TRUE((~Bits<65>{0}).all());
+  EXPECT_FALSE(Bits<65>{~uint64_t(0)}.all());
+  EXPECT_TRUE(Bits<0>{}.all());
+  EXPECT_TRUE(Bits<0>{}.none());
+
+  EXPECT_TRUE(one.parity());
+  EXPECT_FALSE(ones.parity());
+  EXPECT_TRUE((~Bits<65>{0}).parity());
+  EXPECT_EQ(Bits<3>{7}.reduce_and(), Bits<1>{1});
+  EXPECT_EQ(Bits<3>{6}.reduce_and(), Bits<1>{0});
+  EXPECT_EQ(Bits<3>{4}.reduce_or(), Bits<1>{1});
+  EXPECT_EQ(Bits<3>{6}.reduce_xor(), Bits<1>{0});
+
+  const Bits<200> x{pseudo_random_limbs<4>(3)};
+  uint16_t count = 0;
+  int32_t last = -1;
+  x.for_each_set_bit([&](const uint16_t i) {
+    EXPECT_GT(i, last);
+    EXPECT_EQ(x.shr_by(i).get(0) & 1, 1);
+    last = i;
+    count++;
+  });
+  EXPECT_EQ(count, x.count_ones());
+  EXPECT_EQ(last, 199 - x.leading_zeros());
+
+  // exact result ranges
+  const auto p = popcount(ones);
+  static_assert(std::is_same_v<decltype(p), const BitCount<4096>>);
+  EXPECT_EQ(p.bitsize, 13);
+  EXPECT_EQ(p.get(0), 4096);
+  EXPECT_EQ(countl_zero(one).get(0), 1095);
+  EXPECT_EQ(countr_zero(Bits<64>{0}).get(0), 64);
+  EXPECT_EQ(countr_zero(Bits<64>{0}).bitsize, 7);
+  EXPECT_EQ(popcount(Bits<0>{}).get(0), 0);
+
+  static_assert(Bits<300>{}.flip_bit<299>().count_ones() == 1);
+  static_assert(Bits<300>{5}.trailing_zeros() == 0);
+}
+
 TEST(Bits, flip_bit) {
   auto o = flip_bit(Bits<129>{0});
   EXPECT_EQ(o.WIDTH, 129);
@@ -200,6 +689,608 @@ TEST(Bits, flip_bit) {
   }
 }
 
+TEST(Bits, layout) {
+  EXPECT_EQ(Bits<1>::LIMBS, 1);
+  EXPECT_EQ(Bits<64>::LIMBS, 1);
+  EXPECT_EQ(Bits<65>::LIMBS, 2);
+  EXPECT_EQ(Bits<8192>::LIMBS, 128);
+
+  EXPECT_EQ(sizeof(Bits<65>), 16);
+  EXPECT_EQ(sizeof(Bits<192>), 24);
+  EXPECT_EQ(sizeof(Bits<4096>), 512);
+  EXPECT_EQ(alignof(Bits<128>), 16);
+  EXPECT_EQ(alignof(Bits<192>), 8);
+  EXPECT_EQ(alignof(Bits<256>), 32);
+  EXPECT_EQ(alignof(Bits<4096>), 64);
+
+  EXPECT_EQ(Bits<65>::TOP_MASK, 1);
+  EXPECT_EQ(Bits<128>::TOP_MASK, UINT64_MAX);
+
+  const Bits<130> a{Bits<66>{3, 5}, 7};
+  EXPECT_EQ(a.get(0), 7);
+  EXPECT_EQ(a.get(1), 5);
+  EXPECT_EQ(a.get(2), 3);
+  EXPECT_EQ(a.get(3), 0);
+  EXPECT_EQ(a.get_high(), (Bits<66>{3, 5}));
+
+  const Bits<130> b{Bits<130>::Limbs{1, 2, ~uint64_t(0)}};
+  EXPECT_EQ(b.get(2), 3);
+}
+
+TEST(Bits, wide) {
+  const auto ones = ~Bits<8192>{0};
+  const auto sum = ones + Bits<1>{1};
+  EXPECT_EQ(sum.WIDTH, 8193);
+  for (uint16_t i = 0; i < 128; i++) {
+    EXPECT_EQ(sum.get(i), 0);
+  }
+  EXPECT_EQ(sum.get(128), 1);
+
+  EXPECT_EQ(ones.shr<8191>(), Bits<1>{1});
+  EXPECT_EQ(ones.cmp(sum), Cmp::LT);
+  EXPECT_EQ(sum.cmp(ones), Cmp::GT);
+  EXPECT_EQ(ones.cmp(ones), Cmp::EQ);
+
+  const auto c = Bits<3>{5}.concat(Bits<4096>{1});
+  EXPECT_EQ(c.WIDTH, 4099);
+  EXPECT_EQ(c.get(0), 1);
+  EXPECT_EQ(c.get(64), 5);
+  EXPECT_EQ((c.extract<4098, 4096>()), Bits<3>{5});
+  EXPECT_EQ((c.extract<4097, 63>().get(63)), 1 << 1);
+}
+
+TEST(Bits, compare) {
+  for (uint64_t s = 0; s < 64; s++) {
+    const Bits<256> a{pseudo_random_limbs<4>(2 * s)};
+    auto limbs = pseudo_random_limbs<4>(2 * s + 1);
+    // the limbs above s % 5 agree, all of them every fifth pair
+    for (uint16_t i = uint16_t(s % 5); i < 4; i++) {
+      limbs[i] = a.get(i);
+    }
+    const Bits<256> b{limbs};
+    // a < b is the borrow out of a - b
+    const bool lt = (a - b).is_signed();
+    const bool eq = (s % 5 == 0);
+    EXPECT_EQ(a.cmp(b), eq ? Cmp::EQ : (lt ? Cmp::LT : Cmp::GT));
+    EXPECT_EQ(b.cmp(a), eq ? Cmp::EQ : (lt ? Cmp::GT : Cmp::LT));
+    EXPECT_EQ(a < b, lt);
+    EXPECT_EQ(a <= b, lt || eq);
+    EXPECT_EQ(a > b, !lt && !eq);
+    EXPECT_EQ(a >= b, !lt);
+    EXPECT_EQ(a == b, eq);
+    EXPECT_EQ(a != b, !eq);
+    EXPECT_EQ(a <=> b, lt ? std::strong_ordering::less
+                          : (eq ? std::strong_ordering::equal
+                                : std::strong_ordering::greater));
+    EXPECT_EQ(a.cmp(b, Cmp::GT), eq ? Cmp::GT : a.cmp(b));
+
+    // mixed widths compare the zero extended values
+    const Bits<100> c{a};
+    EXPECT_EQ(c.cmp(a), (c.zero_extend<256>() == a) ? Cmp::EQ : Cmp::LT);
+    EXPECT_EQ(c < a, c.zero_extend<256>() < a);
+    EXPECT_TRUE(c == a.trim<100>());
+    EXPECT_TRUE(a.trim<100>() == c);
+  }
+
+  // wide equality goes through the vector kernel, every limb matters
+  const Bits<1024> x{pseudo_random_limbs<16>(7)};
+  EXPECT_TRUE(x == Bits<1024>{x});
+  for (uint16_t i = 0; i < 16; i++) {
+    auto limbs = pseudo_random_limbs<16>(7);
+    limbs[i] ^= 1ULL << (i * 5 % 64);
+    const Bits<1024> y{limbs};
+    EXPECT_FALSE(x == y);
+    EXPECT_EQ(x < y, (x - y).is_signed());
+  }
+  static_assert(Bits<1024>{5} == Bits<1024>{5});
+  static_assert(Bits<1024>{5} < Bits<1024>{6});
+  static_assert(Bits<8>{5} < Nat<6>{});
+  static_assert(Bits<8>{5} > Neg<6>{});
+  static_assert(Bits<0>{} == Bits<0>{});
+
+  // two's complement against int8_t, then mixed widths and wide values
+  for (int i = 0; i < 256; i++) {
+    for (int j = 0; j < 256; j += 3) {
+      const auto a = Bits<8>{uint64_t(i)};
+      const auto b = Bits<8>{uint64_t(j)};
+      EXPECT_EQ(a.cmp_signed(b), cmp(int8_t(i), int8_t(j)));
+      EXPECT_EQ(a.cmp_signed(b.sign_extend<70>()), cmp(int8_t(i), int8_t(j)));
+    }
+  }
+  for (uint64_t s = 0; s < 16; s++) {
+    const Bits<256> a{pseudo_random_limbs<4>(s)};
+    const Bits<256> b{pseudo_random_limbs<4>(s + 100)};
+    // flipping the sign bits maps the signed order onto the unsigned one
+    const auto flip = Bits<256>{}.flip_bit<255>();
+    EXPECT_EQ(a.cmp_signed(b), (a ^ flip).cmp(b ^ flip));
+    EXPECT_EQ(a.cmp_signed(a), Cmp::EQ);
+  }
+}
+
+TEST(BitsVector, bulk) {
+  constexpr size_t n = 37;
+  BitsVector<130> a;
+  BitsVector<70> b;
+  for (size_t j = 0; j < n; j++) {
+    a.push_back(Bits<130>{pseudo_random_limbs<3>(j)});
+    b.push_back(Bits<70>{pseudo_random_limbs<2>(j + 100)});
+  }
+  a.set(5, ~Bits<130>{0});
+  b.set(5, Bits<70>{1});
+  b.set(6, Bits<70>{a[6]});
+  EXPECT_EQ(a.size(), n);
+
+  const auto sum = a + b;
+  const auto x_and = a & b;
+  const auto x_or = a | b;
+  const auto x_xor = a ^ b;
+  const auto x_andnot = a.andnot(b);
+  const auto eq = a.eq(b);
+  const auto lt = b.lt(a);
+  const auto gt = a.lt(b);
+  const auto ones = a.popcount();
+  const auto ex = a.extract<129, 60>();
+  static_assert(decltype(sum)::WIDTH == 131);
+  static_assert(decltype(x_and)::WIDTH == 70);
+  static_assert(decltype(x_xor)::WIDTH == 130);
+  static_assert(decltype(ones)::WIDTH == 8);
+  static_assert(decltype(ex)::WIDTH == 70);
+
+  for (size_t j = 0; j < n; j++) {
+    EXPECT_EQ(sum[j], a[j] + b[j]);
+    EXPECT_EQ(x_and[j], a[j] & b[j]);
+    EXPECT_EQ(x_or[j], a[j] | b[j]);
+    EXPECT_EQ(x_xor[j], a[j] ^ b[j]);
+    EXPECT_EQ(x_andnot[j], a[j].andnot(b[j]));
+    EXPECT_EQ(eq[j], Bits<1>{a[j] == b[j]});
+    EXPECT_EQ(lt[j], Bits<1>{b[j].cmp(a[j]) == Cmp::LT});
+    EXPECT_EQ(gt[j], Bits<1>{a[j].cmp(b[j]) == Cmp::LT});
+    EXPECT_EQ(ones[j].get(0), a[j].count_ones());
+    EXPECT_EQ(ex[j], (a[j].extract<129, 60>()));
+  }
+  EXPECT_EQ(sum[5].get(2), 4);
+  EXPECT_EQ(eq[6], Bits<1>{a[6] == Bits<70>{a[6]}});
+}
+
+// every DynBits operation against the Bits<N> one
+template <uint16_t N, uint16_t M>
+void check_dyn(const uint64_t seed, DynBits::Arena *arena) {
+  const Bits<N> a{pseudo_random_limbs<Bits<N>::LIMBS>(seed)};
+  const Bits<M> b = Bits<M>{pseudo_random_limbs<Bits<M>::LIMBS>(seed + 1)} |
+                    Bits<1>{1};
+  const DynBits da{a, arena};
+  const DynBits db{b, arena};
+  EXPECT_EQ(da.width(), N);
+  EXPECT_EQ(da.to_bits<N>(), a);
+
+  const auto same = [](const DynBits &d, const auto &x) {
+    EXPECT_EQ(d.width(), x.WIDTH);
+    EXPECT_EQ(d, x);
+    EXPECT_EQ(d.template to_bits<std::remove_cvref_t<decltype(x)>::WIDTH>(),
+              x);
+  };
+  same(da + db, a + b);
+  same(da + b, a + b);
+  same(a + db, a + b);
+  same(da - db, a - b);
+  same(a - db, a - b);
+  same(da * db, a * b);
+  same(da / db, a / b);
+  same(da % b, a % b);
+  same(da & db, a & b);
+  same(da | b, a | b);
+  same(a ^ db, a ^ b);
+  same(da.andnot(db), a.andnot(b));
+  same(da.add_wrap(db), a.add_wrap(b));
+  same(da.sub_wrap(b), a.sub_wrap(b));
+  same(da.mul_wrap(db), a.mul_wrap(b));
+  same(~da, ~a);
+  same(da.shl(70), a.template shl<70>());
+  same(da.shr(3), a.template shr<3>());
+  same(da.extract(N - 1, 1), (a.template extract<N - 1, 1>()));
+  same(da.sign_extend(N + 65), a.template sign_extend<N + 65>());
+  same(da.zero_extend(N + 1), a.template zero_extend<N + 1>());
+  same(da.trim(N - 1), a.template trim<N - 1>());
+
+  EXPECT_EQ(da.cmp(db), a.cmp(b));
+  EXPECT_EQ(db.cmp(a), b.cmp(a));
+  EXPECT_EQ(da.count_ones(), a.count_ones());
+  EXPECT_EQ(da.leading_zeros(), a.leading_zeros());
+  EXPECT_EQ(da.trailing_zeros(), a.trailing_zeros());
+}
+
+TEST(DynBits, Ops) {
+  const DynBits zero{100};
+  EXPECT_EQ(zero.width(), 100);
+  EXPECT_TRUE(zero.none());
+  EXPECT_EQ(DynBits(4, -1), Bits<4>{15});
+  EXPECT_EQ(DynBits(4, 3) + DynBits(0), Bits<4>{3});
+  EXPECT_EQ((DynBits(4, 3) + DynBits(0)).width(), 4);
+  EXPECT_EQ((DynBits(8, 200) - Bits<8>{1}), Bits<9>{455});
+  EXPECT_EQ(DynBits(0) * DynBits(7, 5), Bits<7>{});
+  EXPECT_EQ(DynBits(64, 1).shl(64).trailing_zeros(), 64);
+
+  auto *heap = std::pmr::get_default_resource();
+  check_dyn<7, 5>(1, heap);
+  check_dyn<64, 64>(2, heap);
+  check_dyn<65, 63>(3, heap);
+  check_dyn<128, 128>(4, heap);
+  check_dyn<129, 64>(5, heap);
+  check_dyn<300, 1000>(6, heap);
+  check_dyn<1000, 300>(7, heap);
+  check_dyn<4095, 257>(8, heap);
+}
+
+TEST(DynBits, Arena) {
+  // up to 128 bits nothing is allocated, the null resource throws
+  auto *none = std::pmr::null_memory_resource();
+  const DynBits x{Bits<64>{~uint64_t(0)}, none};
+  const DynBits square = x * x;
+  EXPECT_EQ(square / x, x);
+  EXPECT_EQ(((x + x) ^ x).width(), 65);
+  EXPECT_EQ(x.shl(64).width(), 128);
+  EXPECT_THROW(x.shl(65), std::bad_alloc);
+  // 65 bits times 3 bits is 68 bits, inline although the operands have
+  // three limbs between them
+  const DynBits y{Bits<65>{std::array<uint64_t, 2>{~uint64_t(0), 1}}, none};
+  const DynBits product = y * Bits<3>{7};
+  EXPECT_EQ(product.width(), 68);
+  EXPECT_EQ(product, Bits<65>{y.to_bits<65>()} * Bits<3>{7});
+
+  // wider values come from the arena, the heap is never used
+  std::array<std::byte, 1 << 16> buffer;
+  std::pmr::monotonic_buffer_resource arena{buffer.data(), buffer.size(),
+                                            none};
+  check_dyn<300, 1000>(2, &arena);
+  check_dyn<1000, 129>(3, &arena);
+
+  // copies keep the arena, moves take the limbs
+  DynBits a{Bits<200>{pseudo_random_limbs<4>(5)}, &arena};
+  DynBits b{a};
+  EXPECT_EQ(b.arena(), &arena);
+  EXPECT_EQ(b, a);
+  const uint64_t *limbs = b.data();
+  DynBits c{std::move(b)};
+  EXPECT_EQ(c.data(), limbs);
+  EXPECT_EQ(c, a);
+  DynBits d{};
+  d = c;
+  EXPECT_EQ(d, a);
+  EXPECT_EQ(d.arena(), std::pmr::get_default_resource());
+  d = DynBits{7, 5};
+  EXPECT_EQ(d, Bits<3>{5});
+  EXPECT_EQ(d.width(), 7);
+
+  // moving from another arena copies the limbs into this one
+  DynBits e{Bits<200>{}, &arena};
+  e = DynBits{a, std::pmr::get_default_resource()};
+  EXPECT_EQ(e, a);
+  EXPECT_EQ(e.arena(), &arena);
+  DynBits f{Bits<64>{}, none};
+  EXPECT_THROW((f = DynBits{a, &arena}), std::bad_alloc);
+}
+
+template <typename M, ModReduction R> void check_mod(const uint64_t seed) {
+  using F = ModBits<M, R>;
+  constexpr uint16_t W = F::WIDTH;
+  const Bits<2 * W> x{pseudo_random_limbs<Bits<2 * W>::LIMBS>(seed)};
+  const Bits<W> y{pseudo_random_limbs<Bits<W>::LIMBS>(seed + 1)};
+  const Bits<W> m = F::MODULUS;
+  const Bits<W> a{x % m};
+  const Bits<W> b{y % m};
+  EXPECT_EQ(F{x}.value(), a);
+  EXPECT_EQ(F{y}.value(), b);
+  EXPECT_EQ((F{a} * F{b}).value(), Bits<W>{(a * b) % m});
+  EXPECT_EQ((F{a} + F{b}).value(), Bits<W>{(a + b) % m});
+  const auto diff = (a + m).sub_wrap(b.template zero_extend<W + 1>());
+  EXPECT_EQ((F{a} - F{b}).value(), Bits<W>{diff % m});
+  EXPECT_EQ(-F{a} + F{a}, F{});
+  EXPECT_EQ(F{a} * F::one(), F{a});
+
+  // a^5 and a^(2^64 + 3) by repeated multiplication
+  const Bits<W> a2{(a * a) % m};
+  const Bits<W> a4{(a2 * a2) % m};
+  EXPECT_EQ(F{a}.pow(Bits<3>{5}).value(), Bits<W>{(a4 * a) % m});
+  F big = F{a};
+  for (int i = 0; i < 64; i++) {
+    big = big * big;
+  }
+  EXPECT_EQ(F{a}.pow(Nat<3, 1>{}), big * F{a} * F{a} * F{a});
+  EXPECT_EQ(F{a}.pow(Bits<0>{}), F::one());
+
+  // the largest inputs, where q is furthest below x / m
+  const Bits<W> top = m.sub_wrap(Bits<1>{1});
+  EXPECT_EQ(F::reduce(top * top), Bits<W>{(top * top) % m});
+  EXPECT_EQ(F::reduce(~Bits<2 * W>{0}), Bits<W>{~Bits<2 * W>{0} % m});
+  EXPECT_EQ(F::reduce(Bits<2 * W>{top * m}), Bits<W>{});
+}
+
+// distinct hashes, and distinct low bits (the bucket) for about as many
+// keys as random values would give: 1 - 1/e of them
+template <uint16_t N> void check_spread() {
+  constexpr uint64_t n = 4096;
+  std::unordered_set<uint64_t> full;
+  std::unordered_set<uint64_t> low;
+  for (uint64_t i = 0; i < n; i++) {
+    // sequential keys, and keys that differ in a high limb only
+    const auto h = hash(Bits<N>{i});
+    auto limbs = typename Bits<N>::Limbs{};
+    if constexpr (Bits<N>::LIMBS == 1) {
+      limbs[0] = i << 32;
+    } else {
+      limbs[Bits<N>::LIMBS - 2] = i << 1;
+    }
+    full.insert(h);
+    full.insert(hash(Bits<N>{limbs}));
+    low.insert(h % n);
+  }
+  EXPECT_EQ(full.size(), 2 * n - 1);
+  EXPECT_GT(low.size(), n * 6 / 10);
+}
+
+TEST(Hash, Bits) {
+  check_spread<64>();
+  check_spread<256>();
+  check_spread<1100>();
+
+  // the vector paths give the values of constant evaluation
+  constexpr Bits<256> a{pseudo_random_limbs<4>(1)};
+  constexpr Bits<1100> b{pseudo_random_limbs<18>(2)};
+  constexpr uint64_t ha = hash(a, 5);
+  constexpr uint64_t hb = hash(b, 5);
+  volatile uint64_t seed = 5;
+  EXPECT_EQ(hash(a, seed), ha);
+  EXPECT_EQ(hash(b, seed), hb);
+  EXPECT_NE(hash(a, seed + 1), ha);
+  EXPECT_NE(hash(b, seed + 1), hb);
+  EXPECT_EQ(hash(Bits<1100>{b}, seed), hb);
+
+  // the order of the stripes matters
+  auto limbs = pseudo_random_limbs<18>(2);
+  std::swap(limbs[1], limbs[9]);
+  EXPECT_NE(hash(Bits<1100>{limbs}, seed), hb);
+
+  // one flipped bit changes about half of the hash
+  for (const uint16_t w : {uint16_t(64), uint16_t(256), uint16_t(1100)}) {
+    uint64_t changed = 0;
+    for (uint16_t i = 0; i < w; i++) {
+      auto flipped = pseudo_random_limbs<18>(2);
+      flipped[i / 64] ^= uint64_t(1) << (i % 64);
+      const Bits<1100> c{flipped};
+      if (w == 64) {
+        changed += std::popcount(hash(Bits<64>{b}) ^ hash(Bits<64>{c}));
+      } else if (w == 256) {
+        changed += std::popcount(hash(Bits<256>{b}) ^ hash(Bits<256>{c}));
+      } else {
+        changed += std::popcount(hb ^ hash(c, 5));
+      }
+    }
+    EXPECT_GT(changed, 24 * uint64_t(w));
+    EXPECT_LT(changed, 40 * uint64_t(w));
+  }
+
+  std::vector<Bits<256>> keys;
+  for (uint64_t i = 0; i < 37; i++) {
+    keys.push_back(Bits<256>{pseudo_random_limbs<4>(i)});
+  }
+  std::vector<uint64_t> hashes(keys.size());
+  hash_batch(std::span{keys}, std::span{hashes}, 9);
+  for (size_t i = 0; i < keys.size(); i++) {
+    EXPECT_EQ(hashes[i], hash(keys[i], 9));
+  }
+
+  std::unordered_map<Bits<256>, size_t> index;
+  for (size_t i = 0; i < keys.size(); i++) {
+    index[keys[i]] = i;
+  }
+  EXPECT_EQ(index.size(), keys.size());
+  EXPECT_EQ(index.at(keys[17]), 17);
+  EXPECT_EQ(index.count(Bits<256>{}), 0);
+}
+
+TEST(Hash, Int) {
+  const auto x = Int<Neg<5>, Nat<20>>{Nat<13>{}};
+  EXPECT_EQ(hash(x, 3), hash(x.biased_bits, 3));
+  EXPECT_EQ((std::hash<Int<Neg<5>, Nat<20>>>{}(x)), hash(x.biased_bits));
+
+  std::unordered_set<SignedInt<16>> set;
+  for (uint64_t i = 0; i < 1000; i++) {
+    set.insert(SInt(Bits<16>{i * 7}));
+  }
+  EXPECT_EQ(set.size(), 1000);
+  EXPECT_EQ(set.count(SInt(Bits<16>{7 * 999})), 1);
+  EXPECT_EQ(set.count(SInt(Bits<16>{1})), 0);
+
+  using Fixed = MaskedBits<32, Nat<0xffffffff>, Nat<0xd503201f>>;
+  using Free = MaskedBits<32, Nat<0xff000000>, Nat<0x54000000>>;
+  // a fixed pattern hashes as its value
+  EXPECT_EQ(hash(Fixed{Bits<32>{0}}), hash(Bits<32>{0xd503201f}));
+  EXPECT_EQ(hash(Free{Bits<32>{0x54000010}}), hash(Bits<32>{0x54000010}));
+  EXPECT_EQ(std::hash<Free>{}(Free{Bits<32>{0x54000010}}),
+            hash(Bits<32>{0x54000010}));
+}
+
+// radix_sort against std::stable_sort with cmp, keys only and with the
+// original positions as values, which checks that the sort is stable
+template <typename K, typename F>
+void check_radix_sort(const size_t n, const unsigned threads, F make) {
+  std::vector<K> keys;
+  std::vector<std::pair<K, uint32_t>> expected;
+  for (size_t i = 0; i < n; i++) {
+    keys.push_back(make(pseudo_random_limbs<1>(i)[0]));
+    expected.push_back({keys.back(), uint32_t(i)});
+  }
+  std::stable_sort(expected.begin(), expected.end(),
+                   [](const auto &a, const auto &b) {
+                     return radix_bits(a.first) < radix_bits(b.first);
+                   });
+
+  auto sorted = keys;
+  radix_sort(std::span{sorted}, threads);
+  std::vector<uint32_t> values(n);
+  for (size_t i = 0; i < n; i++) {
+    values[i] = uint32_t(i);
+  }
+  radix_sort(std::span{keys}, std::span{values}, threads);
+  for (size_t i = 0; i < n; i++) {
+    ASSERT_TRUE(radix_bits(sorted[i]) == radix_bits(expected[i].first));
+    ASSERT_TRUE(radix_bits(keys[i]) == radix_bits(expected[i].first));
+    ASSERT_EQ(values[i], expected[i].second);
+  }
+}
+
+TEST(RadixSort, Bits) {
+  // Int<0, 999999>: 20 bits, three LSD passes of 7 bits
+  static_assert(RadixPlan<20>::PASSES == 3);
+  static_assert(RadixPlan<20>::DIGIT_BITS == 7);
+  static_assert(RadixPlan<32>::LSD && !RadixPlan<33>::LSD);
+
+  const auto bits = [](const uint64_t r) { return Bits<64>{r}; };
+  const auto few = [](const uint64_t r) { return Bits<20>{r % 7}; };
+  const auto wide = [](const uint64_t r) {
+    // equal upper limbs for many keys
+    return Bits<200>{std::array<uint64_t, 4>{r, r % 3, 0, r % 5}};
+  };
+  for (const size_t n : {size_t(0), size_t(1), size_t(31), size_t(5000)}) {
+    check_radix_sort<Bits<64>>(n, 1, bits);
+    check_radix_sort<Bits<20>>(n, 1, few);
+    check_radix_sort<Bits<200>>(n, 1, wide);
+  }
+  check_radix_sort<Bits<13>>(5000, 1, [](const uint64_t r) {
+    return Bits<13>{r};
+  });
+  check_radix_sort<Bits<0>>(10, 1, [](uint64_t) { return Bits<0>{}; });
+
+  // large enough to be split between threads
+  const size_t n = RADIX_PARALLEL_MIN + 1000;
+  check_radix_sort<Bits<64>>(n, 3, bits);
+  check_radix_sort<Bits<20>>(n, 3, few);
+  check_radix_sort<Bits<200>>(n, 4, wide);
+}
+
+TEST(RadixSort, Int) {
+  using I = Int<Neg<500>, Nat<999999>>;
+  check_radix_sort<I>(5000, 1, [](const uint64_t r) {
+    I x;
+    x.biased_bits = Bits<I::bitsize>{r % 1000500};
+    return x;
+  });
+  std::vector<SignedInt<16>> keys;
+  for (uint64_t i = 0; i < 3000; i++) {
+    keys.push_back(SInt(Bits<16>{pseudo_random_limbs<1>(i)[0]}));
+  }
+  radix_sort(std::span{keys});
+  for (size_t i = 1; i < keys.size(); i++) {
+    EXPECT_NE(keys[i].cmp(keys[i - 1]), Cmp::LT);
+  }
+  // negative values sort before the non-negative ones
+  EXPECT_LT(keys.front(), keys.back());
+  EXPECT_EQ(keys.front().cmp(SInt(Bits<16>{0})), Cmp::LT);
+}
+
+TEST(ModBits, Small) {
+  // against 128-bit arithmetic, odd moduli are Montgomery, even ones Barrett
+  static_assert(ModBits<Nat<1000000007>>::REDUCTION ==
+                ModReduction::MONTGOMERY);
+  static_assert(ModBits<Nat<1000000006>>::REDUCTION == ModReduction::BARRETT);
+  const auto check = [](const auto f, const uint64_t m) {
+    using F = decltype(f);
+    uint64_t s = m;
+    for (int i = 0; i < 200; i++) {
+      s = s * 6364136223846793005ULL + 1442695040888963407ULL;
+      const uint64_t x = s ^ (s >> 29);
+      const uint64_t y = (s >> 7) * 0x9e3779b97f4a7c15ULL;
+      const uint64_t a = x % m;
+      const uint64_t b = y % m;
+      const F fa{Bits<64>{x}};
+      const F fb{Bits<64>{y}};
+      EXPECT_EQ(fa.value(), Bits<64>{a});
+      EXPECT_EQ((fa * fb).value(), Bits<64>{uint64_t(uint128_t(a) * b % m)});
+      EXPECT_EQ((fa + fb).value(), Bits<64>{uint64_t((uint128_t(a) + b) % m)});
+      EXPECT_EQ((fa - fb).value(),
+                Bits<64>{uint64_t((uint128_t(a) + m - b) % m)});
+    }
+  };
+  check(ModBits<Nat<1000000007>>{}, 1000000007);
+  check(ModBits<Nat<1000000006>>{}, 1000000006);
+  check(ModBits<Nat<1000000007>, ModReduction::BARRETT>{}, 1000000007);
+  check(ModBits<Nat<0x1fffffffffffffff>>{}, 0x1fffffffffffffff);
+  check(ModBits<Nat<0xffffffffffffffc5>>{}, 0xffffffffffffffc5);
+  check(ModBits<Nat<0x8000000000000000>>{}, 0x8000000000000000);
+  check(ModBits<Nat<6>>{}, 6);
+  check(ModBits<Nat<3>>{}, 3);
+
+  // everything is constexpr
+  using F7 = ModBits<Nat<7>>;
+  static_assert(F7{Nat<3>{}}.inverse() == F7{Nat<5>{}});
+
+  // inverses modulo composites, 0 when the value shares a factor with m
+  using E = ModBits<Nat<1000000006>>;
+  EXPECT_EQ((E{Nat<7>{}} * E{Nat<7>{}}.inverse()), E::one());
+  EXPECT_EQ(E{Nat<2>{}}.inverse(), E{});
+  EXPECT_EQ(E{Nat<500000003>{}}.inverse(), E{});
+  const auto inverses = [](const auto f, const uint64_t m) {
+    using F = decltype(f);
+    for (uint64_t a = 0; a < m; a++) {
+      const F x = F{Bits<64>{a}}.inverse();
+      if (std::gcd(a, m) == 1) {
+        EXPECT_EQ((F{Bits<64>{a}} * x), F::one()) << a << " mod " << m;
+      } else {
+        EXPECT_EQ(x, F{}) << a << " mod " << m;
+      }
+    }
+  };
+  inverses(ModBits<Nat<360>>{}, 360);
+  inverses(ModBits<Nat<225>>{}, 225);
+  inverses(ModBits<Nat<225>, ModReduction::BARRETT>{}, 225);
+  inverses(ModBits<Nat<2>>{}, 2);
+  inverses(ModBits<Nat<3>>{}, 3);
+  static_assert((F7{Nat<4>{}} * F7{Nat<5>{}}).value() == Bits<3>{6});
+  static_assert(F7{Nat<100>{}}.value() == Bits<3>{2});
+}
+
+TEST(ModBits, Wide) {
+  using P25519 = Nat<0xffffffffffffffed, ~0ULL, ~0ULL, 0x7fffffffffffffff>;
+  using Secp256k1 = Nat<0xfffffffefffffc2f, ~0ULL, ~0ULL, ~0ULL>;
+  using Even = Nat<0xfffffffefffffc2e, ~0ULL, ~0ULL, ~0ULL>;
+  using M130 = Nat<0x123456789, 0, 2>;
+  check_mod<P25519, ModReduction::MONTGOMERY>(1);
+  check_mod<P25519, ModReduction::BARRETT>(2);
+  check_mod<Secp256k1, ModReduction::MONTGOMERY>(3);
+  check_mod<Secp256k1, ModReduction::BARRETT>(4);
+  check_mod<Even, ModReduction::BARRETT>(5);
+  check_mod<M130, ModReduction::MONTGOMERY>(6);
+  check_mod<M130, ModReduction::BARRETT>(7);
+  check_mod<decltype(Nat<1>{} << Nat<200>{}), ModReduction::BARRETT>(8);
+  constexpr auto odd = [] {
+    auto limbs = pseudo_random_limbs<16>(9);
+    limbs[0] |= 1;
+    return limbs;
+  }();
+  using M1024 = decltype(to_nat<odd>());
+  check_mod<M1024, ModReduction::MONTGOMERY>(10);
+  check_mod<M1024, ModReduction::BARRETT>(11);
+
+  // Fermat: a^(p - 1) = 1 and a a^-1 = 1 for a prime p
+  using F = ModBits<P25519>;
+  const F a{Bits<256>{pseudo_random_limbs<4>(12)}};
+  EXPECT_EQ(a.pow(P25519{} - Nat<1>{}), F::one());
+  EXPECT_EQ(a * a.inverse(), F::one());
+  EXPECT_EQ(F{}.inverse(), F{});
+  using G = ModBits<Secp256k1>;
+  const G g{Bits<256>{pseudo_random_limbs<4>(13)}};
+  EXPECT_EQ(g * g.inverse(), G::one());
+  EXPECT_EQ(G{Nat<2>{}}.inverse().value(),
+            to_bits((Secp256k1{} + Nat<1>{}) / Nat<2>{}).zero_extend<256>());
+  // p - 1 = 2 3 7 13441 ...
+  using H = ModBits<Even>;
+  const H h = H{Nat<5>{}}.pow(Bits<256>{pseudo_random_limbs<4>(14)});
+  EXPECT_EQ(h * h.inverse(), H::one());
+  EXPECT_EQ((H{Nat<5>{}} * H{Nat<5>{}}.inverse()), H::one());
+  EXPECT_EQ(H{Nat<21>{}}.inverse(), H{});
+  EXPECT_EQ((h * H{Nat<13441>{}}).inverse(), H{});
+}
+
 TEST(MaskedBits, simple) {
   {
     const auto a =
@@ -213,6 +1304,115 @@ TEST(MaskedBits, simple) {
   }
 }
 
+template <uint64_t M, uint64_t V> using Enc = MaskedBits<32, Nat<M>, Nat<V>>;
+
+// a few A64 encodings, the more specific ones first like a hand-written
+// decoder would list them, and a catch-all
+using A64 = Decoder<
+    Enc<0x7f800000, 0x11000000>, // add (immediate)
+    Enc<0x7f800000, 0x51000000>, // sub (immediate)
+    Enc<0x7f200000, 0x0b000000>, // add (shifted register)
+    Enc<0x7f200000, 0x4b000000>, // sub (shifted register)
+    Enc<0xfc000000, 0x14000000>, // b
+    Enc<0xfc000000, 0x94000000>, // bl
+    Enc<0xff000010, 0x54000000>, // b.cond
+    Enc<0x7e000000, 0x34000000>, // cbz, cbnz
+    Enc<0xfffffc1f, 0xd65f0000>, // ret
+    Enc<0xbfc00000, 0xb9400000>, // ldr (unsigned offset)
+    Enc<0xbfc00000, 0xb9000000>, // str (unsigned offset)
+    Enc<0x7f800000, 0x52800000>, // movz
+    Enc<0xffffffff, 0xd503201f>, // nop
+    Enc<0xfffff01f, 0xd503201f>, // hint, after nop so nop wins
+    Enc<0xffffffff, 0xd503203f>, // yield, after hint so never chosen
+    Enc<0x1f000000, 0x1a000000>, // data processing (register)
+    Enc<0, 0>>;                  // undefined
+
+uint16_t linear_match(const uint32_t w) {
+  for (uint16_t i = 0; i < A64::COUNT; i++) {
+    if ((w & A64::PATTERNS[i].mask) == A64::PATTERNS[i].value) {
+      return i;
+    }
+  }
+  return A64::COUNT;
+}
+
+TEST(Decoder, Match) {
+  EXPECT_EQ(A64::match(Bits<32>{0x91000421u}), 0);  // add x1, x1, #1
+  EXPECT_EQ(A64::match(Bits<32>{0xd65f03c0u}), 8);  // ret
+  EXPECT_EQ(A64::match(Bits<32>{0xd503201fu}), 12); // nop
+  EXPECT_EQ(A64::match(Bits<32>{0xd503203fu}), 13); // yield is a hint
+  EXPECT_EQ(A64::match(Bits<32>{0x00000000u}), 16);
+
+  uint64_t s = 7;
+  for (int i = 0; i < 200000; i++) {
+    s = s * 6364136223846793005ULL + 1442695040888963407ULL;
+    uint32_t w = uint32_t(s >> 32);
+    if (i % 2 == 0) {
+      // force a pattern's fixed bits so every pattern is exercised
+      const auto &p = A64::PATTERNS[(s >> 8) % A64::COUNT];
+      w = uint32_t((w & ~p.mask) | p.value);
+    }
+    ASSERT_EQ(A64::match(Bits<32>{w}), linear_match(w)) << std::hex << w;
+  }
+
+  // no catch-all: words that match nothing go to the miss handler
+  using Two = Decoder<Enc<0xff, 0x12>, Enc<0xff00, 0x3400>>;
+  EXPECT_EQ(Two::match(Bits<32>{0x3412}), 0);
+  EXPECT_EQ(Two::match(Bits<32>{0x3400}), 1);
+  EXPECT_EQ(Two::match(Bits<32>{0x3300}), 2);
+  EXPECT_EQ(Two::decode(
+                Bits<32>{0x3300}, [](const auto) { return 1; },
+                [](const Bits<32> &) { return -1; }),
+            -1);
+
+  // every 12-bit word against the linear scan
+  using Small = Decoder<MaskedBits<12, Nat<0xf00>, Nat<0x100>>,
+                        MaskedBits<12, Nat<0xf0f>, Nat<0x203>>,
+                        MaskedBits<12, Nat<0x00f>, Nat<0x003>>,
+                        MaskedBits<12, Nat<0x800>, Nat<0x800>>>;
+  for (uint32_t w = 0; w < 4096; w++) {
+    uint16_t expected = Small::COUNT;
+    for (uint16_t i = 0; i < Small::COUNT; i++) {
+      if ((w & Small::PATTERNS[i].mask) == Small::PATTERNS[i].value) {
+        expected = i;
+        break;
+      }
+    }
+    ASSERT_EQ(Small::match(Bits<12>{w}), expected) << w;
+  }
+}
+
+TEST(Decoder, Decode) {
+  // the handler sees the pattern's type, fixed fields fold away
+  const auto rd = [](const uint32_t w) {
+    return A64::decode(
+        Bits<32>{w},
+        [](const auto ins) -> int64_t {
+          using Ins = std::remove_cvref_t<decltype(ins)>;
+          if constexpr (std::is_same_v<Ins, Enc<0x7f800000, 0x11000000>>) {
+            const auto sf = ins.template extract<31, 31>();
+            return ((sf == Bits<1>{1}) ? 1000 : 0) +
+                   int64_t(ins.bits.template extract<4, 0>().get(0));
+          } else if constexpr (Ins::is_fixed()) {
+            return -int64_t(Ins::fixed().get(0));
+          } else {
+            return -1;
+          }
+        },
+        [](const Bits<32> &) -> int64_t { return -2; });
+  };
+  EXPECT_EQ(rd(0x91000421u), 1001);  // add x1, x1, #1
+  EXPECT_EQ(rd(0x11000422u), 2);     // add w2, w1, #1
+  EXPECT_EQ(rd(0xd503201fu), -int64_t(0xd503201fu));
+  EXPECT_EQ(rd(0xd65f03c0u), -1);
+
+  int calls = 0;
+  A64::decode(
+      Bits<32>{0x14000000u}, [&](const auto) { calls++; },
+      [&](const Bits<32> &) { calls += 100; });
+  EXPECT_EQ(calls, 1);
+}
+
 #if 0
 
 TEST(Nat, Add) {
@@ -402,6 +1602,347 @@ TEST(Int, Simple) {
   EXPECT_EQ(k.get(0), 15);
 }
 
+TEST(Int, Mul) {
+  const auto i = Int<Neg<3>, Nat<5>>{Neg<3>{}};
+  const auto j = Int<Neg<2>, Nat<7>>{Nat<7>{}};
+  const auto k = i * j;
+  EXPECT_TRUE(k.min == Neg<21>{});
+  EXPECT_TRUE(k.max == Nat<35>{});
+  EXPECT_EQ(k.bitsize, 6);
+  EXPECT_EQ(k.get(0), 0);
+
+  const auto l = Int<Neg<3>, Nat<5>>{Nat<4>{}} * Int<Neg<2>, Nat<7>>{Nat<5>{}};
+  EXPECT_EQ(l.get(0), 41);
+
+  const auto m = SInt(Bits<4>{-3}) * SInt(Bits<4>{5});
+  EXPECT_TRUE(m.min == Neg<56>{});
+  EXPECT_TRUE(m.max == Nat<64>{});
+  EXPECT_EQ(m.get(0), 41);
+
+  const auto u = UInt(~Bits<64>{0}) * UInt(Bits<3>{7});
+  EXPECT_EQ(u.bitsize, 67);
+  EXPECT_EQ(u.get(0), ~uint64_t(6));
+  EXPECT_EQ(u.get(1), 6);
+
+  const auto z = UInt(Bits<8>{200}) * UInt(Nat<0>{});
+  EXPECT_TRUE(z.max == Nat<>{});
+  EXPECT_EQ(z.get(0), 0);
+}
+
+TEST(Nat, Mul) {
+  EXPECT_TRUE((Nat<6>{} * Nat<7>{}) == Nat<42>{});
+  EXPECT_TRUE((Nat<>{} * Nat<7>{}) == Nat<>{});
+  EXPECT_TRUE((Nat<~uint64_t(0)>{} * Nat<~uint64_t(0)>{}) ==
+              (Nat<1, ~uint64_t(1)>{}));
+  EXPECT_TRUE((Nat<0, 1>{} * Nat<0, 1>{}) == (Nat<0, 0, 1>{}));
+  EXPECT_TRUE((Neg<6>{} * Nat<7>{}) == Neg<42>{});
+  EXPECT_TRUE((Nat<6>{} * Neg<7>{}) == Neg<42>{});
+  EXPECT_TRUE((Neg<6>{} * Neg<7>{}) == Nat<42>{});
+  static_assert(std::is_same_v<decltype(Nat<3, 0>{} * Nat<5>{}), Nat<15>>);
+}
+
+TEST(Int, Div) {
+  // [-7, 20] / [2, 5]
+  using A = Int<Neg<7>, Nat<20>>;
+  using B = Int<Nat<2>, Nat<5>>;
+  const auto q = A{Neg<7>{}} / B{Nat<2>{}};
+  EXPECT_TRUE(q.min == Neg<3>{});
+  EXPECT_TRUE(q.max == Nat<10>{});
+  EXPECT_EQ(q.get(0), 0);
+
+  const auto r = A{Neg<7>{}} % B{Nat<2>{}};
+  EXPECT_TRUE(r.min == Neg<4>{});
+  EXPECT_TRUE(r.max == Nat<4>{});
+  EXPECT_EQ(r.get(0), 3); // -1
+
+  const auto q2 = A{Nat<19>{}} / B{Nat<4>{}};
+  EXPECT_EQ(q2.get(0), 7); // 4
+  const auto r2 = A{Nat<19>{}} % B{Nat<4>{}};
+  EXPECT_EQ(r2.get(0), 7); // 3
+
+  const auto u = UInt(Bits<16>{1000}) / Int<Nat<7>, Nat<7>>{Nat<7>{}};
+  EXPECT_TRUE(u.max == Nat<9362>{});
+  EXPECT_EQ(u.get(0), 142);
+}
+
+// small Int values as int64_t
+template <typename Min, typename Max>
+int64_t value_of(const Int<Min, Max> &x) {
+  const auto [magnitude, negative] = x.sign_magnitude();
+  const auto m = int64_t(magnitude.get(0));
+  return negative ? -m : m;
+}
+
+TEST(Int, Ops) {
+  const auto a = Int<Neg<5>, Nat<20>>{Nat<13>{}};
+  const auto b = Int<Nat<3>, Nat<9>>{Nat<7>{}};
+
+  const auto n = -a;
+  EXPECT_TRUE(n.min == Neg<20>{});
+  EXPECT_TRUE(n.max == Nat<5>{});
+  EXPECT_EQ(value_of(n), -13);
+
+  const auto d = a - b;
+  EXPECT_TRUE(d.min == Neg<14>{});
+  EXPECT_TRUE(d.max == Nat<17>{});
+  EXPECT_EQ(value_of(d), 6);
+  EXPECT_EQ(value_of(b - a), -6);
+
+  const auto l = a << Nat<3>{};
+  EXPECT_TRUE(l.min == Neg<40>{});
+  EXPECT_TRUE(l.max == Nat<160>{});
+  EXPECT_EQ(value_of(l), 104);
+
+  const auto r = a >> Nat<2>{};
+  EXPECT_TRUE(r.min == Neg<2>{});
+  EXPECT_TRUE(r.max == Nat<5>{});
+  EXPECT_EQ(value_of(r), 3);
+  EXPECT_EQ(value_of(Int<Neg<5>, Nat<20>>{Neg<5>{}} >> Nat<2>{}), -2);
+  EXPECT_EQ(value_of(Int<Neg<5>, Nat<20>>{Neg<4>{}} >> Nat<2>{}), -1);
+
+  const auto x = Int<Nat<2>, Nat<12>>{Nat<12>{}};
+  const auto y = Int<Nat<5>, Nat<6>>{Nat<6>{}};
+  const auto band = x & y;
+  EXPECT_TRUE(band.min == Nat<>{});
+  EXPECT_TRUE(band.max == Nat<6>{});
+  EXPECT_EQ(value_of(band), 4);
+  const auto bor = x | y;
+  EXPECT_TRUE(bor.min == Nat<5>{});
+  EXPECT_TRUE(bor.max == Nat<15>{});
+  EXPECT_EQ(value_of(bor), 14);
+
+  const auto lo = min(a, b);
+  EXPECT_TRUE(lo.min == Neg<5>{});
+  EXPECT_TRUE(lo.max == Nat<9>{});
+  EXPECT_EQ(value_of(lo), 7);
+  EXPECT_EQ(value_of(min(-a, b)), -13);
+  const auto hi = max(-a, b);
+  EXPECT_TRUE(hi.min == Nat<3>{});
+  EXPECT_TRUE(hi.max == Nat<9>{});
+  EXPECT_EQ(value_of(hi), 7);
+  EXPECT_EQ(value_of(max(a, b)), 13);
+
+  const auto m = (-a).abs();
+  EXPECT_TRUE(m.min == Nat<>{});
+  EXPECT_TRUE(m.max == Nat<20>{});
+  EXPECT_EQ(value_of(m), 13);
+  EXPECT_TRUE((-b).abs().min == Nat<3>{});
+  EXPECT_EQ(value_of((-b).abs()), 7);
+  EXPECT_EQ(value_of(b.abs()), 7);
+
+  // tight ranges keep 64-bit values in one limb
+  const auto u = UInt(~Bits<64>{0});
+  static_assert(decltype(u)::bitsize == 64);
+  static_assert(decltype(u & u)::bitsize == 64);
+  static_assert(decltype(max(u, u))::bitsize == 64);
+  static_assert(decltype(u >> Nat<1>{})::bitsize == 63);
+  EXPECT_EQ((u - u).get(0), ~uint64_t(0));
+  EXPECT_EQ(value_of(u - u), 0);
+}
+
+TEST(Int, Refine) {
+  const auto narrow = [](const uint64_t v) {
+    const auto x = UInt(Bits<16>{v});
+    return x.refine_lt(
+        Nat<100>{},
+        [](const auto lo) {
+          static_assert(decltype(lo)::bitsize == 7);
+          EXPECT_TRUE(lo.max == Nat<99>{});
+          return int64_t(value_of(lo));
+        },
+        [](const auto hi) {
+          EXPECT_TRUE(hi.min == Nat<100>{});
+          EXPECT_TRUE(hi.max == Nat<65535>{});
+          return -int64_t(value_of(hi));
+        });
+  };
+  EXPECT_EQ(narrow(0), 0);
+  EXPECT_EQ(narrow(99), 99);
+  EXPECT_EQ(narrow(100), -100);
+  EXPECT_EQ(narrow(4000), -4000);
+
+  // one side only
+  const auto s = Int<Neg<7>, Nat<3>>{Neg<2>{}};
+  EXPECT_EQ(s.refine_lt(
+                Nat<10>{}, [](const auto v) { return value_of(v); },
+                [](const auto) { return int64_t(1000); }),
+            -2);
+  EXPECT_EQ(s.refine_lt(
+                Neg<1>{},
+                [](const auto v) {
+                  EXPECT_TRUE(v.max == Neg<2>{});
+                  return value_of(v);
+                },
+                [](const auto) { return int64_t(1000); }),
+            -2);
+}
+
+TEST(Int, Clamp) {
+  const auto x = Int<Neg<50>, Nat<300>>{Nat<120>{}};
+  const auto c = x.clamp<Nat<>, Nat<100>>();
+  EXPECT_TRUE(c.min == Nat<>{});
+  EXPECT_TRUE(c.max == Nat<100>{});
+  EXPECT_EQ(value_of(c), 100);
+  using X = Int<Neg<50>, Nat<300>>;
+  EXPECT_EQ(value_of(X{Neg<20>{}}.clamp<Nat<>, Nat<100>>()), 0);
+  EXPECT_EQ(value_of(X{Nat<42>{}}.clamp<Nat<>, Nat<100>>()), 42);
+
+  // no overlap
+  const auto k = x.clamp<Nat<400>, Nat<500>>();
+  EXPECT_TRUE(k.min == Nat<400>{});
+  EXPECT_TRUE(k.max == Nat<400>{});
+  EXPECT_EQ(k.bitsize, 0);
+
+  EXPECT_EQ(x.saturate<6>().get(0), 63);
+  EXPECT_EQ((X{Neg<9>{}}.saturate<6>().get(0)), 0);
+  EXPECT_EQ(x.saturate_signed<8>().get(0), 120);
+  EXPECT_EQ(x.saturate_signed<6>().get(0), 31);
+  EXPECT_EQ((X{Neg<50>{}}.saturate_signed<6>().get(0)),
+            0b100000);
+  EXPECT_EQ((X{Neg<9>{}}.saturate_signed<6>().get(0)),
+            0b110111);
+  EXPECT_EQ(UInt(~Bits<64>{0}).saturate<32>().get(0), 0xffffffff);
+
+  // biased values and bounds in the upper half of the range
+  using Byte = Int<Nat<>, Nat<255>>;
+  for (uint64_t v = 0; v < 256; v++) {
+    const Byte b{Bits<8>{v}, true};
+    const auto expected = int64_t(std::clamp<uint64_t>(v, 10, 250));
+    ASSERT_EQ(value_of(b.clamp<Nat<10>, Nat<250>>()), expected) << v;
+    ASSERT_EQ(b.saturate<7>().get(0), std::min<uint64_t>(v, 127)) << v;
+  }
+  EXPECT_EQ((Byte{Nat<200>{}}.saturate<7>().get(0)), 127);
+
+  using Wide = Int<Neg<1000>, Nat<100000>>;
+  for (int64_t v = -1000; v <= 100000; v += 7) {
+    const Wide w{Bits<Wide::bitsize>{uint64_t(v + 1000)}, true};
+    ASSERT_EQ(value_of(w.clamp<Nat<>, Nat<99999>>()),
+              std::clamp<int64_t>(v, 0, 99999))
+        << v;
+    ASSERT_EQ(int64_t(w.saturate_signed<16>().get(0)),
+              std::clamp<int64_t>(v, -32768, 32767) & 0xffff)
+        << v;
+  }
+
+  for (uint64_t v = 0; v < 0x10000; v += 3) {
+    const auto i = SInt(Bits<16>{v});
+    const int64_t x = int16_t(v);
+    ASSERT_EQ(int64_t(i.saturate_signed<8>().get(0)),
+              std::clamp<int64_t>(x, -128, 127) & 0xff)
+        << x;
+    ASSERT_EQ(int64_t(i.saturate<8>().get(0)), std::clamp<int64_t>(x, 0, 255))
+        << x;
+  }
+}
+
+TEST(Int, DivConst) {
+  const auto x = Int<Neg<100>, Nat<999>>{Neg<57>{}};
+  const auto q = x / Nat<10>{};
+  EXPECT_TRUE(q.min == Neg<10>{});
+  EXPECT_TRUE(q.max == Nat<99>{});
+  EXPECT_EQ(q.get(0), 5); // -5
+
+  const auto r = x % Nat<10>{};
+  EXPECT_TRUE(r.min == Neg<9>{});
+  EXPECT_TRUE(r.max == Nat<9>{});
+  EXPECT_EQ(r.get(0), 2); // -7
+
+  const auto y = UInt(Bits<20>{999999}) / Nat<1000>{};
+  EXPECT_TRUE(y.max == Nat<1048>{});
+  EXPECT_EQ(y.get(0), 999);
+}
+
+TEST(Int, Constants) {
+  const auto x = Int<Neg<5>, Nat<20>>{Nat<13>{}};
+  const auto a = x + Nat<7>{};
+  EXPECT_TRUE(a.min == Nat<2>{});
+  EXPECT_TRUE(a.max == Nat<27>{});
+  EXPECT_EQ(value_of(a), 20);
+  const auto b = x - Nat<7>{};
+  EXPECT_TRUE(b.min == Neg<12>{});
+  EXPECT_EQ(value_of(b), 6);
+  EXPECT_EQ(value_of(x + Neg<20>{}), -7);
+  EXPECT_EQ(value_of(x - Neg<20>{}), 33);
+  static_assert(decltype(x + Nat<1000>{})::bitsize == decltype(x)::bitsize);
+
+  const auto m = x * Nat<10>{};
+  EXPECT_TRUE(m.min == Neg<50>{});
+  EXPECT_TRUE(m.max == Nat<200>{});
+  EXPECT_EQ(value_of(m), 130);
+  const auto n = x * Neg<3>{};
+  EXPECT_TRUE(n.min == Neg<60>{});
+  EXPECT_TRUE(n.max == Nat<15>{});
+  EXPECT_EQ(value_of(n), -39);
+  EXPECT_EQ(value_of(x * Nat<>{}), 0);
+
+  EXPECT_EQ(x.cmp(Nat<13>{}), Cmp::EQ);
+  EXPECT_EQ(x.cmp(Nat<12>{}), Cmp::GT);
+  EXPECT_EQ(x.cmp(Neg<2>{}), Cmp::GT);
+  EXPECT_EQ(x.cmp(Nat<14>{}), Cmp::LT);
+  EXPECT_TRUE(x == Nat<13>{});
+  EXPECT_FALSE(x == Neg<1>{});
+  EXPECT_TRUE((Int<Neg<5>, Nat<20>>{Neg<4>{}} == Neg<4>{}));
+  // outside [Min, Max] the answer is a constant
+  static_assert(Int<Neg<5>, Nat<20>>{}.cmp(Nat<21>{}) == Cmp::LT);
+  static_assert(Int<Neg<5>, Nat<20>>{}.cmp(Neg<6>{}) == Cmp::GT);
+  static_assert(!(Int<Neg<5>, Nat<20>>{} == Nat<100>{}));
+}
+
+TEST(Nat, Div) {
+  EXPECT_TRUE((Nat<42>{} / Nat<5>{}) == Nat<8>{});
+  EXPECT_TRUE((Nat<42>{} % Nat<5>{}) == Nat<2>{});
+  EXPECT_TRUE((Nat<>{} / Nat<5>{}) == Nat<>{});
+  EXPECT_TRUE((Nat<0, 0, 1>{} / Nat<0, 1>{}) == (Nat<0, 1>{}));
+  EXPECT_TRUE((Nat<7, 0, 1>{} % Nat<0, 1>{}) == Nat<7>{});
+  EXPECT_TRUE((Neg<42>{} / Nat<5>{}) == Neg<8>{});
+  EXPECT_TRUE((Neg<42>{} % Nat<5>{}) == Neg<2>{});
+  EXPECT_TRUE((Nat<42>{} / Neg<5>{}) == Neg<8>{});
+  EXPECT_TRUE((Neg<42>{} / Neg<5>{}) == Nat<8>{});
+}
+
+TEST(Nat, SubSigned) {
+  EXPECT_TRUE((Neg<20>{} - Nat<3>{}) == Neg<23>{});
+  EXPECT_TRUE((Nat<3>{} - Neg<20>{}) == Nat<23>{});
+  EXPECT_TRUE((Neg<20>{} - Neg<3>{}) == Neg<17>{});
+  EXPECT_TRUE((Neg<>{} - Nat<>{}) == Nat<>{});
+}
+
+TEST(Nat, Pow) {
+  EXPECT_TRUE(pow(Nat<3>{}, Nat<4>{}) == Nat<81>{});
+  EXPECT_TRUE(pow(Nat<2>{}, Nat<64>{}) == (Nat<0, 1>{}));
+  EXPECT_TRUE(pow(Nat<2>{}, Nat<200>{}) == (Nat<1>{} << Nat<200>{}));
+  EXPECT_TRUE(pow(Nat<10>{}, Nat<19>{}) == Nat<10000000000000000000ULL>{});
+  EXPECT_TRUE(pow(Nat<7>{}, Nat<>{}) == Nat<1>{});
+  EXPECT_TRUE(pow(Nat<>{}, Nat<>{}) == Nat<1>{});
+  EXPECT_TRUE(pow(Nat<>{}, Nat<5>{}) == Nat<>{});
+  EXPECT_TRUE(pow(Neg<2>{}, Nat<3>{}) == Neg<8>{});
+  EXPECT_TRUE(pow(Neg<2>{}, Nat<4>{}) == Nat<16>{});
+
+  const auto p = pow(Nat<~uint64_t(0)>{}, Nat<3>{});
+  EXPECT_TRUE(p == Nat<~uint64_t(0)>{} * Nat<~uint64_t(0)>{} *
+                       Nat<~uint64_t(0)>{});
+}
+
+TEST(Nat, Ilog2) {
+  EXPECT_TRUE(ilog2(Nat<1>{}) == Nat<0>{});
+  EXPECT_TRUE(ilog2(Nat<1000>{}) == Nat<9>{});
+  EXPECT_TRUE(ilog2(Nat<1024>{}) == Nat<10>{});
+  EXPECT_TRUE(ilog2(Nat<5, 0, 1>{}) == Nat<128>{});
+}
+
+TEST(Nat, Gcd) {
+  EXPECT_TRUE(gcd(Nat<12>{}, Nat<18>{}) == Nat<6>{});
+  EXPECT_TRUE(gcd(Nat<17>{}, Nat<5>{}) == Nat<1>{});
+  EXPECT_TRUE(gcd(Nat<>{}, Nat<9>{}) == Nat<9>{});
+  EXPECT_TRUE(gcd(Nat<9>{}, Nat<>{}) == Nat<9>{});
+  EXPECT_TRUE(gcd(Nat<>{}, Nat<>{}) == Nat<>{});
+  EXPECT_TRUE(gcd(Neg<12>{}, Nat<8>{}) == Nat<4>{});
+  EXPECT_TRUE(gcd(Neg<12>{}, Neg<30>{}) == Nat<6>{});
+  EXPECT_TRUE(gcd(Nat<0, 6>{}, Nat<0, 4>{}) == (Nat<0, 2>{}));
+  EXPECT_TRUE(gcd(pow(Nat<3>{}, Nat<50>{}), pow(Nat<6>{}, Nat<20>{})) ==
+              pow(Nat<3>{}, Nat<20>{}));
+}
+
 TEST(Nat, ShiftLeft) {
   EXPECT_TRUE((Nat<1>{} << Nat<3>{}) == Nat<8>{});
   EXPECT_TRUE((Nat<1>{} << Nat<64>{}) == (Nat<0, 1>{}));
@@ -412,6 +1953,313 @@ TEST(Nat, ShiftRight) {
   EXPECT_TRUE(((Nat<0, 1>{}) >> Nat<64>{}) == (Nat<1>{}));
 }
 
+TEST(PackedRecord, Fields) {
+  using Small = Int<Neg<4>, Nat<3>>;
+  using Rec = PackedRecord<Field<"a", Bits<3>>, Field<"b", Small>,
+                           Field<"c", UnsignedInt<60>>, Field<"d", Bits<1>>,
+                           Field<"e", Int<Nat<7>, Nat<7>>>>;
+  static_assert(Rec::WIDTH == 3 + 3 + 60 + 1);
+  static_assert(Rec::offset<2>() == 6);
+  static_assert(sizeof(Rec) == 2 * sizeof(uint64_t));
+
+  Rec r{Bits<3>{5}, Small{Neg<2>{}}, UInt(Bits<60>{0x123456789abcdef}),
+        Bits<1>{1}, Int<Nat<7>, Nat<7>>{}};
+  EXPECT_EQ(r.get<"a">().get(0), 5);
+  EXPECT_EQ(value_of(r.get<"b">()), -2);
+  EXPECT_EQ(r.get<"c">().get(0), 0x123456789abcdef);
+  EXPECT_EQ(r.get<"d">().get(0), 1);
+  EXPECT_TRUE(r.get<"e">().min == Nat<7>{});
+
+  r.set<"b">(Small{Nat<3>{}});
+  r.set<"a">(Bits<3>{2});
+  EXPECT_EQ(r.get<"a">().get(0), 2);
+  EXPECT_EQ(value_of(r.get<"b">()), 3);
+  EXPECT_EQ(r.get<"c">().get(0), 0x123456789abcdef);
+  EXPECT_EQ(r.get<"d">().get(0), 1);
+  r.set<"d">(Bits<1>{0});
+  EXPECT_EQ(r.get<"d">().get(0), 0);
+  EXPECT_EQ(r.get<"c">().get(0), 0x123456789abcdef);
+
+  // ten 6-bit fields in one word
+  using Six = Bits<6>;
+  using Ten = PackedRecord<Field<"0", Six>, Field<"1", Six>, Field<"2", Six>,
+                           Field<"3", Six>, Field<"4", Six>, Field<"5", Six>,
+                           Field<"6", Six>, Field<"7", Six>, Field<"8", Six>,
+                           Field<"9", Six>>;
+  static_assert(sizeof(Ten) == sizeof(uint64_t));
+  Ten t{};
+  t.set<"7">(Six{63});
+  t.set<"9">(Six{9});
+  EXPECT_EQ(t.get<"7">().get(0), 63);
+  EXPECT_EQ(t.get<"9">().get(0), 9);
+  EXPECT_EQ(t.get<"8">().get(0), 0);
+  EXPECT_EQ(t.bits.get(0), (uint64_t(9) << 54) | (uint64_t(63) << 42));
+}
+
+// bit i of a little endian or network order bit stream
+bool stream_bit(const std::vector<std::byte> &buf, const size_t i,
+                const bool big) {
+  const auto byte = uint8_t(buf[i / 8]);
+  return (byte >> (big ? 7 - i % 8 : i % 8)) & 1;
+}
+
+template <uint16_t N, std::endian E>
+void check_view(const std::vector<std::byte> &buf, const size_t offset) {
+  constexpr bool big = E == std::endian::big;
+  const BitsView<N, E> v{std::span{buf}, offset};
+  const Bits<N> b = v.load();
+  for (uint16_t j = 0; j < N; j++) {
+    // big endian streams hold the most significant bit first
+    const size_t pos = big ? offset + N - 1 - j : offset + j;
+    ASSERT_EQ(b.get(j / 64) >> (j % 64) & 1, stream_bit(buf, pos, big))
+        << N << " bits at " << offset << ", bit " << j;
+  }
+  EXPECT_EQ(v.cmp(b), Cmp::EQ);
+  EXPECT_EQ((v.template extract<N - 1, N / 2>()),
+            (b.template extract<N - 1, N / 2>()));
+}
+
+TEST(BitsView, Load) {
+  std::vector<std::byte> buf(64);
+  uint64_t s = 7;
+  for (auto &c : buf) {
+    s = s * 6364136223846793005ULL + 1442695040888963407ULL;
+    c = std::byte(s >> 56);
+  }
+  for (size_t offset : {0, 1, 7, 8, 13, 64, 101}) {
+    check_view<1, std::endian::little>(buf, offset);
+    check_view<8, std::endian::little>(buf, offset);
+    check_view<61, std::endian::little>(buf, offset);
+    check_view<64, std::endian::little>(buf, offset);
+    check_view<200, std::endian::little>(buf, offset);
+    check_view<1, std::endian::big>(buf, offset);
+    check_view<8, std::endian::big>(buf, offset);
+    check_view<61, std::endian::big>(buf, offset);
+    check_view<64, std::endian::big>(buf, offset);
+    check_view<200, std::endian::big>(buf, offset);
+  }
+  // a buffer that ends with the value, nothing past it is read
+  const std::vector<std::byte> tight(buf.begin(), buf.begin() + 26);
+  check_view<200, std::endian::little>(tight, 5);
+  check_view<200, std::endian::big>(tight, 5);
+  check_view<3, std::endian::big>(tight, 205);
+
+  // an IPv4 header: version 4, IHL 5, total length 0x1234
+  const std::vector<std::byte> ip{std::byte{0x45}, std::byte{0},
+                                  std::byte{0x12}, std::byte{0x34}};
+  const BitsView<32, std::endian::big> hdr{std::span{ip}};
+  EXPECT_EQ((hdr.extract<31, 28>()), Bits<4>{4});
+  EXPECT_EQ((hdr.extract<27, 24>()), Bits<4>{5});
+  EXPECT_EQ((hdr.extract<15, 0>()), Bits<16>{0x1234});
+  EXPECT_EQ((BitsView<4, std::endian::big>{std::span{ip}, 4}.load()),
+            Bits<4>{5});
+  EXPECT_EQ((hdr.view<15, 0>().cmp(Bits<16>{0x1235})), Cmp::LT);
+  EXPECT_EQ((hdr.view<15, 0>() + Bits<16>{0xedcc}), Bits<17>{0x10000});
+}
+
+// stores a value at offset in a buffer that ends with it, the bits around
+// the value are unchanged
+template <uint16_t N, std::endian E> void check_store(const size_t offset) {
+  constexpr bool big = E == std::endian::big;
+  const size_t end = offset / 8 + BitsRef<N, E>::bytes_for(offset);
+  std::vector<std::byte> buf(end, std::byte{0xa5});
+  const auto before = buf;
+  const Bits<N> v{pseudo_random_limbs<Bits<N>::LIMBS>(offset + N)};
+  const BitsRef<N, E> r{std::span{buf}, offset};
+  r = v;
+  EXPECT_EQ(r.load(), v) << N << " bits at " << offset;
+  for (size_t i = 0; i < 8 * end; i++) {
+    if (i < offset || i >= offset + N) {
+      ASSERT_EQ(stream_bit(buf, i, big), stream_bit(before, i, big))
+          << N << " bits at " << offset << ", bit " << i;
+    }
+  }
+}
+
+TEST(BitsView, Store) {
+  for (const size_t offset : {0, 1, 5, 8, 11, 63, 64, 70}) {
+    check_store<1, std::endian::little>(offset);
+    check_store<37, std::endian::little>(offset);
+    check_store<64, std::endian::little>(offset);
+    check_store<200, std::endian::little>(offset);
+    check_store<1, std::endian::big>(offset);
+    check_store<37, std::endian::big>(offset);
+    check_store<64, std::endian::big>(offset);
+    check_store<200, std::endian::big>(offset);
+  }
+}
+
+template <typename T> std::string text(const T &v, const int base = 10) {
+  char buf[5000];
+  const auto r = to_chars(buf, buf + sizeof(buf), v, base);
+  EXPECT_EQ(r.ec, std::errc{});
+  return std::string(buf, r.ptr);
+}
+
+template <typename T> T parse(const std::string &s, const int base = 10) {
+  T v{};
+  const auto r = from_chars(s.data(), s.data() + s.size(), v, base);
+  EXPECT_EQ(r.ec, std::errc{}) << s;
+  EXPECT_EQ(r.ptr, s.data() + s.size()) << s;
+  return v;
+}
+
+template <uint16_t N> void check_round_trip(const uint64_t seed) {
+  const Bits<N> x{pseudo_random_limbs<Bits<N>::LIMBS>(seed)};
+  for (const int base : {2, 3, 8, 10, 16, 32, 36}) {
+    const std::string s = text(x, base);
+    EXPECT_EQ(parse<Bits<N>>(s, base), x) << N << " base " << base;
+    EXPECT_TRUE(s == "0" || s[0] != '0') << s;
+  }
+  // the divide and conquer path against one short division per chunk
+  std::array<uint64_t, max_chunks(Bits<N>::LIMBS)> chunks;
+  char buf[5000];
+  const uint16_t count =
+      short_chunks<Bits<N>::LIMBS>(x.limbs, chunks.data(), Divisor{TEN19});
+  const auto r = chunks_to_chars(buf, buf + sizeof(buf), chunks.data(), count,
+                                 10, 19, false);
+  EXPECT_EQ(text(x), std::string(buf, r.ptr)) << N;
+}
+
+TEST(Text, Bits) {
+  EXPECT_EQ(text(Bits<0>{}), "0");
+  EXPECT_EQ(text(Bits<1>{1}), "1");
+  EXPECT_EQ(text(Bits<64>{~uint64_t(0)}), "18446744073709551615");
+  EXPECT_EQ(text(Bits<64>{~uint64_t(0)}, 16), "ffffffffffffffff");
+  EXPECT_EQ(text(Bits<12>{0xabc}, 16), "abc");
+  EXPECT_EQ(text(Bits<12>{5}, 2), "101");
+  EXPECT_EQ(text(Bits<12>{0777}, 8), "777");
+  EXPECT_EQ(text(Bits<129>{1}.shl<128>().trim<129>()),
+            "340282366920938463463374607431768211456");
+  EXPECT_EQ(text(Bits<129>{1}.shl<128>().trim<129>(), 16),
+            "1" + std::string(32, '0'));
+  EXPECT_EQ(text(Bits<70>{1}.shl<64>().trim<70>(), 2),
+            "1" + std::string(64, '0'));
+
+  // 10^k - 1, 10^k and 10^k + 1 around every chunk and split boundary
+  for (int k = 1; k < 1200; k++) {
+    const std::string ten = "1" + std::string(k, '0');
+    EXPECT_EQ(text(parse<Bits<4096>>(ten)), ten);
+    const std::string nines(k, '9');
+    EXPECT_EQ(text(parse<Bits<4096>>(nines)), nines);
+    EXPECT_EQ(text(parse<Bits<4096>>(ten.substr(0, k) + "1")),
+              ten.substr(0, k) + "1");
+  }
+
+  check_round_trip<1>(1);
+  check_round_trip<63>(2);
+  check_round_trip<64>(3);
+  check_round_trip<65>(4);
+  check_round_trip<128>(5);
+  check_round_trip<577>(6);
+  check_round_trip<1024>(7);
+  check_round_trip<4096>(8);
+  check_round_trip<4000>(9);
+
+  // uppercase only where a format asks for it
+  char buf[64];
+  const uint64_t v[] = {0xabcdef0123456789ull, 0x1f};
+  auto r = limbs_to_chars<2>(buf, buf + sizeof(buf), v, 16, true);
+  EXPECT_EQ(std::string(buf, r.ptr), "1FABCDEF0123456789");
+  r = limbs_to_chars<2>(buf, buf + sizeof(buf), v, 36, true);
+  std::string upper = text(Bits<128>{Bits<128>::Limbs{v[0], v[1]}}, 36);
+  for (auto &c : upper) {
+    c = char(std::toupper(c));
+  }
+  EXPECT_EQ(std::string(buf, r.ptr), upper);
+}
+
+TEST(Text, Errors) {
+  char small[3];
+  const Bits<12> x{1000};
+  auto r = to_chars(small, small + sizeof(small), x);
+  EXPECT_EQ(r.ec, std::errc::value_too_large);
+  EXPECT_EQ(r.ptr, small + sizeof(small));
+  r = to_chars(small, small + sizeof(small), x, 16);
+  EXPECT_EQ(r.ec, std::errc{});
+
+  Bits<8> b{7};
+  const std::string big = "256";
+  auto p = from_chars(big.data(), big.data() + big.size(), b);
+  EXPECT_EQ(p.ec, std::errc::result_out_of_range);
+  EXPECT_EQ(p.ptr, big.data() + 3);
+  EXPECT_EQ(b, Bits<8>{7});
+
+  const std::string bad = "-5";
+  p = from_chars(bad.data(), bad.data() + bad.size(), b);
+  EXPECT_EQ(p.ec, std::errc::invalid_argument);
+  EXPECT_EQ(p.ptr, bad.data());
+
+  const std::string tail = "00255xyz";
+  p = from_chars(tail.data(), tail.data() + tail.size(), b);
+  EXPECT_EQ(p.ec, std::errc{});
+  EXPECT_EQ(p.ptr, tail.data() + 5);
+  EXPECT_EQ(b, Bits<8>{255});
+
+  const std::string hex = "1ff";
+  p = from_chars(hex.data(), hex.data() + hex.size(), b, 16);
+  EXPECT_EQ(p.ec, std::errc::result_out_of_range);
+  EXPECT_EQ(parse<Bits<9>>(hex, 16), Bits<9>{511});
+  EXPECT_EQ(parse<Bits<0>>("000"), Bits<0>{});
+}
+
+TEST(Text, Int) {
+  using I = Int<Neg<1000>, Nat<100000>>;
+  EXPECT_EQ(text(I{Neg<1000>{}}), "-1000");
+  EXPECT_EQ(text(I{Nat<100000>{}}), "100000");
+  EXPECT_EQ(text(I{Nat<>{}}), "0");
+  EXPECT_EQ(text(SignedInt<64>{Bits<64>{1}, true}, 16),
+            "-7fffffffffffffff");
+  EXPECT_EQ(text(UnsignedInt<64>{Nat<~uint64_t(0)>{}}), "18446744073709551615");
+
+  for (const char *s : {"-1000", "-999", "-1", "0", "1", "99999", "100000"}) {
+    EXPECT_EQ(text(parse<I>(s)), s);
+  }
+  for (const std::string s : {"-1001", "100001", "-99999999999999999999999"}) {
+    I v{Nat<7>{}};
+    const auto r = from_chars(s.data(), s.data() + s.size(), v);
+    EXPECT_EQ(r.ec, std::errc::result_out_of_range) << s;
+    EXPECT_EQ(r.ptr, s.data() + s.size());
+    EXPECT_EQ(value_of(v), 7);
+  }
+  const std::string minus = "-";
+  I v{};
+  EXPECT_EQ(from_chars(minus.data(), minus.data() + 1, v).ec,
+            std::errc::invalid_argument);
+
+  using Positive = Int<Nat<10>, Nat<20>>;
+  EXPECT_EQ(value_of(parse<Positive>("15")), 15);
+  Positive pv{Nat<12>{}};
+  const std::string nine = "9";
+  EXPECT_EQ(from_chars(nine.data(), nine.data() + 1, pv).ec,
+            std::errc::result_out_of_range);
+  const std::string neg = "-0";
+  EXPECT_EQ(value_of(parse<I>(neg)), 0);
+}
+
+TEST(Text, Nat) {
+  EXPECT_EQ(text(Nat<>{}), "0");
+  EXPECT_EQ(text(Nat<0, 1>{}), "18446744073709551616");
+  EXPECT_EQ(text(Neg<5>{}), "-5");
+  EXPECT_EQ(text(Neg<>{}), "0");
+  EXPECT_EQ(text(Nat<255>{}, 2), "11111111");
+}
+
+TEST(Text, Stream) {
+  std::ostringstream os;
+  os << Bits<129>{1}.shl<128>().trim<129>() << " " << Bits<0>{} << " "
+     << Int<Neg<1000>, Nat<100000>>{Neg<1000>{}} << " " << Nat<0, 1>{} << " "
+     << Neg<3>{};
+  EXPECT_EQ(os.str(),
+            "340282366920938463463374607431768211456 0 -1000 "
+            "18446744073709551616 -3");
+  std::ostringstream hex;
+  hex << std::hex << Bits<12>{0xabc} << " " << std::showbase << std::uppercase
+      << Bits<12>{0xabc} << " " << Bits<12>{0} << " " << std::oct
+      << Bits<12>{8};
+  EXPECT_EQ(hex.str(), "abc 0XABC 0 010");
+}
+
 TEST(UnsignedInt, Simple) {
   const UnsignedInt<0> u0{};
   EXPECT_TRUE(u0.min == Nat<>{});
@@ -465,6 +2313,35 @@ TEST(SignedInt, Simple) {
   }
 }
 
+TEST(SignedInt, Compare) {
+  for (int i = 0; i < 256; i++) {
+    for (int j = 0; j < 256; j += 5) {
+      const auto a = SInt(Bits<8>{uint64_t(i)});
+      const auto b = SInt(Bits<8>{uint64_t(j)});
+      EXPECT_EQ(a.cmp(b), cmp(int8_t(i), int8_t(j)));
+      EXPECT_EQ(a < b, int8_t(i) < int8_t(j));
+      EXPECT_EQ(a >= b, int8_t(i) >= int8_t(j));
+      EXPECT_EQ(a == b, i == j);
+    }
+  }
+
+  // different ranges compare values
+  const auto x = Int<Neg<5>, Nat<20>>{Nat<13>{}};
+  const auto y = Int<Nat<3>, Nat<40>>{Nat<13>{}};
+  const auto z = Int<Neg<40>, Neg<2>>{Neg<3>{}};
+  EXPECT_TRUE(x == y);
+  EXPECT_EQ(x.cmp(y), Cmp::EQ);
+  EXPECT_TRUE(z < x);
+  EXPECT_TRUE(y > z);
+  EXPECT_TRUE(x <= Nat<13>{});
+  EXPECT_TRUE(x > Neg<1>{});
+  EXPECT_EQ(SInt(Bits<64>{~0ULL}) <=> SInt(Bits<3>{1}),
+            std::strong_ordering::less);
+  // disjoint ranges are ordered at compile time
+  static_assert(Int<Nat<0>, Nat<7>>{}.cmp(Int<Nat<8>, Nat<9>>{Nat<8>{}}) ==
+                Cmp::LT);
+}
+
 TEST(Inspect, all) {
   const auto n12 = add(Nat<5>{}, Nat<7>{});
   EXPECT_EQ(n12.get(0), 12);
@@ -1,5 +1,10 @@
 #pragma once
 
+#include <array>
+#include <bit>
+#include <cassert>
+#include <compare>
+#include <cstddef>
 #include <cstdint>
 #include <cstdio>
 // #include <format>
@@ -8,44 +13,81 @@
 #include <type_traits>
 #include <utility>
 
+#include "charconv.h"
 #include "common.h"
+#include "limbs.h"
 #include "nat.h"
 
 namespace mango {
 
 template <uint16_t N> struct Bits;
+template <typename Min, typename Max> struct Int;
+
+// number of 64-bit limbs needed to hold n bits
+constexpr uint16_t limb_count(const uint16_t n) noexcept {
+  return uint16_t((uint32_t(n) + 63) / 64);
+}
+
+// largest power of two (up to a cache line) that divides the storage size,
+// wide values get vector alignment without adding padding
+constexpr size_t limb_alignment(const uint16_t n) noexcept {
+  const size_t bytes = size_t(limb_count(n)) * sizeof(uint64_t);
+  size_t a = alignof(uint64_t);
+  while ((a < 64) && (bytes % (2 * a) == 0)) {
+    a *= 2;
+  }
+  return a;
+}
 
 ///////////////
 // BitsState //
 ///////////////
 
+// Limbs are stored in one flat, little endian array. Bits at and above WIDTH
+// are always zero so operations never need to re-mask their inputs.
+
 template <uint16_t N> struct BitsState {
   constexpr static uint16_t WIDTH = N;
   constexpr static uint16_t SLACK = (N > 64) ? 0 : 64 - N;
   constexpr static uint64_t MASK =
       (SLACK == 0) ? ~uint64_t{0} : (uint64_t(1) << WIDTH) - 1;
+  constexpr static uint16_t LIMBS = limb_count(N);
+  constexpr static uint64_t TOP_MASK =
+      (N % 64 == 0) ? ~uint64_t{0} : (uint64_t(1) << (N % 64)) - 1;
 
-  const uint64_t low;
-  const Bits<safe_sub(N, 64)> high;
+  alignas(limb_alignment(N)) uint64_t limbs[LIMBS]{};
 
-  constexpr BitsState(const uint64_t v) noexcept;
+  constexpr BitsState(const uint64_t v) noexcept { limbs[0] = v & MASK; }
 
-  constexpr BitsState(const Bits<safe_sub(N, 64)> &high_, const uint64_t low_)
-      : low(low_ & MASK), high(high_) {}
+  constexpr BitsState(const Bits<safe_sub(N, 64)> &high_,
+                      const uint64_t low_) noexcept {
+    limbs[0] = low_ & MASK;
+    for (uint16_t i = 1; i < LIMBS; i++) {
+      limbs[i] = high_.get(i - 1);
+    }
+  }
+
+  constexpr explicit BitsState(
+      const std::array<uint64_t, LIMBS> &limbs_) noexcept {
+    for (uint16_t i = 0; i < LIMBS; i++) {
+      limbs[i] = limbs_[i];
+    }
+    limbs[LIMBS - 1] &= TOP_MASK;
+  }
 
   template <uint16_t M>
-  constexpr BitsState(const BitsState<M> &rhs)
-      : low(rhs.get_low() & MASK), high(rhs.get_high()) {}
+  constexpr BitsState(const BitsState<M> &rhs) noexcept {
+    for (uint16_t i = 0; i < LIMBS; i++) {
+      limbs[i] = rhs.get(i);
+    }
+    limbs[LIMBS - 1] &= TOP_MASK;
+  }
 
-  constexpr uint64_t get_low() const noexcept { return low; }
-  constexpr auto get_high() const noexcept { return high; }
+  constexpr uint64_t get_low() const noexcept { return limbs[0]; }
+  constexpr Bits<safe_sub(N, 64)> get_high() const noexcept;
 
   constexpr uint64_t get(uint64_t i) const noexcept {
-    if (i == 0) {
-      return low & MASK;
-    } else {
-      high.get(i - 1);
-    }
+    return (i < LIMBS) ? limbs[i] : 0;
   }
 };
 
@@ -57,11 +99,15 @@ template <> struct BitsState<0> {
   constexpr static uint16_t WIDTH = 0;
   constexpr static uint16_t SLACK = 64;
   constexpr static uint64_t MASK = 0;
+  constexpr static uint16_t LIMBS = 0;
+  constexpr static uint64_t TOP_MASK = 0;
 
   constexpr BitsState(const uint64_t) noexcept {}
 
   constexpr BitsState(const Bits<0> &, const uint64_t) noexcept {}
 
+  constexpr explicit BitsState(const std::array<uint64_t, 0> &) noexcept {}
+
   template <uint16_t M> constexpr BitsState(const BitsState<M> &) {}
 
   constexpr uint64_t get(uint64_t) const noexcept { return 0; }
@@ -69,6 +115,131 @@ template <> struct BitsState<0> {
   constexpr const Bits<0> get_high() const noexcept;
 };
 
+///////////////
+// Constants //
+///////////////
+
+// the low L limbs of a constant, zero padded
+template <uint16_t L, uint64_t... Vs>
+consteval std::array<uint64_t, L> constant_limbs(const Nat<Vs...>) noexcept {
+  constexpr uint64_t vs[] = {Vs..., 0};
+  std::array<uint64_t, L> out{};
+  for (uint16_t i = 0; i < L && i < sizeof...(Vs); i++) {
+    out[i] = vs[i];
+  }
+  return out;
+}
+
+// C as a sum of signed powers of two in non-adjacent form, the fewest terms
+// of any such sum: C = sum((negative ? -1 : 1) 2^shift)
+template <typename C> struct ShiftAdd;
+
+template <uint64_t... Cs> struct ShiftAdd<Nat<Cs...>> {
+  struct Term {
+    uint16_t shift;
+    bool negative;
+  };
+
+  // one spare limb for the carry out of c + 1
+  constexpr static uint16_t L = sizeof...(Cs) + 1;
+
+  struct Terms {
+    uint16_t count;
+    std::array<Term, 64 * L> terms;
+  };
+
+  constexpr static Terms naf = [] {
+    std::array<uint64_t, L> c = constant_limbs<L>(Nat<Cs...>{});
+    Terms out{};
+    for (uint16_t p = 0; limbs_used<L>(c.data()) != 0; p++) {
+      if ((c[0] & 1) != 0) {
+        // the digit is 1 when c = 1 mod 4 and -1 when c = 3 mod 4, either
+        // way the next bit of c - digit is 0
+        const bool negative = (c[0] & 2) != 0;
+        if (negative) {
+          const std::array<uint64_t, 1> one{1};
+          add_limbs<L, 1>(c.data(), one.data());
+        } else {
+          c[0] ^= 1;
+        }
+        out.terms[out.count++] = {p, negative};
+      }
+      for (uint16_t i = 0; i < L; i++) {
+        c[i] = (c[i] >> 1) | ((i + 1 < L) ? (c[i + 1] << 63) : 0);
+      }
+    }
+    return out;
+  }();
+
+  constexpr static uint16_t COUNT = naf.count;
+
+  constexpr static Term term(const uint16_t i) noexcept {
+    return naf.terms[i];
+  }
+};
+
+////////////////
+// Reciprocal //
+////////////////
+
+// x / D == (x * multiplier) >> SHIFT for every N-bit x
+//
+// multiplier = ceil(2^SHIFT / D) with the smallest SHIFT for which
+// multiplier * D - 2^SHIFT <= 2^(SHIFT - N) (Granlund and Montgomery), such a
+// SHIFT always exists below N + bit_size(D)
+template <uint16_t N, typename D> struct Reciprocal;
+
+template <uint16_t N, uint64_t... Ds> struct Reciprocal<N, Nat<Ds...>> {
+  constexpr static uint16_t DB = Nat<Ds...>{}.bit_size();
+  constexpr static uint16_t LD = sizeof...(Ds);
+  constexpr static uint16_t L = limb_count(N + DB + 1);
+
+  struct Magic {
+    uint16_t shift;
+    std::array<uint64_t, L> multiplier;
+  };
+
+  constexpr static Magic magic = [] {
+    constexpr std::array<uint64_t, LD> d{Ds...};
+    for (uint16_t p = N;; p++) {
+      std::array<uint64_t, L> pow2{};
+      pow2[p / 64] = uint64_t(1) << (p % 64);
+      std::array<uint64_t, L> m{};
+      std::array<uint64_t, LD> r{};
+      divmod_limbs<L, LD>(pow2.data(), d.data(), m.data(), r.data());
+      if (limbs_used<LD>(r.data()) == 0) {
+        return Magic{p, m};
+      }
+      // m = ceil(2^p / D), error = m * D - 2^p = D - r
+      const std::array<uint64_t, L> one{1};
+      add_limbs<L, L>(m.data(), one.data());
+      std::array<uint64_t, LD> error = d;
+      sub_limbs<LD, LD>(error.data(), r.data());
+      // error <= 2^(p - N)
+      std::array<uint64_t, LD + 1> bound{};
+      bound[(p - N) / 64] = uint64_t(1) << ((p - N) % 64);
+      sub_limbs<LD + 1, LD>(bound.data(), error.data());
+      if ((bound[LD] >> 63) == 0) {
+        return Magic{p, m};
+      }
+    }
+  }();
+
+  constexpr static uint16_t SHIFT = magic.shift;
+  constexpr static uint16_t MULTIPLIER_BITS = [] {
+    const uint16_t used = limbs_used<L>(magic.multiplier.data());
+    return uint16_t(64 * used - std::countl_zero(magic.multiplier[used - 1]));
+  }();
+
+  constexpr static Bits<MULTIPLIER_BITS> multiplier = [] {
+    typename Bits<MULTIPLIER_BITS>::Limbs out{};
+    for (uint16_t i = 0; i < out.size(); i++) {
+      out[i] = magic.multiplier[i];
+    }
+    return Bits<MULTIPLIER_BITS>{out};
+  }();
+};
+
 /////////////
 // Bits<N> //
 /////////////
@@ -77,6 +248,10 @@ template <uint16_t N> struct Bits : public BitsState<N> {
   constexpr static uint16_t WIDTH = BitsState<N>::WIDTH;
   constexpr static uint16_t SLACK = BitsState<N>::SLACK;
   constexpr static uint64_t MASK = BitsState<N>::MASK;
+  constexpr static uint16_t LIMBS = BitsState<N>::LIMBS;
+  constexpr static uint64_t TOP_MASK = BitsState<N>::TOP_MASK;
+
+  using Limbs = std::array<uint64_t, LIMBS>;
 
   constexpr Bits() : BitsState<N>(0) {}
 
@@ -87,6 +262,9 @@ template <uint16_t N> struct Bits : public BitsState<N> {
   constexpr Bits(const Bits<safe_sub(N, 64)> &high_, const uint64_t low_)
       : BitsState<N>(high_, low_) {}
 
+  // bits above WIDTH in the top limb are dropped
+  constexpr explicit Bits(const Limbs &limbs_) : BitsState<N>(limbs_) {}
+
   template <uint16_t M>
   constexpr Bits(const Bits<M> &rhs) : BitsState<N>(rhs) {}
 
@@ -94,11 +272,34 @@ template <uint16_t N> struct Bits : public BitsState<N> {
     if constexpr (N == 0) {
       return 0;
     } else {
-      if (i == 0) {
-        return this->get_low();
-      } else {
-        return this->get_high().get(i - 1);
-      }
+      return (i < LIMBS) ? this->limbs[i] : 0;
+    }
+  }
+
+  // limb i of (*this >> S)
+  template <uint32_t S>
+  constexpr uint64_t shr_limb(const uint16_t i) const noexcept {
+    constexpr uint16_t q = S / 64;
+    constexpr uint16_t r = S % 64;
+    if constexpr (r == 0) {
+      return get(i + q);
+    } else {
+      return (get(i + q) >> r) | (get(i + q + 1) << (64 - r));
+    }
+  }
+
+  // limb i of (*this << S)
+  template <uint32_t S>
+  constexpr uint64_t shl_limb(const uint16_t i) const noexcept {
+    constexpr uint16_t q = S / 64;
+    constexpr uint16_t r = S % 64;
+    if (i < q) {
+      return 0;
+    } else if constexpr (r == 0) {
+      return get(i - q);
+    } else {
+      const uint64_t carried = (i > q) ? (get(i - q - 1) >> (64 - r)) : 0;
+      return (get(i - q) << r) | carried;
     }
   }
 
@@ -120,65 +321,210 @@ template <uint16_t N> struct Bits : public BitsState<N> {
 
   template <uint16_t M, uint64_t carry_in>
   constexpr AddType<M, carry_in> add(const Bits<M> &rhs) const noexcept {
-    if constexpr (carry_in == 0) {
-      if constexpr (M == 0) {
-        return *this;
-      } else if (N == 0) {
-        return rhs;
+    if constexpr ((carry_in == 0) && (M == 0)) {
+      return *this;
+    } else if constexpr ((carry_in == 0) && (N == 0)) {
+      return rhs;
+    } else {
+      using Out = AddType<M, carry_in>;
+      typename Out::Limbs out{};
+      uint64_t carry = carry_in;
+#pragma GCC unroll 128
+      for (uint16_t i = 0; i < Out::LIMBS; i++) {
+        out[i] = addc(get(i), rhs.get(i), carry, carry);
       }
+      return Out{out};
     }
+  }
 
-    const auto low_left = this->get_low();
-    const auto low_out = low_left + rhs.get_low() + carry_in;
-    const uint64_t carry_out = (low_out < low_left) ? 1 : 0;
+  template <uint16_t Shift>
+  constexpr Bits<safe_sub(N, Shift)> shr() const noexcept {
+    if constexpr (Shift == 0) {
+      return *this;
+    } else if constexpr (Shift >= N) {
+      return Bits<0>{};
+    } else {
+      using Out = Bits<safe_sub(N, Shift)>;
+      typename Out::Limbs out{};
+      for (uint16_t i = 0; i < Out::LIMBS; i++) {
+        out[i] = shr_limb<Shift>(i);
+      }
+      return Out{out};
+    }
+  }
 
-    if constexpr (AddType<M, carry_in>::SLACK == 0) {
-      if (carry_out) {
-        return {
-            this->get_high().template add<safe_sub(M, 64), 1>(rhs.get_high()),
-            low_out};
+  template <uint16_t Shift>
+  constexpr Bits<N + Shift> shl() const noexcept {
+    if constexpr (Shift == 0) {
+      return *this;
+    } else {
+      using Out = Bits<N + Shift>;
+      typename Out::Limbs out{};
+      for (uint16_t i = 0; i < Out::LIMBS; i++) {
+        out[i] = shl_limb<Shift>(i);
       }
+      return Out{out};
     }
-    return {this->get_high().template add<safe_sub(M, 64), 0>(rhs.get_high()),
-            low_out};
+  }
+
+  // Shifts and rotates by a runtime amount. The amount is an Int within
+  // [0, N - 1] so no range checks are needed and left shifts can still grow
+  // the result to hold every shifted out bit.
+
+  template <typename Min, typename Max>
+    requires(Min{}.cmp(Nat<>{}) != Cmp::LT) && (Max{}.cmp(Nat<N>{}) == Cmp::LT)
+  constexpr Bits<N + Max{}.get(0)>
+  shl(const Int<Min, Max> &amount) const noexcept {
+    return shl_by<N + Max{}.get(0)>(amount.biased_bits.get(0) + Min{}.get(0));
+  }
+
+  template <typename Min, typename Max>
+    requires(Min{}.cmp(Nat<>{}) != Cmp::LT) && (Max{}.cmp(Nat<N>{}) == Cmp::LT)
+  constexpr Bits<N> shr(const Int<Min, Max> &amount) const noexcept {
+    return shr_by(amount.biased_bits.get(0) + Min{}.get(0));
+  }
+
+  template <typename Min, typename Max>
+    requires(Min{}.cmp(Nat<>{}) != Cmp::LT) && (Max{}.cmp(Nat<N>{}) == Cmp::LT)
+  constexpr Bits<N> rotr(const Int<Min, Max> &amount) const noexcept {
+    return rotr_by(amount.biased_bits.get(0) + Min{}.get(0));
+  }
+
+  template <typename Min, typename Max>
+    requires(Min{}.cmp(Nat<>{}) != Cmp::LT) && (Max{}.cmp(Nat<N>{}) == Cmp::LT)
+  constexpr Bits<N> rotl(const Int<Min, Max> &amount) const noexcept {
+    const uint64_t s = amount.biased_bits.get(0) + Min{}.get(0);
+    return rotr_by((s == 0) ? 0 : N - s);
   }
 
   template <uint16_t Shift>
-  constexpr Bits<safe_sub(N, Shift)> shr() const noexcept {
-    const auto l = this->get_low();
-    const auto h = this->get_high();
+    requires(Shift < N)
+  constexpr Bits<N> rotr() const noexcept {
+    return rotr_by(Shift);
+  }
 
-    if constexpr (Shift == 0) {
+  template <uint16_t Shift>
+    requires(Shift < N)
+  constexpr Bits<N> rotl() const noexcept {
+    return rotr_by((Shift == 0) ? 0 : N - Shift);
+  }
+
+  // *this >> s for s <= N
+  constexpr Bits<N> shr_by(const uint64_t s) const noexcept {
+    if constexpr (N == 0) {
       return *this;
-    } else if constexpr (Shift >= N) {
-      return Bits<0>{};
-    } else if constexpr (N <= 64) {
-      return {l >> Shift};
-    } else if constexpr (Shift >= 64) {
-      return h.template shr<Shift - 64>();
+    } else if constexpr (LIMBS == 1) {
+      return Bits<N>{(s == 64) ? 0 : (this->limbs[0] >> s)};
+    } else {
+      // zero limbs above the value absorb the largest limb offset
+      std::array<uint64_t, 2 * LIMBS + 1> padded{};
+      for (uint16_t i = 0; i < LIMBS; i++) {
+        padded[i] = this->limbs[i];
+      }
+      const uint64_t q = s / 64;
+      const uint64_t r = s % 64;
+      Limbs out{};
+      for (uint16_t i = 0; i < LIMBS; i++) {
+        out[i] = funnel_shr(padded[i + q + 1], padded[i + q], r);
+      }
+      return Bits<N>{out};
+    }
+  }
+
+  // (*this << s) truncated to W bits, for s <= W
+  template <uint16_t W>
+  constexpr Bits<W> shl_by(const uint64_t s) const noexcept {
+    if constexpr ((N == 0) || (W == 0)) {
+      return Bits<W>{};
+    } else if constexpr (Bits<W>::LIMBS == 1) {
+      return Bits<W>{(s == 64) ? 0 : (this->limbs[0] << s)};
+    } else {
+      // zero limbs below the value absorb the largest limb offset
+      constexpr uint16_t LEAD = W / 64 + 1;
+      std::array<uint64_t, LEAD + Bits<W>::LIMBS> padded{};
+      for (uint16_t i = 0; i < min(LIMBS, Bits<W>::LIMBS); i++) {
+        padded[LEAD + i] = this->limbs[i];
+      }
+      const uint64_t q = s / 64;
+      const uint64_t r = s % 64;
+      typename Bits<W>::Limbs out{};
+      for (uint16_t i = 0; i < Bits<W>::LIMBS; i++) {
+        out[i] =
+            funnel_shl(padded[LEAD + i - q], padded[LEAD + i - q - 1], r);
+      }
+      return Bits<W>{out};
+    }
+  }
+
+  // *this rotated right by s < N
+  constexpr Bits<N> rotr_by(const uint64_t s) const noexcept {
+    if constexpr (N == 0) {
+      return *this;
+    } else if constexpr (N == 64) {
+      return Bits<N>{std::rotr(this->limbs[0], int(s))};
+    } else if constexpr (LIMBS == 1) {
+      const uint64_t v = this->limbs[0];
+      return Bits<N>{(v >> s) | ((v << 1) << (N - 1 - s))};
+    } else if constexpr (N % 64 == 0) {
+      // limb offsets wrap around, read them from two copies of the value
+      std::array<uint64_t, 2 * LIMBS> twice{};
+      for (uint16_t i = 0; i < LIMBS; i++) {
+        twice[i] = this->limbs[i];
+        twice[LIMBS + i] = this->limbs[i];
+      }
+      const uint64_t q = s / 64;
+      const uint64_t r = s % 64;
+      Limbs out{};
+      for (uint16_t i = 0; i < LIMBS; i++) {
+        out[i] = funnel_shr(twice[i + q + 1], twice[i + q], r);
+      }
+      return Bits<N>{out};
     } else {
-      static_assert(Shift < 64);
-      static_assert(N > 64);
-      return {h.template shr<Shift>(),
-              (h.get_low() << (64 - Shift)) | (l >> Shift)};
+      const Bits<N> low = shr_by(s);
+      const Bits<N> high = shl_by<N>(N - s);
+      Limbs out{};
+      for (uint16_t i = 0; i < LIMBS; i++) {
+        out[i] = low.limbs[i] | high.limbs[i];
+      }
+      return Bits<N>{out};
     }
   }
 
   template <uint16_t High, uint64_t Low>
     requires(High >= Low) && (High < N)
   constexpr Bits<High - Low + 1> extract() const noexcept {
-    if constexpr (Low > 64) {
-      return this->get_high().template extract<High - 64, Low - 64>();
-    } else {
-      return {this->shr<Low>()};
+    using Out = Bits<High - Low + 1>;
+    typename Out::Limbs out{};
+    for (uint16_t i = 0; i < Out::LIMBS; i++) {
+      out[i] = shr_limb<Low>(i);
     }
+    return Out{out};
   }
 
   constexpr bool is_signed() const noexcept {
     if constexpr (N == 0)
       return false;
     else
-      return extract<N - 1, N - 1>().low == 1;
+      return ((this->limbs[LIMBS - 1] >> ((N - 1) % 64)) & 1) == 1;
+  }
+
+  // ~0 when the top bit is set, 0 otherwise
+  constexpr uint64_t sign_fill() const noexcept {
+    return uint64_t(0) - uint64_t(is_signed());
+  }
+
+  // limb i of this value sign extended to any width
+  constexpr uint64_t sign_extended_limb(const uint16_t i,
+                                        const uint64_t fill) const noexcept {
+    if constexpr (N == 0) {
+      return 0;
+    } else if (i + 1 < LIMBS) {
+      return this->limbs[i];
+    } else if (i + 1 == LIMBS) {
+      return this->limbs[i] | (fill & ~TOP_MASK);
+    } else {
+      return fill;
+    }
   }
 
   template <uint16_t M>
@@ -196,36 +542,18 @@ template <uint16_t N> struct Bits : public BitsState<N> {
   template <uint16_t M>
     requires(M >= N)
   constexpr Bits<M> sign_extend() const noexcept {
-#if 1
-    if constexpr (M <= N) {
+    if constexpr ((M <= N) || (N == 0)) {
       return {*this};
-    } else if constexpr (N > 64) {
-      return {this->get_high().template sign_extend<M - 64>(), this->get_low()};
-    } else {
-      const auto signed_low =
-          (int64_t(this->get_low()) << (64 - N)) >> (64 - N);
-      if (signed_low < 0) {
-        if constexpr (M <= 64) {
-          return {uint64_t(signed_low)};
-        } else {
-          return {~Bits<M - 64>{0}, uint64_t(signed_low)};
-        }
-      } else {
-        if constexpr (M <= 64) {
-          return {this->get_low()};
-        } else {
-          return {Bits<M - 64>{0}, this->get_low()};
-        }
-      }
-    }
-#else
-    // This is correct but confuses g++ and makes it produce inefficient code
-    if (is_signed()) {
-      return (~Bits<M - N>{0}).concat(*this);
     } else {
-      return zero_extend<M>();
+      // branch free: testing is_signed() and picking between ~0 and 0 used
+      // to confuse g++ into producing inefficient code
+      const uint64_t fill = sign_fill();
+      typename Bits<M>::Limbs out{};
+      for (uint16_t i = 0; i < Bits<M>::LIMBS; i++) {
+        out[i] = sign_extended_limb(i, fill);
+      }
+      return Bits<M>{out};
     }
-#endif
   }
 
   template <uint16_t M>
@@ -233,44 +561,571 @@ template <uint16_t N> struct Bits : public BitsState<N> {
     return add<M, 0>(rhs);
   }
 
+  // both sides are sign extended and subtracted in a single borrow chain
   template <uint16_t M>
   constexpr Bits<max(M, N) + 1> operator-(const Bits<M> &rhs) const noexcept {
-    if constexpr (M > N) {
-      return this->template sign_extend<M + 1>() +
-             ~(rhs.template sign_extend<M + 1>()) + Bits<1>{1};
+    using Out = Bits<max(M, N) + 1>;
+    const uint64_t left_fill = sign_fill();
+    const uint64_t right_fill = rhs.sign_fill();
+    typename Out::Limbs out{};
+    uint64_t borrow = 0;
+#pragma GCC unroll 128
+    for (uint16_t i = 0; i < Out::LIMBS; i++) {
+      out[i] = subb(sign_extended_limb(i, left_fill),
+                    rhs.sign_extended_limb(i, right_fill), borrow, borrow);
+    }
+    return Out{out};
+  }
+
+  // Wrapping arithmetic keeps the width of *this: the result is
+  // (*this op rhs).trim<N>() but only the N result bits are computed, the
+  // carry out of the top limb is never materialized. A narrower rhs is zero
+  // extended for add_wrap and mul_wrap and sign extended for sub_wrap, like
+  // in the growing operators.
+
+  template <uint16_t M>
+  constexpr Bits<N> add_wrap(const Bits<M> &rhs) const noexcept {
+    if constexpr ((N == 0) || (M == 0)) {
+      return *this;
+    } else {
+      Limbs out{};
+      uint64_t carry = 0;
+#pragma GCC unroll 128
+      for (uint16_t i = 0; i < LIMBS; i++) {
+        out[i] = addc(this->limbs[i], rhs.get(i), carry, carry);
+      }
+      return Bits<N>{out};
+    }
+  }
+
+  template <uint16_t M>
+  constexpr Bits<N> sub_wrap(const Bits<M> &rhs) const noexcept {
+    if constexpr ((N == 0) || (M == 0)) {
+      return *this;
+    } else {
+      const uint64_t fill = (M < N) ? rhs.sign_fill() : 0;
+      Limbs out{};
+      uint64_t borrow = 0;
+#pragma GCC unroll 128
+      for (uint16_t i = 0; i < LIMBS; i++) {
+        const uint64_t r =
+            (M < N) ? rhs.sign_extended_limb(i, fill) : rhs.get(i);
+        out[i] = subb(this->limbs[i], r, borrow, borrow);
+      }
+      return Bits<N>{out};
+    }
+  }
+
+  template <uint16_t M>
+  constexpr Bits<N> mul_wrap(const Bits<M> &rhs) const noexcept {
+    if constexpr ((N == 0) || (M == 0)) {
+      return Bits<N>{};
+    } else {
+      constexpr uint16_t LR = min(LIMBS, Bits<M>::LIMBS);
+      Limbs out{};
+      mul_low_limbs<LIMBS, LIMBS, LR>(this->limbs, rhs.limbs, out.data());
+      return Bits<N>{out};
+    }
+  }
+
+  // multiplication
+
+  template <uint16_t M>
+  constexpr Bits<N + M> operator*(const Bits<M> &rhs) const noexcept {
+    using Out = Bits<N + M>;
+    if constexpr ((N == 0) || (M == 0)) {
+      return Out{};
+    } else {
+      std::array<uint64_t, LIMBS + Bits<M>::LIMBS> product{};
+      mul_limbs<LIMBS, Bits<M>::LIMBS>(this->limbs, rhs.limbs, product.data());
+      typename Out::Limbs out{};
+      for (uint16_t i = 0; i < Out::LIMBS; i++) {
+        out[i] = product[i];
+      }
+      return Out{out};
+    }
+  }
+
+  template <uint16_t M, uint16_t K>
+  consteval static uint16_t mul_add_width() noexcept {
+    // (2^N - 1)(2^M - 1) + 2^K - 1 < 2^(N + M) when K <= max(N, M)
+    if constexpr ((N == 0) || (M == 0)) {
+      return K;
+    } else if constexpr (K <= max(N, M)) {
+      return N + M;
+    } else {
+      return max(uint16_t(N + M), K) + 1;
+    }
+  }
+
+  // *this * rhs + addend without materializing the product as a Bits
+  template <uint16_t M, uint16_t K>
+  constexpr Bits<mul_add_width<M, K>()>
+  mul_add(const Bits<M> &rhs, const Bits<K> &addend) const noexcept {
+    using Out = Bits<mul_add_width<M, K>()>;
+    if constexpr ((N == 0) || (M == 0)) {
+      return addend;
+    } else {
+      constexpr uint16_t L = max(uint16_t(LIMBS + Bits<M>::LIMBS), Out::LIMBS);
+      std::array<uint64_t, L> product{};
+      mul_limbs<LIMBS, Bits<M>::LIMBS>(this->limbs, rhs.limbs, product.data());
+      uint64_t carry = 0;
+      typename Out::Limbs out{};
+      for (uint16_t i = 0; i < Out::LIMBS; i++) {
+        out[i] = addc(product[i], addend.get(i), carry, carry);
+      }
+      return Out{out};
+    }
+  }
+
+  // division
+
+  template <uint16_t M>
+  constexpr std::pair<Bits<N>, Bits<min(N, M)>>
+  divmod(const Bits<M> &rhs) const noexcept {
+    static_assert(M > 0, "division by zero");
+    assert(!(rhs == Bits<0>{}));
+    using Rem = Bits<min(N, M)>;
+    if constexpr (N == 0) {
+      return {Bits<N>{}, Rem{}};
+    } else if constexpr ((LIMBS == 1) && (Bits<M>::LIMBS == 1)) {
+      return {Bits<N>{this->limbs[0] / rhs.limbs[0]},
+              Rem{this->limbs[0] % rhs.limbs[0]}};
+    } else {
+      Limbs q{};
+      std::array<uint64_t, Bits<M>::LIMBS> r{};
+      divmod_limbs<LIMBS, Bits<M>::LIMBS>(this->limbs, rhs.limbs, q.data(),
+                                          r.data());
+      typename Rem::Limbs rem{};
+      for (uint16_t i = 0; i < Rem::LIMBS; i++) {
+        rem[i] = r[i];
+      }
+      return {Bits<N>{q}, Rem{rem}};
+    }
+  }
+
+  template <uint16_t M>
+  constexpr Bits<N> operator/(const Bits<M> &rhs) const noexcept {
+    return divmod(rhs).first;
+  }
+
+  template <uint16_t M>
+  constexpr Bits<min(N, M)> operator%(const Bits<M> &rhs) const noexcept {
+    return divmod(rhs).second;
+  }
+
+  // division by a constant is a multiplication by its reciprocal
+
+  template <uint64_t... Ds>
+  constexpr Bits<safe_sub(N, Nat<Ds...>{}.bit_size() - 1)>
+  operator/(const Nat<Ds...>) const noexcept {
+    using D = Nat<Ds...>;
+    constexpr uint16_t DB = D{}.bit_size();
+    static_assert(DB > 0, "division by zero");
+    using Out = Bits<safe_sub(N, DB - 1)>;
+    if constexpr ((Nat<1>{} << Nat<DB - 1>{}) == D{}) {
+      return shr<DB - 1>();
+    } else {
+      using R = Reciprocal<N, D>;
+      return Out{(*this * R::multiplier).template shr<R::SHIFT>()};
+    }
+  }
+
+  template <uint64_t... Ds>
+  constexpr Bits<(Nat<Ds...>{} - Nat<1>{}).bit_size()>
+  operator%(const Nat<Ds...> d) const noexcept {
+    constexpr uint16_t RB = (Nat<Ds...>{} - Nat<1>{}).bit_size();
+    if constexpr ((Nat<1>{} << Nat<RB>{}) == Nat<Ds...>{}) {
+      return Bits<RB>{*this};
+    } else {
+      // the remainder fits in RB bits so x - (x / d) * d can wrap
+      const auto q = *this / d;
+      return (Bits<RB>{*this} - Bits<RB>{q * to_bits(d)}).template trim<RB>();
+    }
+  }
+
+  // arithmetic and comparison with constants without materializing
+  // to_bits(c): the limbs of c are immediates, so where c is zero only the
+  // carry propagates, products are shift-add sequences when c has few set
+  // bits and comparisons with a c wider than N are folded. Unlike Bits - Bits,
+  // which sign extends both sides, *this is always unsigned here: x - c is
+  // x.zero_extend() - c in two's complement, not x - to_bits(c).
+
+  // *this + c, the value is unsigned
+  template <uint64_t... Vs>
+  constexpr Bits<max<uint16_t>(N, Nat<Vs...>{}.bit_size()) + 1>
+  operator+(const Nat<Vs...>) const noexcept {
+    using Out = Bits<max<uint16_t>(N, Nat<Vs...>{}.bit_size()) + 1>;
+    constexpr auto c = constant_limbs<Out::LIMBS>(Nat<Vs...>{});
+    typename Out::Limbs out{};
+    uint64_t carry = 0;
+#pragma GCC unroll 128
+    for (uint16_t i = 0; i < Out::LIMBS; i++) {
+      out[i] = addc(get(i), c[i], carry, carry);
+    }
+    return Out{out};
+  }
+
+  // *this - c in two's complement, the value is unsigned and the top bit of
+  // the result is the borrow
+  template <uint64_t... Vs>
+  constexpr Bits<max<uint16_t>(N, Nat<Vs...>{}.bit_size()) + 1>
+  operator-(const Nat<Vs...>) const noexcept {
+    using Out = Bits<max<uint16_t>(N, Nat<Vs...>{}.bit_size()) + 1>;
+    constexpr auto c = constant_limbs<Out::LIMBS>(Nat<Vs...>{});
+    typename Out::Limbs out{};
+    uint64_t borrow = 0;
+#pragma GCC unroll 128
+    for (uint16_t i = 0; i < Out::LIMBS; i++) {
+      out[i] = subb(get(i), c[i], borrow, borrow);
+    }
+    return Out{out};
+  }
+
+  template <uint64_t... Vs>
+  constexpr auto operator+(const Neg<Vs...> c) const noexcept {
+    return *this - c.abs();
+  }
+
+  template <uint64_t... Vs>
+  constexpr auto operator-(const Neg<Vs...> c) const noexcept {
+    return *this + c.abs();
+  }
+
+  // *this * c. With at most as many non-zero signed digits as c has limbs
+  // the product is a sum of shifted copies of *this, one pass of adds per
+  // digit instead of one multiply per limb pair.
+  template <uint64_t... Vs>
+  constexpr Bits<N + Nat<Vs...>{}.bit_size()>
+  operator*(const Nat<Vs...>) const noexcept {
+    constexpr uint16_t K = Nat<Vs...>{}.bit_size();
+    using Out = Bits<N + K>;
+    using S = ShiftAdd<Nat<Vs...>>;
+    if constexpr ((N == 0) || (K == 0)) {
+      return Out{};
+    } else if constexpr (S::COUNT <= Bits<K>::LIMBS) {
+      // the top digit is positive, the product fits in N + K bits so the
+      // other digits can wrap
+      constexpr uint16_t TOP = S::term(S::COUNT - 1).shift;
+      typename Out::Limbs out{};
+#pragma GCC unroll 128
+      for (uint16_t i = 0; i < Out::LIMBS; i++) {
+        out[i] = shl_limb<TOP>(i);
+      }
+      [&]<size_t... Is>(std::index_sequence<Is...>) {
+        (accumulate_shl<S::term(Is).shift, S::term(Is).negative>(out), ...);
+      }(std::make_index_sequence<S::COUNT - 1>{});
+      return Out{out};
+    } else {
+      return *this * to_bits(Nat<Vs...>{});
+    }
+  }
+
+  // out -= (*this << S) when Negative, out += (*this << S) otherwise, limbs
+  // below S / 64 are unchanged
+  template <uint16_t S, bool Negative, size_t L>
+  constexpr void accumulate_shl(std::array<uint64_t, L> &out) const noexcept {
+    uint64_t carry = 0;
+#pragma GCC unroll 128
+    for (uint16_t i = S / 64; i < L; i++) {
+      if constexpr (Negative) {
+        out[i] = subb(out[i], shl_limb<S>(i), carry, carry);
+      } else {
+        out[i] = addc(out[i], shl_limb<S>(i), carry, carry);
+      }
+    }
+  }
+
+  // the negated product in two's complement, one bit wider than the
+  // unsigned product so that the top bit is the sign
+  template <uint64_t... Vs>
+  constexpr Bits<N + Nat<Vs...>{}.bit_size() + 1>
+  operator*(const Neg<Vs...> c) const noexcept {
+    using Out = Bits<N + Nat<Vs...>{}.bit_size() + 1>;
+    return Out{}.sub_wrap(Out{*this * c.abs()});
+  }
+
+  // *this <=> c, constant when c does not fit in N bits
+  template <uint64_t... Vs>
+  constexpr Cmp cmp(const Nat<Vs...>, const Cmp prev = Cmp::EQ) const {
+    if constexpr (Nat<Vs...>{}.bit_size() > N) {
+      return Cmp::LT;
+    } else {
+      constexpr auto c = constant_limbs<LIMBS>(Nat<Vs...>{});
+      for (uint16_t i = LIMBS; i-- > 0;) {
+        if (get(i) != c[i]) {
+          return (get(i) > c[i]) ? Cmp::GT : Cmp::LT;
+        }
+      }
+      return prev;
+    }
+  }
+
+  // the value is unsigned, above every negative constant
+  template <uint64_t... Vs>
+  constexpr Cmp cmp(const Neg<Vs...> c, const Cmp prev = Cmp::EQ) const {
+    if constexpr (Neg<Vs...>::is_zero()) {
+      return cmp(c.abs(), prev);
     } else {
-      return this->template sign_extend<N + 1>() +
-             ~(rhs.template sign_extend<N + 1>()) + Bits<1>{1};
+      return Cmp::GT;
     }
   }
 
+  template <uint64_t... Vs>
+  constexpr bool operator==(const Nat<Vs...>) const noexcept {
+    if constexpr (Nat<Vs...>{}.bit_size() > N) {
+      return false;
+    } else {
+      constexpr auto c = constant_limbs<LIMBS>(Nat<Vs...>{});
+      uint64_t diff = 0;
+      for (uint16_t i = 0; i < LIMBS; i++) {
+        diff |= get(i) ^ c[i];
+      }
+      return diff == 0;
+    }
+  }
+
+  template <uint64_t... Vs>
+  constexpr bool operator==(const Neg<Vs...> c) const noexcept {
+    return Neg<Vs...>::is_zero() && (*this == c.abs());
+  }
+
   // comparison operators
 
+  // from the most significant limb down, the first limb that differs
+  // decides; prev when the values are equal
   template <uint16_t M>
   constexpr Cmp cmp(const Bits<M> &rhs, const Cmp prev = Cmp::EQ) const {
-    if constexpr ((N == 0) && (M == 0)) {
-      return prev;
+    for (uint16_t i = max(LIMBS, Bits<M>::LIMBS); i-- > 0;) {
+      const auto left = get(i);
+      const auto right = rhs.get(i);
+      if (left != right) {
+        return (left > right) ? Cmp::GT : Cmp::LT;
+      }
+    }
+    return prev;
+  }
+
+  // both values read as two's complement: the top limbs compare signed,
+  // the ones below unsigned
+  template <uint16_t M>
+  constexpr Cmp cmp_signed(const Bits<M> &rhs) const noexcept {
+    constexpr uint16_t L = max(LIMBS, Bits<M>::LIMBS);
+    if constexpr (L == 0) {
+      return Cmp::EQ;
     } else {
-      if (this->get_low() == rhs.get_low()) {
-        return this->get_high().cmp(rhs.get_high(), prev);
-      } else if (this->get_low() > rhs.get_low()) {
-        return this->get_high().cmp(rhs.get_high(), Cmp::GT);
-      } else {
-        return this->get_high().cmp(rhs.get_high(), Cmp::LT);
+      const uint64_t left_fill = sign_fill();
+      const uint64_t right_fill = rhs.sign_fill();
+      const auto left_top = int64_t(sign_extended_limb(L - 1, left_fill));
+      const auto right_top =
+          int64_t(rhs.sign_extended_limb(L - 1, right_fill));
+      if (left_top != right_top) {
+        return (left_top > right_top) ? Cmp::GT : Cmp::LT;
       }
+      for (uint16_t i = L - 1; i-- > 0;) {
+        const auto left = sign_extended_limb(i, left_fill);
+        const auto right = rhs.sign_extended_limb(i, right_fill);
+        if (left != right) {
+          return (left > right) ? Cmp::GT : Cmp::LT;
+        }
+      }
+      return Cmp::EQ;
     }
   }
 
+  // no early exit: the limbs are xor-ed and or-ed together, wide values of
+  // the same width a vector at a time
   template <uint16_t M>
   constexpr bool operator==(const Bits<M> &rhs) const noexcept {
-    return cmp(rhs) == Cmp::EQ;
+    if constexpr (LIMBS == 0 && Bits<M>::LIMBS == 0) {
+      return true;
+    } else if constexpr (LIMBS == Bits<M>::LIMBS) {
+      return equal_limbs<LIMBS>(this->limbs, rhs.limbs);
+    } else {
+      uint64_t diff = 0;
+      for (uint16_t i = 0; i < max(LIMBS, Bits<M>::LIMBS); i++) {
+        diff |= get(i) ^ rhs.get(i);
+      }
+      return diff == 0;
+    }
+  }
+
+  // unsigned order, with Bits, Nat and Neg
+  template <typename Rhs>
+    requires requires(const Bits &a, const Rhs &b) { a.cmp(b); }
+  constexpr bool operator<(const Rhs &rhs) const noexcept {
+    return cmp(rhs) == Cmp::LT;
+  }
+
+  template <typename Rhs>
+    requires requires(const Bits &a, const Rhs &b) { a.cmp(b); }
+  constexpr bool operator<=(const Rhs &rhs) const noexcept {
+    return cmp(rhs) != Cmp::GT;
+  }
+
+  template <typename Rhs>
+    requires requires(const Bits &a, const Rhs &b) { a.cmp(b); }
+  constexpr bool operator>(const Rhs &rhs) const noexcept {
+    return cmp(rhs) == Cmp::GT;
+  }
+
+  template <typename Rhs>
+    requires requires(const Bits &a, const Rhs &b) { a.cmp(b); }
+  constexpr bool operator>=(const Rhs &rhs) const noexcept {
+    return cmp(rhs) != Cmp::LT;
+  }
+
+  template <typename Rhs>
+    requires requires(const Bits &a, const Rhs &b) { a.cmp(b); }
+  constexpr std::strong_ordering operator<=>(const Rhs &rhs) const noexcept {
+    return int(cmp(rhs)) <=> 0;
   }
 
   constexpr const Bits<N> operator~() const {
     if constexpr (N == 0) {
       return *this;
     } else {
-      return {~this->get_high(), ~this->get_low()};
+      Limbs out{};
+      for (uint16_t i = 0; i < LIMBS; i++) {
+        out[i] = ~this->limbs[i];
+      }
+      return Bits<N>{out};
+    }
+  }
+
+  // bitwise operators, the shorter operand is zero extended
+
+  template <uint16_t M>
+  constexpr Bits<min(N, M)> operator&(const Bits<M> &rhs) const noexcept {
+    using Out = Bits<min(N, M)>;
+    if constexpr (Out::LIMBS == 0) {
+      return Out{};
+    } else {
+      // both operands are masked so the result needs no masking
+      Out out{};
+      bitwise_limbs<BitOp::AND, Out::LIMBS>(out.limbs, this->limbs,
+                                            rhs.limbs);
+      return out;
+    }
+  }
+
+  template <uint16_t M>
+  constexpr Bits<max(N, M)> operator|(const Bits<M> &rhs) const noexcept {
+    return merge<BitOp::OR>(rhs);
+  }
+
+  template <uint16_t M>
+  constexpr Bits<max(N, M)> operator^(const Bits<M> &rhs) const noexcept {
+    return merge<BitOp::XOR>(rhs);
+  }
+
+  // *this & ~rhs
+  template <uint16_t M>
+  constexpr Bits<N> andnot(const Bits<M> &rhs) const noexcept {
+    constexpr uint16_t COMMON = min(LIMBS, Bits<M>::LIMBS);
+    if constexpr (COMMON == 0) {
+      return *this;
+    } else {
+      Bits<N> out{};
+      bitwise_limbs<BitOp::ANDNOT, COMMON>(out.limbs, this->limbs,
+                                           rhs.limbs);
+#pragma GCC unroll 128
+      for (uint16_t i = COMMON; i < LIMBS; i++) {
+        out.limbs[i] = this->limbs[i];
+      }
+      return out;
+    }
+  }
+
+  // OR and XOR: limbs past the shorter operand come from the longer one
+  template <BitOp Op, uint16_t M>
+  constexpr Bits<max(N, M)> merge(const Bits<M> &rhs) const noexcept {
+    using Out = Bits<max(N, M)>;
+    constexpr uint16_t COMMON = min(LIMBS, Bits<M>::LIMBS);
+    if constexpr (COMMON == 0) {
+      return (N == 0) ? Out{rhs} : Out{*this};
+    } else {
+      Out out{};
+      bitwise_limbs<Op, COMMON>(out.limbs, this->limbs, rhs.limbs);
+      const uint64_t *tail = (LIMBS > COMMON) ? this->limbs : rhs.limbs;
+#pragma GCC unroll 128
+      for (uint16_t i = COMMON; i < Out::LIMBS; i++) {
+        out.limbs[i] = tail[i];
+      }
+      return out;
+    }
+  }
+
+  // counting and reductions, see int.h for popcount, countl_zero and
+  // countr_zero with exact Int<0, N> results
+
+  constexpr uint16_t count_ones() const noexcept {
+    if constexpr (N == 0) {
+      return 0;
+    } else {
+      return popcount_limbs<LIMBS>(this->limbs);
+    }
+  }
+
+  constexpr uint16_t leading_zeros() const noexcept {
+    if constexpr (N == 0) {
+      return 0;
+    } else {
+      return N - bit_width_limbs<LIMBS>(this->limbs);
+    }
+  }
+
+  constexpr uint16_t trailing_zeros() const noexcept {
+    if constexpr (N == 0) {
+      return 0;
+    } else {
+      return mango::min(N, countr_zero_limbs<LIMBS>(this->limbs));
+    }
+  }
+
+  constexpr bool any() const noexcept {
+    uint64_t acc = 0;
+    for (uint16_t i = 0; i < LIMBS; i++) {
+      acc |= get(i);
+    }
+    return acc != 0;
+  }
+
+  constexpr bool none() const noexcept { return !any(); }
+
+  constexpr bool all() const noexcept {
+    if constexpr (N == 0) {
+      return true;
+    } else {
+      uint64_t acc = ~uint64_t(0);
+      for (uint16_t i = 0; i + 1 < LIMBS; i++) {
+        acc &= get(i);
+      }
+      return (acc == ~uint64_t(0)) &&
+             (this->limbs[LIMBS - 1] == BitsState<N>::TOP_MASK);
+    }
+  }
+
+  constexpr bool parity() const noexcept {
+    uint64_t acc = 0;
+    for (uint16_t i = 0; i < LIMBS; i++) {
+      acc ^= get(i);
+    }
+    return popcnt(acc) & 1;
+  }
+
+  constexpr Bits<1> reduce_and() const noexcept { return Bits<1>{all()}; }
+  constexpr Bits<1> reduce_or() const noexcept { return Bits<1>{any()}; }
+  constexpr Bits<1> reduce_xor() const noexcept { return Bits<1>{parity()}; }
+
+  // f(i) for every set bit i, from the least significant one up
+  template <typename F> constexpr void for_each_set_bit(F &&f) const {
+    for (uint16_t i = 0; i < LIMBS; i++) {
+      uint64_t w = get(i);
+      while (w != 0) {
+        f(uint16_t(64 * i + ctz(w)));
+        w &= w - 1;
+      }
     }
   }
 
@@ -278,43 +1133,43 @@ template <uint16_t N> struct Bits : public BitsState<N> {
   constexpr const Bits<N + M> concat(const Bits<M> &rhs) const noexcept {
     if constexpr (M == 0) {
       return *this;
-    } else if constexpr (M == 64) {
-      return {*this, rhs.get_low()};
-    } else if constexpr (M > 64) {
-      return {concat(rhs.get_high()), rhs.get_low()};
-    } else {
-      const uint64_t new_low = (this->get_low() << M) | rhs.get_low();
-      if constexpr ((N + M) <= 64) {
-        return Bits<M + N>{new_low};
-      } else {
-        const Bits<N - 64 + M> new_high =
-            this->get_high().concat(Bits<M>{this->get_low() >> (64 - M)});
-        return {new_high, new_low};
+    } else if constexpr (N == 0) {
+      return rhs;
+    } else {
+      using Out = Bits<N + M>;
+      typename Out::Limbs out{};
+      for (uint16_t i = 0; i < Out::LIMBS; i++) {
+        out[i] = rhs.get(i) | shl_limb<M>(i);
       }
+      return Out{out};
     }
   }
 
   template <uint16_t F>
   constexpr const Bits<uint16_t(mango::safe_max(uint16_t(F + uint16_t(1)), N))>
   flip_bit() const noexcept {
-    if constexpr (F < 64) {
-      const auto mask = uint64_t(1) << F;
-      return {this->get_high(), this->get_low() ^ mask};
-    } else {
-      return {this->get_high().template flip_bit<safe_sub(F, 64)>(),
-              this->get_low()};
+    using Out = Bits<uint16_t(mango::safe_max(uint16_t(F + uint16_t(1)), N))>;
+    typename Out::Limbs out{};
+    for (uint16_t i = 0; i < Out::LIMBS; i++) {
+      out[i] = get(i);
     }
+    out[F / 64] ^= uint64_t(1) << (F % 64);
+    return Out{out};
   }
 };
 
-constexpr const Bits<0> BitsState<0>::get_high() const noexcept {
-  return Bits<0>{};
+template <uint16_t N>
+constexpr Bits<safe_sub(N, 64)> BitsState<N>::get_high() const noexcept {
+  using Out = Bits<safe_sub(N, 64)>;
+  typename Out::Limbs out{};
+  for (uint16_t i = 0; i < Out::LIMBS; i++) {
+    out[i] = limbs[i + 1];
+  }
+  return Out{out};
 }
 
-template <uint16_t N>
-constexpr BitsState<N>::BitsState(const uint64_t v) noexcept
-    : low(v & MASK), high(Bits<safe_sub(N, 64)>{}) {
-  static_assert(N > 0, "BitsState<N> requires N > 0");
+constexpr const Bits<0> BitsState<0>::get_high() const noexcept {
+  return Bits<0>{};
 }
 
 /////////////////////
@@ -322,12 +1177,25 @@ constexpr BitsState<N>::BitsState(const uint64_t v) noexcept
 /////////////////////
 
 template <uint64_t... Vs>
-constexpr Bits<Nat<Vs...>{}.bit_size()> to_bits(const Nat<Vs...> n) noexcept {
-  if constexpr (sizeof...(Vs) == 0) {
-    return Bits<0>{};
-  } else {
-    return {to_bits(n.high()), n.low};
+constexpr Bits<Nat<Vs...>{}.bit_size()> to_bits(const Nat<Vs...>) noexcept {
+  using Out = Bits<Nat<Vs...>{}.bit_size()>;
+  constexpr uint64_t vs[] = {Vs..., 0};
+  typename Out::Limbs out{};
+  for (uint16_t i = 0; i < Out::LIMBS; i++) {
+    out[i] = vs[i];
   }
+  return Out{out};
+}
+
+// n modulo 2^K
+template <uint16_t K, uint64_t... Vs>
+constexpr Bits<K> to_bits_mod(const Nat<Vs...> n) noexcept {
+  return Bits<K>{to_bits(n)};
+}
+
+template <uint16_t K, uint64_t... Vs>
+constexpr Bits<K> to_bits_mod(const Neg<Vs...> n) noexcept {
+  return (~to_bits_mod<K>(n.abs()) + Bits<1>{1}).template trim<K>();
 }
 
 /////////////
@@ -344,25 +1212,69 @@ template <typename T, typename... Ts> constexpr auto bits(T v, Ts... vs) {
   return bits(v).concat(bits(vs...));
 }
 
+/////////////////////
+// text conversion //
+/////////////////////
+
+// like std::to_chars for an unsigned integer, base 2 .. 36
+template <uint16_t N>
+std::to_chars_result to_chars(char *first, char *last, const Bits<N> &v,
+                              const int base = 10) noexcept {
+  typename Bits<N>::Limbs limbs;
+  for (uint16_t i = 0; i < Bits<N>::LIMBS; i++) {
+    limbs[i] = v.get(i);
+  }
+  return limbs_to_chars<Bits<N>::LIMBS>(first, last, limbs.data(), base);
+}
+
+// like std::from_chars for an unsigned integer, values of 2^N or more are
+// result_out_of_range and leave v unchanged
+template <uint16_t N>
+std::from_chars_result from_chars(const char *first, const char *last,
+                                  Bits<N> &v, const int base = 10) noexcept {
+  typename Bits<N>::Limbs limbs;
+  const auto r =
+      limbs_from_chars<Bits<N>::LIMBS>(first, last, limbs.data(), base);
+  if (r.ec != std::errc{}) {
+    return r;
+  }
+  if constexpr (N > 0) {
+    if ((limbs[Bits<N>::LIMBS - 1] & ~Bits<N>::TOP_MASK) != 0) {
+      return {r.ptr, std::errc::result_out_of_range};
+    }
+  }
+  v = Bits<N>{limbs};
+  return r;
+}
+
 } // namespace mango
 
 ////////////
 // Output //
 ////////////
 
+// the unsigned value in the stream's base
 template <uint16_t N>
 inline std::ostream &operator<<(std::ostream &os, const mango::Bits<N> &bits) {
-  if constexpr (N > 64) {
-    os << bits.get_high() << ":";
+  typename mango::Bits<N>::Limbs limbs;
+  for (uint16_t i = 0; i < mango::Bits<N>::LIMBS; i++) {
+    limbs[i] = bits.get(i);
   }
-  os << bits.get_low();
-  return os;
+  return mango::print_limbs<mango::Bits<N>::LIMBS, N>(os, limbs.data(), false);
 }
 
-// comparison
+#ifdef __cpp_lib_format
+
+template <uint16_t N>
+struct std::formatter<mango::Bits<N>> : mango::DigitsFormatter {
+  auto format(const mango::Bits<N> &bits, auto &ctx) const {
+    typename mango::Bits<N>::Limbs limbs;
+    for (uint16_t i = 0; i < mango::Bits<N>::LIMBS; i++) {
+      limbs[i] = bits.get(i);
+    }
+    return format_limbs<mango::Bits<N>::LIMBS, N>(limbs.data(), false, ctx);
+  }
+};
+
+#endif
 
-template <uint16_t N, uint16_t M>
-constexpr int operator<=>(const mango::Bits<N> &lhs,
-                          const mango::Bits<M> &rhs) noexcept {
-  return int(lhs.cmp(rhs));
-}
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "mango/bits.h"
+#include "mango/int.h"
+#include "mango/limbs.h"
+
+namespace mango {
+
+// Column oriented (structure of arrays) storage for many Bits<N> values:
+// columns[i][j] is limb i of element j. Bulk operations are loops over
+// contiguous uint64_t arrays that the compiler vectorizes, result widths
+// follow the scalar operations (AddType, extract, ...).
+template <uint16_t N> struct BitsVector {
+  constexpr static uint16_t WIDTH = N;
+  constexpr static uint16_t LIMBS = Bits<N>::LIMBS;
+
+  std::array<std::vector<uint64_t>, LIMBS> columns;
+  size_t count = 0;
+
+  BitsVector() = default;
+
+  explicit BitsVector(const size_t n) : count(n) {
+    for (auto &c : columns) {
+      c.assign(n, 0);
+    }
+  }
+
+  size_t size() const noexcept { return count; }
+
+  void resize(const size_t n) {
+    for (auto &c : columns) {
+      c.resize(n, 0);
+    }
+    count = n;
+  }
+
+  void push_back(const Bits<N> &b) {
+    for (uint16_t i = 0; i < LIMBS; i++) {
+      columns[i].push_back(b.get(i));
+    }
+    count++;
+  }
+
+  Bits<N> operator[](const size_t j) const noexcept {
+    typename Bits<N>::Limbs out{};
+    for (uint16_t i = 0; i < LIMBS; i++) {
+      out[i] = columns[i][j];
+    }
+    return Bits<N>{out};
+  }
+
+  void set(const size_t j, const Bits<N> &b) noexcept {
+    for (uint16_t i = 0; i < LIMBS; i++) {
+      columns[i][j] = b.get(i);
+    }
+  }
+
+  // limb i of element j, zero past the top limb
+  uint64_t limb(const uint16_t i, const size_t j) const noexcept {
+    if constexpr (LIMBS == 0) {
+      return 0;
+    } else {
+      return (i < LIMBS) ? columns[i][j] : 0;
+    }
+  }
+
+  // The loops below run over elements with the (constant) limb loop inside
+  // so carries and partial results stay in registers, the compiler
+  // vectorizes across elements.
+
+  template <uint16_t M>
+  BitsVector<Bits<N>::template AddType<M, false>::WIDTH>
+  operator+(const BitsVector<M> &rhs) const {
+    using Out = BitsVector<Bits<N>::template AddType<M, false>::WIDTH>;
+    assert(count == rhs.count);
+    Out out(count);
+    const size_t n = count; // stores to the columns could alias count
+    for (size_t j = 0; j < n; j++) {
+      uint64_t carry = 0;
+#pragma GCC unroll 128
+      for (uint16_t i = 0; i < Out::LIMBS; i++) {
+        const uint64_t a = limb(i, j);
+        const uint64_t t = a + carry;
+        const uint64_t u = t + rhs.limb(i, j);
+        carry = (t < a) | (u < t);
+        out.columns[i][j] = u;
+      }
+    }
+    return out;
+  }
+
+  template <uint16_t M>
+  BitsVector<min(N, M)> operator&(const BitsVector<M> &rhs) const {
+    return bitwise<BitOp::AND, min(N, M)>(rhs);
+  }
+
+  template <uint16_t M>
+  BitsVector<max(N, M)> operator|(const BitsVector<M> &rhs) const {
+    return bitwise<BitOp::OR, max(N, M)>(rhs);
+  }
+
+  template <uint16_t M>
+  BitsVector<max(N, M)> operator^(const BitsVector<M> &rhs) const {
+    return bitwise<BitOp::XOR, max(N, M)>(rhs);
+  }
+
+  template <uint16_t M>
+  BitsVector<N> andnot(const BitsVector<M> &rhs) const {
+    return bitwise<BitOp::ANDNOT, N>(rhs);
+  }
+
+  // masked operands cannot set bits above W, missing limbs are zero
+  template <BitOp Op, uint16_t W, uint16_t M>
+  BitsVector<W> bitwise(const BitsVector<M> &rhs) const {
+    assert(count == rhs.count);
+    BitsVector<W> out(count);
+    const size_t n = count;
+    // one column at a time: each is a single streaming loop
+    for (uint16_t i = 0; i < BitsVector<W>::LIMBS; i++) {
+      uint64_t *s = out.columns[i].data();
+      if (i < LIMBS && i < BitsVector<M>::LIMBS) {
+        const uint64_t *a = columns[i].data();
+        const uint64_t *b = rhs.columns[i].data();
+        for (size_t j = 0; j < n; j++) {
+          s[j] = bit_op<Op>(a[j], b[j]);
+        }
+      } else {
+        for (size_t j = 0; j < n; j++) {
+          s[j] = bit_op<Op>(limb(i, j), rhs.limb(i, j));
+        }
+      }
+    }
+    return out;
+  }
+
+  // element wise a == b as Bits<1>
+  template <uint16_t M> BitsVector<1> eq(const BitsVector<M> &rhs) const {
+    assert(count == rhs.count);
+    BitsVector<1> out(count);
+    const size_t n = count;
+    for (size_t j = 0; j < n; j++) {
+      constexpr uint16_t L = max(LIMBS, BitsVector<M>::LIMBS);
+      uint64_t diff = 0;
+#pragma GCC unroll 128
+      for (uint16_t i = 0; i < L; i++) {
+        diff |= limb(i, j) ^ rhs.limb(i, j);
+      }
+      out.columns[0][j] = (diff == 0);
+    }
+    return out;
+  }
+
+  // element wise unsigned a < b as Bits<1>, branch free from the top limb
+  // down
+  template <uint16_t M> BitsVector<1> lt(const BitsVector<M> &rhs) const {
+    assert(count == rhs.count);
+    BitsVector<1> out(count);
+    const size_t n = count;
+    for (size_t j = 0; j < n; j++) {
+      uint64_t less = 0;
+      uint64_t equal = 1;
+      constexpr uint16_t L = max(LIMBS, BitsVector<M>::LIMBS);
+#pragma GCC unroll 128
+      for (uint16_t k = 0; k < L; k++) {
+        const uint64_t a = limb(L - 1 - k, j);
+        const uint64_t b = rhs.limb(L - 1 - k, j);
+        less |= equal & (a < b);
+        equal &= (a == b);
+      }
+      out.columns[0][j] = less;
+    }
+    return out;
+  }
+
+  BitsVector<BitCount<N>::bitsize> popcount() const {
+    BitsVector<BitCount<N>::bitsize> out(count);
+    const size_t n = count;
+    if constexpr (BitCount<N>::bitsize > 0) {
+      for (size_t j = 0; j < n; j++) {
+        uint64_t ones = 0;
+#pragma GCC unroll 128
+        for (uint16_t i = 0; i < LIMBS; i++) {
+          ones += popcnt(columns[i][j]);
+        }
+        out.columns[0][j] = ones;
+      }
+    }
+    return out;
+  }
+
+  template <uint16_t High, uint16_t Low>
+    requires(High >= Low) && (High < N)
+  BitsVector<High - Low + 1> extract() const {
+    using Out = BitsVector<High - Low + 1>;
+    constexpr uint16_t q = Low / 64;
+    constexpr uint16_t r = Low % 64;
+    Out out(count);
+    const size_t n = count;
+    for (uint16_t k = 0; k < Out::LIMBS; k++) {
+      const uint64_t mask =
+          (k + 1 == Out::LIMBS) ? Bits<High - Low + 1>::TOP_MASK : ~uint64_t(0);
+      uint64_t *s = out.columns[k].data();
+      for (size_t j = 0; j < n; j++) {
+        if constexpr (r == 0) {
+          s[j] = limb(q + k, j) & mask;
+        } else {
+          s[j] = ((limb(q + k, j) >> r) | (limb(q + k + 1, j) << (64 - r))) &
+                 mask;
+        }
+      }
+    }
+    return out;
+  }
+};
+
+} // namespace mango
@@ -0,0 +1,227 @@
+#pragma once
+
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <type_traits>
+
+#include "mango/bits.h"
+
+namespace mango {
+
+// A Bits<N> stored in an external byte buffer, read (and for BitsRef
+// written) in place. The value may start at any bit of the buffer.
+//
+//    little endian  value bit i is bit (offset + i) % 8 of byte
+//                   (offset + i) / 8, bytes go up in significance
+//    big endian     network order: the value is the big endian integer in
+//                   bytes [0, B) shifted right by the padding after its last
+//                   bit, offset counts from the most significant bit of
+//                   byte 0
+//
+// Limbs are loaded and stored one 64-bit word at a time (plus one byte when
+// the value does not start on a byte boundary), bytes past the value are
+// never read or written.
+
+template <uint16_t N, std::endian E, typename Byte> struct BasicBitsView {
+  constexpr static uint16_t WIDTH = N;
+  constexpr static uint16_t LIMBS = Bits<N>::LIMBS;
+
+  Byte *data;    // first byte holding a bit of the value
+  uint8_t shift; // little endian: offset in byte 0, big endian: padding
+
+  constexpr static size_t bytes_for(const size_t bit_offset) noexcept {
+    return (bit_offset % 8 + N + 7) / 8;
+  }
+
+  // the N bits starting at bit_offset of the buffer
+  BasicBitsView(const std::span<Byte> buffer, const size_t bit_offset = 0)
+      : data(buffer.data() + bit_offset / 8),
+        shift(uint8_t((E == std::endian::little)
+                          ? bit_offset % 8
+                          : 8 * bytes_for(bit_offset) - bit_offset % 8 - N)) {
+    assert(bit_offset / 8 + bytes_for(bit_offset) <= buffer.size());
+  }
+
+  BasicBitsView(Byte *data_, const uint8_t shift_) noexcept
+      : data(data_), shift(shift_) {}
+
+  // a read-only view of the same bits
+  operator BasicBitsView<N, E, const std::byte>() const noexcept {
+    return {data, shift};
+  }
+
+  // number of bytes holding bits of the value
+  size_t size() const noexcept { return (shift + N + 7) / 8; }
+
+  // bytes [k, k + 8) of the buffer as a little endian integer, missing
+  // bytes past size() are zero
+  uint64_t word(const size_t k) const noexcept {
+    const size_t n = size();
+    uint64_t w = 0;
+    if constexpr (E == std::endian::little) {
+      if (k + 8 <= n) {
+        std::memcpy(&w, data + k, 8);
+      } else if (k < n) {
+        std::memcpy(&w, data + k, n - k);
+      }
+      if constexpr (std::endian::native == std::endian::big) {
+        w = std::byteswap(w);
+      }
+    } else {
+      // byte k of the integer is data[n - 1 - k]
+      if (k + 8 <= n) {
+        std::memcpy(&w, data + n - k - 8, 8);
+      } else if (k < n) {
+        std::memcpy(reinterpret_cast<std::byte *>(&w) + (k + 8 - n), data,
+                    n - k);
+      }
+      if constexpr (std::endian::native == std::endian::little) {
+        w = std::byteswap(w);
+      }
+    }
+    return w;
+  }
+
+  // limb i of the value, zero past the top limb
+  uint64_t get(const uint16_t i) const noexcept {
+    if (i >= LIMBS) {
+      return 0;
+    }
+    const size_t k = size_t(8) * i;
+    uint64_t v = word(k) >> shift;
+    if (shift != 0) {
+      v |= word(k + 8) << (64 - shift);
+    }
+    return (i + 1 == LIMBS) ? (v & Bits<N>::TOP_MASK) : v;
+  }
+
+  Bits<N> load() const noexcept {
+    typename Bits<N>::Limbs out{};
+    for (uint16_t i = 0; i < LIMBS; i++) {
+      out[i] = get(i);
+    }
+    return Bits<N>{out};
+  }
+
+  operator Bits<N>() const noexcept { return load(); }
+
+  // bits [Low, High] of the value, still in place
+  template <uint16_t High, uint16_t Low>
+    requires(High >= Low) && (High < N)
+  BasicBitsView<High - Low + 1, E, Byte> view() const noexcept {
+    if constexpr (E == std::endian::little) {
+      const size_t bit = shift + Low;
+      return {data + bit / 8, uint8_t(bit % 8)};
+    } else {
+      // bits above High are the leading bits of the buffer
+      const size_t lead = 8 * size() - shift - (High + 1);
+      const size_t bytes = (lead % 8 + High - Low + 1 + 7) / 8;
+      return {data + lead / 8,
+              uint8_t(8 * bytes - lead % 8 - (High - Low + 1))};
+    }
+  }
+
+  template <uint16_t High, uint16_t Low>
+    requires(High >= Low) && (High < N)
+  Bits<High - Low + 1> extract() const noexcept {
+    return view<High, Low>().load();
+  }
+
+  // compares from the top limb down and stops at the first difference, rhs
+  // is a Bits or a view
+  template <typename Rhs> Cmp cmp(const Rhs &rhs) const noexcept {
+    for (uint16_t i = mango::max(LIMBS, Rhs::LIMBS); i-- > 0;) {
+      const uint64_t a = get(i);
+      const uint64_t b = rhs.get(i);
+      if (a != b) {
+        return (a < b) ? Cmp::LT : Cmp::GT;
+      }
+    }
+    return Cmp::EQ;
+  }
+
+  template <typename Rhs> bool operator==(const Rhs &rhs) const noexcept {
+    return cmp(rhs) == Cmp::EQ;
+  }
+
+  template <uint16_t M> auto operator+(const Bits<M> &rhs) const noexcept {
+    return load() + rhs;
+  }
+
+  template <uint16_t M, typename B>
+  auto operator+(const BasicBitsView<M, E, B> &rhs) const noexcept {
+    return load() + rhs.load();
+  }
+
+  // writes w to bytes [k, k + 8) of the buffer as a little endian integer,
+  // bytes past size() are not written
+  void put_word(const size_t k, uint64_t w) const noexcept
+    requires(!std::is_const_v<Byte>)
+  {
+    const size_t n = size();
+    if constexpr (E == std::endian::little) {
+      if constexpr (std::endian::native == std::endian::big) {
+        w = std::byteswap(w);
+      }
+      if (k + 8 <= n) {
+        std::memcpy(data + k, &w, 8);
+      } else if (k < n) {
+        std::memcpy(data + k, &w, n - k);
+      }
+    } else {
+      if constexpr (std::endian::native == std::endian::little) {
+        w = std::byteswap(w);
+      }
+      if (k + 8 <= n) {
+        std::memcpy(data + n - k - 8, &w, 8);
+      } else if (k < n) {
+        std::memcpy(data, reinterpret_cast<const std::byte *>(&w) + (k + 8 - n),
+                    n - k);
+      }
+    }
+  }
+
+  // stores v in place, the bits around the value are kept: one masked
+  // read-modify-write per word, the mirror of get
+  void store(const Bits<N> &v) const noexcept
+    requires(!std::is_const_v<Byte>)
+  {
+    const size_t n = size();
+    // the bits of limb i - 1 shifted past the top of word i - 1
+    uint64_t carry = 0;
+    uint64_t carry_mask = 0;
+    for (uint16_t i = 0; size_t(8) * i < n; i++) {
+      const uint64_t x = v.get(i);
+      const uint64_t m = (i + 1 < LIMBS)    ? ~uint64_t(0)
+                         : (i + 1 == LIMBS) ? Bits<N>::TOP_MASK
+                                            : 0;
+      const uint64_t bits = (x << shift) | carry;
+      const uint64_t mask = (m << shift) | carry_mask;
+      if (shift != 0) {
+        carry = x >> (64 - shift);
+        carry_mask = m >> (64 - shift);
+      }
+      const size_t k = size_t(8) * i;
+      put_word(k, (word(k) & ~mask) | (bits & mask));
+    }
+  }
+
+  const BasicBitsView &operator=(const Bits<N> &v) const noexcept
+    requires(!std::is_const_v<Byte>)
+  {
+    store(v);
+    return *this;
+  }
+};
+
+template <uint16_t N, std::endian E = std::endian::little>
+using BitsView = BasicBitsView<N, E, const std::byte>;
+
+template <uint16_t N, std::endian E = std::endian::little>
+using BitsRef = BasicBitsView<N, E, std::byte>;
+
+} // namespace mango
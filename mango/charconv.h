@@ -0,0 +1,555 @@
+#pragma once
+
+// Text conversion kernels over little endian arrays of 64-bit limbs, shared
+// by the to_chars / from_chars overloads of Nat, Neg, Bits and Int. They
+// follow std::to_chars / std::from_chars: no allocation, no locale, no "0x"
+// prefix and no leading '+', errors are reported in the result's ec.
+//
+//    base 10        divide and conquer: split by 10^(19 K) until the halves
+//                   are short, then one short division per 19 digits
+//    base 2, 4, 8,  digits are read straight from the bits, 16 hex or 64
+//    16, 32         binary digits per limb are spread into bytes with
+//                   shifts and masks (SWAR) instead of a loop per digit
+//    other bases    one short division per base^k chunk
+
+#include <array>
+#include <bit>
+#include <cassert>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ios>
+#include <ostream>
+#include <system_error>
+#include <version>
+
+#ifdef __cpp_lib_format
+#include <algorithm>
+#include <format>
+#endif
+
+#include "common.h"
+#include "limbs.h"
+
+namespace mango {
+
+// upper bound on the number of digits of a bits-bit value, at least 1
+constexpr size_t max_digits(const size_t bits, const int base) noexcept {
+  const size_t per_digit = std::bit_width(unsigned(base)) - 1;
+  return (bits == 0) ? 1 : (bits + per_digit - 1) / per_digit;
+}
+
+constexpr char DIGITS[] = "0123456789abcdefghijklmnopqrstuvwxyz";
+constexpr char UPPER_DIGITS[] = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+
+// "00", "01", ..., "99"
+constexpr std::array<char, 200> DIGIT_PAIRS = [] {
+  std::array<char, 200> out{};
+  for (int i = 0; i < 100; i++) {
+    out[2 * i] = char('0' + i / 10);
+    out[2 * i + 1] = char('0' + i % 10);
+  }
+  return out;
+}();
+
+// 0 .. 35 for a digit in any base up to 36, 255 otherwise
+constexpr uint8_t digit_value(const char c) noexcept {
+  if (c >= '0' && c <= '9') {
+    return uint8_t(c - '0');
+  } else if (c >= 'a' && c <= 'z') {
+    return uint8_t(c - 'a' + 10);
+  } else if (c >= 'A' && c <= 'Z') {
+    return uint8_t(c - 'A' + 10);
+  }
+  return 255;
+}
+
+// digits per chunk: the largest k with base^k < 2^64, and base^k
+constexpr std::pair<uint16_t, uint64_t> chunk_base(const int base) noexcept {
+  uint16_t k = 0;
+  uint64_t p = 1;
+  while (p <= ~uint64_t(0) / uint64_t(base)) {
+    p *= uint64_t(base);
+    k++;
+  }
+  return {k, p};
+}
+
+// Divides by a fixed d with the top bit set: two multiplies instead of a
+// divq per limb. Möller and Granlund, "Improved division by invariant
+// integers", 2011, algorithm 4.
+struct InvariantDivisor {
+  uint64_t d;
+  uint64_t v; // floor((2^128 - 1) / d) - 2^64
+
+  constexpr explicit InvariantDivisor(const uint64_t d_) noexcept
+      : d(d_), v([d_] {
+          uint64_t rem;
+          return div128(~d_, ~uint64_t(0), d_, rem);
+        }()) {}
+
+  // (hi * 2^64 + lo) / d, requires hi < d
+  constexpr uint64_t div(const uint64_t hi, const uint64_t lo,
+                         uint64_t &rem) const noexcept {
+    const uint128_t p = uint128_t(v) * hi + ((uint128_t(hi + 1) << 64) | lo);
+    uint64_t q = uint64_t(p >> 64);
+    uint64_t r = lo - q * d;
+    if (r > uint64_t(p)) {
+      q--;
+      r += d;
+    }
+    if (r >= d) [[unlikely]] {
+      q++;
+      r -= d;
+    }
+    rem = r;
+    return q;
+  }
+};
+
+// the hardware division, for chunk bases without the top bit set
+struct Divisor {
+  uint64_t d;
+
+  constexpr uint64_t div(const uint64_t hi, const uint64_t lo,
+                         uint64_t &rem) const noexcept {
+    return div128(hi, lo, d, rem);
+  }
+};
+
+constexpr uint64_t TEN19 = 10000000000000000000ull;
+static_assert(TEN19 >> 63 == 1);
+
+// 10^(19 K), which always fits in K limbs
+template <uint16_t K>
+constexpr std::array<uint64_t, K> TEN19_POW = [] {
+  std::array<uint64_t, K> p{};
+  p[0] = 1;
+  for (uint16_t i = 0; i < K; i++) {
+    uint64_t carry = 0;
+    for (uint16_t j = 0; j < K; j++) {
+      p[j] = mul_add(p[j], TEN19, carry, 0, carry);
+    }
+  }
+  return p;
+}();
+
+// values with more limbs are split in two by a power of 10^19 before they
+// are converted chunk by chunk
+constexpr uint16_t DECIMAL_SPLIT_LIMBS = 32;
+
+// enough base^k chunks for L limbs in any base, a chunk holds at least 58 bits
+constexpr size_t max_chunks(const uint16_t L) noexcept {
+  return L + L / 8 + 1;
+}
+
+// a[0 .. L) in base b.d, least significant chunk first, returns the number
+// of chunks, 0 when a is zero
+template <uint16_t L, typename D>
+inline uint16_t short_chunks(const uint64_t *a, uint64_t *out,
+                             const D &b) noexcept {
+  std::array<uint64_t, L> t;
+  for (uint16_t i = 0; i < L; i++) {
+    t[i] = a[i];
+  }
+  uint16_t n = limbs_used<L>(t.data());
+  uint16_t count = 0;
+  while (n > 0) {
+    uint64_t rem = 0;
+    for (uint16_t j = n; j-- > 0;) {
+      t[j] = b.div(rem, t[j], rem);
+    }
+    out[count++] = rem;
+    if (t[n - 1] == 0) {
+      n--;
+    }
+  }
+  return count;
+}
+
+// a[0 .. L) in base 10^19, like short_chunks. Wide values are split into
+// a / 10^(19 K) and a % 10^(19 K) with K = L / 2 and both halves converted
+// recursively, so most of the work is done by long division (multiplies)
+// rather than one hardware division per limb and chunk.
+template <uint16_t L>
+inline uint16_t decimal_chunks(const uint64_t *a, uint64_t *out) noexcept {
+  if constexpr (L <= DECIMAL_SPLIT_LIMBS) {
+    return short_chunks<L>(a, out, InvariantDivisor{TEN19});
+  } else {
+    constexpr uint16_t K = L / 2;
+    // a / 10^(19 K) < 2^(64 L - 63 K)
+    constexpr uint16_t LQ = L - K + K / 64 + 1;
+    std::array<uint64_t, L> q;
+    std::array<uint64_t, K> r;
+    divmod_limbs<L, K>(a, TEN19_POW<K>.data(), q.data(), r.data());
+
+    const uint16_t low = decimal_chunks<K>(r.data(), out);
+    const uint16_t high = decimal_chunks<LQ>(q.data(), out + K);
+    if (high == 0) {
+      return low;
+    }
+    // the low half is exactly K chunks wide
+    for (uint16_t i = low; i < K; i++) {
+      out[i] = 0;
+    }
+    return K + high;
+  }
+}
+
+// the 19 digits of v < 10^19, leading zeros included
+inline void write19(char *out, uint64_t v) noexcept {
+  for (int i = 17; i > 0; i -= 2) {
+    std::memcpy(out + i, DIGIT_PAIRS.data() + 2 * (v % 100), 2);
+    v /= 100;
+  }
+  out[0] = char('0' + v);
+}
+
+// byte i of the result is nibble i of v
+constexpr uint64_t spread_nibbles(const uint32_t v) noexcept {
+  uint64_t x = v;
+  x = ((x << 16) | x) & 0x0000FFFF0000FFFFull;
+  x = ((x << 8) | x) & 0x00FF00FF00FF00FFull;
+  x = ((x << 4) | x) & 0x0F0F0F0F0F0F0F0Full;
+  return x;
+}
+
+// byte i of the result is bit i of v
+constexpr uint64_t spread_bits(const uint8_t v) noexcept {
+  const uint64_t t = (v * 0x0101010101010101ull) & 0x8040201008040201ull;
+  return ((t + 0x7F7F7F7F7F7F7F7Full) >> 7) & 0x0101010101010101ull;
+}
+
+// stores 8 digit bytes, byte 7 (the most significant digit) first
+inline void store_digits(char *out, uint64_t x) noexcept {
+  if constexpr (std::endian::native == std::endian::little) {
+    x = std::byteswap(x);
+  }
+  std::memcpy(out, &x, 8);
+}
+
+// the 8 hex digits of v
+inline void write_hex8(char *out, const uint32_t v, const bool upper) noexcept {
+  const uint64_t x = spread_nibbles(v);
+  // 1 in every byte holding a digit above 9
+  const uint64_t letters = ((x + 0x0606060606060606ull) >> 4) &
+                           0x0101010101010101ull;
+  store_digits(out, x + 0x3030303030303030ull +
+                        letters * uint64_t(upper ? 'A' - '9' - 1
+                                                 : 'a' - '9' - 1));
+}
+
+// the 8 binary digits of v
+inline void write_bin8(char *out, const uint8_t v) noexcept {
+  store_digits(out, spread_bits(v) + 0x3030303030303030ull);
+}
+
+// digits of a[0 .. L) in a base 2^shift
+template <uint16_t L>
+inline std::to_chars_result pow2_to_chars(char *first, char *last,
+                                          const uint64_t *a, const int shift,
+                                          const bool upper) noexcept {
+  const size_t width = bit_width_limbs<L>(a);
+  const size_t n = (width == 0) ? 1 : (width + shift - 1) / shift;
+  if (size_t(last - first) < n) {
+    return {last, std::errc::value_too_large};
+  }
+  char *const end = first + n;
+  const auto limb = [a](const size_t j) { return (j < L) ? a[j] : 0; };
+
+  if (shift == 4 || shift == 1) {
+    // whole limbs, the top one into a buffer that is cut to its digits
+    const size_t per_limb = 64 / shift;
+    const auto write_limb = [&](char *out, const uint64_t v) {
+      if (shift == 4) {
+        write_hex8(out, uint32_t(v >> 32), upper);
+        write_hex8(out + 8, uint32_t(v), upper);
+      } else {
+        for (int k = 0; k < 8; k++) {
+          write_bin8(out + 8 * k, uint8_t(v >> (56 - 8 * k)));
+        }
+      }
+    };
+    size_t d = 0; // digits written, from the least significant one
+    for (; d + per_limb <= n; d += per_limb) {
+      write_limb(end - d - per_limb, limb(d / per_limb));
+    }
+    if (d < n) {
+      char top[64];
+      write_limb(top, limb(d / per_limb));
+      std::memcpy(first, top + per_limb - (n - d), n - d);
+    }
+  } else {
+    const char *digits = upper ? UPPER_DIGITS : DIGITS;
+    for (size_t d = 0; d < n; d++) {
+      const size_t bit = d * shift;
+      const size_t off = bit % 64;
+      uint64_t v = limb(bit / 64) >> off;
+      if (off + shift > 64) {
+        v |= limb(bit / 64 + 1) << (64 - off);
+      }
+      end[-1 - ptrdiff_t(d)] = digits[v & ((uint64_t(1) << shift) - 1)];
+    }
+  }
+  return {end, std::errc{}};
+}
+
+// chunks[0 .. count) in base b = base^k, the top chunk without leading zeros
+// and the others padded to k digits
+inline std::to_chars_result chunks_to_chars(char *first, char *last,
+                                            const uint64_t *chunks,
+                                            const uint16_t count,
+                                            const int base, const uint16_t k,
+                                            const bool upper) noexcept {
+  if (count == 0) {
+    if (first == last) {
+      return {last, std::errc::value_too_large};
+    }
+    *first = '0';
+    return {first + 1, std::errc{}};
+  }
+
+  char top[64];
+  const auto t = std::to_chars(top, top + sizeof(top), chunks[count - 1], base);
+  const size_t top_len = size_t(t.ptr - top);
+  if (size_t(last - first) < top_len + size_t(k) * (count - 1)) {
+    return {last, std::errc::value_too_large};
+  }
+  if (upper) {
+    for (size_t i = 0; i < top_len; i++) {
+      top[i] = UPPER_DIGITS[digit_value(top[i])];
+    }
+  }
+  std::memcpy(first, top, top_len);
+  char *out = first + top_len;
+  const char *digits = upper ? UPPER_DIGITS : DIGITS;
+  const uint64_t b = uint64_t(base);
+  for (uint16_t i = count - 1; i-- > 0; out += k) {
+    if (base == 10) {
+      write19(out, chunks[i]);
+    } else {
+      uint64_t v = chunks[i];
+      for (uint16_t j = k; j-- > 0;) {
+        out[j] = digits[v % b];
+        v /= b;
+      }
+    }
+  }
+  return {out, std::errc{}};
+}
+
+// the digits of a[0 .. L) in base 2 .. 36
+template <uint16_t L>
+inline std::to_chars_result limbs_to_chars(char *first, char *last,
+                                           const uint64_t *a,
+                                           const int base = 10,
+                                           const bool upper = false) noexcept {
+  assert(base >= 2 && base <= 36);
+  if (std::has_single_bit(unsigned(base))) {
+    return pow2_to_chars<L>(first, last, a, std::countr_zero(unsigned(base)),
+                            upper);
+  }
+  if (limbs_used<L>(a) <= 1) {
+    const auto r = std::to_chars(first, last, (L == 0) ? 0 : a[0], base);
+    if (upper) {
+      for (char *p = first; p != r.ptr; p++) {
+        *p = UPPER_DIGITS[digit_value(*p)];
+      }
+    }
+    return r;
+  }
+  std::array<uint64_t, max_chunks(L)> chunks;
+  if (base == 10) {
+    const uint16_t count = decimal_chunks<L>(a, chunks.data());
+    return chunks_to_chars(first, last, chunks.data(), count, 10, 19, false);
+  }
+  const auto [k, b] = chunk_base(base);
+  const uint16_t count = short_chunks<L>(a, chunks.data(), Divisor{b});
+  return chunks_to_chars(first, last, chunks.data(), count, base, k, upper);
+}
+
+// parses digits in base 2 .. 36 into out[0 .. L). A value that needs more
+// than L limbs is result_out_of_range, out is unspecified unless ec is 0.
+template <uint16_t L>
+inline std::from_chars_result limbs_from_chars(const char *first,
+                                               const char *last,
+                                               uint64_t *out,
+                                               const int base = 10) noexcept {
+  assert(base >= 2 && base <= 36);
+  const char *end = first;
+  while (end != last && digit_value(*end) < base) {
+    end++;
+  }
+  if (end == first) {
+    return {first, std::errc::invalid_argument};
+  }
+  for (uint16_t i = 0; i < L; i++) {
+    out[i] = 0;
+  }
+  const char *p = first;
+  while (p != end && *p == '0') {
+    p++;
+  }
+  if (p == end) {
+    return {end, std::errc{}};
+  }
+
+  if (std::has_single_bit(unsigned(base))) {
+    const size_t shift = std::countr_zero(unsigned(base));
+    const size_t n = size_t(end - p);
+    const size_t width = (n - 1) * shift + std::bit_width(digit_value(*p));
+    if (width > size_t(64) * L) {
+      return {end, std::errc::result_out_of_range};
+    }
+    for (size_t d = 0; d < n; d++) {
+      const uint64_t v = digit_value(end[-1 - ptrdiff_t(d)]);
+      const size_t bit = d * shift;
+      out[bit / 64] |= v << (bit % 64);
+      if (bit % 64 + shift > 64 && bit / 64 + 1 < L) {
+        out[bit / 64 + 1] |= v >> (64 - bit % 64);
+      }
+    }
+    return {end, std::errc{}};
+  }
+
+  const auto [k, b] = chunk_base(base);
+  // the first chunk takes the digits that do not make a whole chunk
+  size_t len = size_t(end - p) % k;
+  if (len == 0) {
+    len = k;
+  }
+  for (; p != end; p += len, len = k) {
+    uint64_t chunk = 0;
+    uint64_t scale = 1;
+    for (size_t i = 0; i < len; i++) {
+      chunk = chunk * uint64_t(base) + digit_value(p[i]);
+      scale *= uint64_t(base);
+    }
+    // out = out * base^len + chunk
+    uint64_t carry = chunk;
+    for (uint16_t i = 0; i < L; i++) {
+      out[i] = mul_add(out[i], scale, carry, 0, carry);
+    }
+    if (carry != 0) {
+      return {end, std::errc::result_out_of_range};
+    }
+  }
+  return {end, std::errc{}};
+}
+
+// parses an optional '-' and the digits of the magnitude into out[0 .. L)
+template <uint16_t L>
+inline std::from_chars_result
+signed_limbs_from_chars(const char *first, const char *last, uint64_t *out,
+                        bool &negative, const int base = 10) noexcept {
+  negative = (first != last) && (*first == '-');
+  const auto r = limbs_from_chars<L>(first + negative, last, out, base);
+  if (r.ec == std::errc::invalid_argument) {
+    return {first, r.ec};
+  }
+  return r;
+}
+
+// a[0 .. L) with at most BITS significant bits in the base of os (dec, hex
+// or oct), std::showbase and std::uppercase are honored
+template <uint16_t L, size_t BITS>
+std::ostream &print_limbs(std::ostream &os, const uint64_t *a,
+                          const bool negative) {
+  const auto flags = os.flags();
+  const int base = (flags & std::ios_base::hex)   ? 16
+                   : (flags & std::ios_base::oct) ? 8
+                                                  : 10;
+  const bool upper = (flags & std::ios_base::uppercase) != 0;
+  std::array<char, max_digits(BITS, 8) + 3> buf;
+  char *p = buf.data();
+  if (negative) {
+    *p++ = '-';
+  }
+  if ((flags & std::ios_base::showbase) && base != 10 &&
+      bit_width_limbs<L>(a) != 0) {
+    *p++ = '0';
+    if (base == 16) {
+      *p++ = upper ? 'X' : 'x';
+    }
+  }
+  const auto r = limbs_to_chars<L>(p, buf.data() + buf.size(), a, base, upper);
+  return os.write(buf.data(), r.ptr - buf.data());
+}
+
+#ifdef __cpp_lib_format
+
+// The format spec of the std::formatter specializations: [#][type] where
+// type is d (the default), x, X, o, b or B and '#' adds the 0x, 0X, 0, 0b or
+// 0B prefix. The text is built in a buffer on the stack, sized for the
+// widest value of the type.
+struct DigitsFormatter {
+  int base = 10;
+  bool upper = false;
+  bool prefix = false;
+
+  constexpr auto parse(std::format_parse_context &ctx) {
+    auto it = ctx.begin();
+    if (it != ctx.end() && *it == '#') {
+      prefix = true;
+      ++it;
+    }
+    if (it != ctx.end() && *it != '}') {
+      switch (*it) {
+      case 'd':
+        base = 10;
+        break;
+      case 'x':
+        base = 16;
+        break;
+      case 'X':
+        base = 16;
+        upper = true;
+        break;
+      case 'o':
+        base = 8;
+        break;
+      case 'b':
+        base = 2;
+        break;
+      case 'B':
+        base = 2;
+        upper = true;
+        break;
+      default:
+        throw std::format_error("mango: invalid format spec");
+      }
+      ++it;
+    }
+    if (it != ctx.end() && *it != '}') {
+      throw std::format_error("mango: invalid format spec");
+    }
+    return it;
+  }
+
+  // a[0 .. L) with at most BITS significant bits
+  template <uint16_t L, size_t BITS, typename Context>
+  auto format_limbs(const uint64_t *a, const bool negative,
+                    Context &ctx) const {
+    std::array<char, max_digits(BITS, 2) + 3> buf;
+    char *p = buf.data();
+    if (negative) {
+      *p++ = '-';
+    }
+    if (prefix && base != 10 && !(base == 8 && bit_width_limbs<L>(a) == 0)) {
+      *p++ = '0';
+      if (base == 16) {
+        *p++ = upper ? 'X' : 'x';
+      } else if (base == 2) {
+        *p++ = upper ? 'B' : 'b';
+      }
+    }
+    const auto r =
+        limbs_to_chars<L>(p, buf.data() + buf.size(), a, base, upper);
+    return std::copy(buf.data(), r.ptr, ctx.out());
+  }
+};
+
+#endif
+
+} // namespace mango
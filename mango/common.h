@@ -1,5 +1,6 @@
 #pragma once
 
+#include <bit>
 #include <cstdint>
 #include <cstdio>
 #include <iostream>
@@ -7,6 +8,10 @@
 #include <type_traits>
 #include <utility>
 
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
 namespace mango {
 
 typedef unsigned int uint128_t __attribute__((mode(TI)));
@@ -20,43 +25,101 @@ constexpr const T safe_max(const T a, const T b) noexcept {
   return (a > b) ? a : b;
 }
 
-consteval uint16_t clz(uint64_t a) {
-#ifdef __clang__
-  // __builtin_clzll is not constexpr in clang :-(
-  uint16_t count = 0;
-  if (a == 0)
-    return 64;
+// std::countl_zero and friends are constexpr and defined for 0. At run time
+// they lower to lzcnt, tzcnt and popcnt when the target has them (-mlzcnt,
+// -mbmi, -mpopcnt or a -march that implies them)
+constexpr uint16_t clz(const uint64_t a) noexcept {
+  return std::countl_zero(a);
+}
 
-  if ((a & 0xFFFFFFFF00000000) == 0) {
-    count += 32;
-    a <<= 32;
-  }
-  if ((a & 0xFFFF000000000000) == 0) {
-    count += 16;
-    a <<= 16;
-  }
-  if ((a & 0xFF00000000000000) == 0) {
-    count += 8;
-    a <<= 8;
-  }
-  if ((a & 0xF000000000000000) == 0) {
-    count += 4;
-    a <<= 4;
-  }
-  if ((a & 0xC000000000000000) == 0) {
-    count += 2;
-    a <<= 2;
+constexpr uint16_t ctz(const uint64_t a) noexcept {
+  return std::countr_zero(a);
+}
+
+constexpr uint16_t popcnt(const uint64_t a) noexcept {
+  return std::popcount(a);
+}
+
+// a + b + carry_in, carry_out is set to 0 or 1. Lowers to a single adc so a
+// loop over limbs becomes one carry chain.
+constexpr uint64_t addc(const uint64_t a, const uint64_t b,
+                        const uint64_t carry_in, uint64_t &carry_out) noexcept {
+  if !consteval {
+#if __has_builtin(__builtin_addcll)
+    unsigned long long c;
+    const auto sum = __builtin_addcll(a, b, carry_in, &c);
+    carry_out = c;
+    return sum;
+#elif defined(__x86_64__)
+    unsigned long long sum;
+    carry_out = _addcarry_u64((unsigned char)carry_in, a, b, &sum);
+    return sum;
+#endif
   }
-  if ((a & 0x8000000000000000) == 0) {
-    count += 1;
+  const uint128_t sum = uint128_t(a) + b + carry_in;
+  carry_out = uint64_t(sum >> 64);
+  return uint64_t(sum);
+}
+
+// a - b - borrow_in, borrow_out is set to 0 or 1. Lowers to a single sbb.
+constexpr uint64_t subb(const uint64_t a, const uint64_t b,
+                        const uint64_t borrow_in,
+                        uint64_t &borrow_out) noexcept {
+  if !consteval {
+#if __has_builtin(__builtin_subcll)
+    unsigned long long c;
+    const auto diff = __builtin_subcll(a, b, borrow_in, &c);
+    borrow_out = c;
+    return diff;
+#elif defined(__x86_64__)
+    unsigned long long diff;
+    borrow_out = _subborrow_u64((unsigned char)borrow_in, a, b, &diff);
+    return diff;
+#endif
   }
-  return count;
-#else
-  return __builtin_clzll(a);
+  const uint128_t diff = uint128_t(a) - b - borrow_in;
+  borrow_out = uint64_t(diff >> 64) & 1;
+  return uint64_t(diff);
+}
+
+// (hi * 2^64 + lo) / d, requires hi < d so the quotient fits in 64 bits
+constexpr uint64_t div128(const uint64_t hi, const uint64_t lo,
+                          const uint64_t d, uint64_t &rem) noexcept {
+  if !consteval {
+#if defined(__x86_64__)
+    uint64_t q;
+    asm("divq %4" : "=a"(q), "=d"(rem) : "a"(lo), "d"(hi), "rm"(d));
+    return q;
 #endif
+  }
+  const uint128_t n = (uint128_t(hi) << 64) | lo;
+  rem = uint64_t(n % d);
+  return uint64_t(n / d);
+}
+
+// (lo >> r) | (hi << (64 - r)) for r < 64 without a branch on r == 0, one shrd
+constexpr uint64_t funnel_shr(const uint64_t hi, const uint64_t lo,
+                              const uint64_t r) noexcept {
+  return (lo >> r) | ((hi << 1) << (63 - r));
+}
+
+// (hi << r) | (lo >> (64 - r)) for r < 64 without a branch on r == 0, one shld
+constexpr uint64_t funnel_shl(const uint64_t hi, const uint64_t lo,
+                              const uint64_t r) noexcept {
+  return (hi << r) | ((lo >> 1) >> (63 - r));
 }
 
-template <typename T> constexpr T max(T a, T b) { return (a > b) ? a : b; }
+template <typename T>
+  requires std::is_arithmetic_v<T>
+constexpr T max(T a, T b) {
+  return (a > b) ? a : b;
+}
+
+template <typename T>
+  requires std::is_arithmetic_v<T>
+constexpr T min(T a, T b) {
+  return (a < b) ? a : b;
+}
 
 enum struct Cmp { LT = -1, EQ = 0, GT = 1 };
 
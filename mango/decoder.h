@@ -0,0 +1,281 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mango/bits.h"
+#include "mango/masked_bits.h"
+
+namespace mango {
+
+// fixed bits of a pattern as plain words, the decoder works on the low limb
+struct DecoderPattern {
+  uint64_t mask;
+  uint64_t value;
+};
+
+// A node indexes entries[entries ..) with bits [lo, lo + width) of the
+// word. A leaf has width 0 and no entries, it tries
+// items[items, items + count) in order.
+struct DecoderNode {
+  uint8_t lo;
+  uint8_t width;
+  uint16_t count;
+  uint16_t items;
+  uint16_t entries;
+};
+
+struct DecoderTables {
+  std::vector<DecoderNode> nodes; // nodes[0] is the root
+  std::vector<uint16_t> entries;  // node ids
+  std::vector<uint16_t> items;    // pattern ids
+  uint16_t depth = 0;             // longest path from the root to a leaf
+};
+
+// widest jump table, 2^8 entries
+constexpr uint16_t DECODER_MAX_WIDTH = 8;
+
+// The field [lo, lo + width) to split the candidates on, width 0 when a
+// leaf that checks the candidates one by one is cheaper. A field costs one
+// table lookup, plus the expected number of candidates left for a random
+// word (a candidate with k fixed bits in the field is left in 1 / 2^k of the
+// entries), plus 1/4096 of a check per table entry. A 256-entry table is
+// only 512 bytes, so wide fields that resolve many candidates in one lookup
+// win over chains of narrow ones, each a dependent load and a branch.
+constexpr std::pair<uint16_t, uint16_t>
+decoder_split(const DecoderPattern *ps, const std::vector<uint16_t> &set,
+              const uint64_t open) {
+  std::pair<uint16_t, uint16_t> best{0, 0};
+  double best_cost = double(set.size());
+  for (uint16_t lo = 0; lo < 64; lo++) {
+    for (uint16_t w = 1; w <= DECODER_MAX_WIDTH && lo + w <= 64; w++) {
+      const uint64_t field = ((uint64_t(1) << w) - 1) << lo;
+      if ((field & ~open) != 0) {
+        break;
+      }
+      double left = 0;
+      for (const uint16_t c : set) {
+        left += 1.0 / double(uint64_t(1) << std::popcount(ps[c].mask & field));
+      }
+      const double cost = 1 + left + double(uint64_t(1) << w) / 4096;
+      if (cost < best_cost) {
+        best = {lo, w};
+        best_cost = cost;
+      }
+    }
+  }
+  return best;
+}
+
+// Splits the patterns until every leaf has one candidate or the remaining
+// candidates cannot be told apart by a table, then the leaf checks them in
+// order. A subtree only depends on its candidates and on the bits already
+// decided, equal subtrees are shared.
+constexpr DecoderTables build_decoder(const DecoderPattern *ps,
+                                      const uint16_t count,
+                                      const uint16_t width) {
+  struct Pending {
+    std::vector<uint16_t> set;
+    uint64_t decided;
+  };
+  std::vector<Pending> work;
+  DecoderTables t;
+  const auto node_for = [&](const std::vector<uint16_t> &set,
+                            const uint64_t decided) {
+    for (size_t i = 0; i < work.size(); i++) {
+      if (work[i].decided == decided && work[i].set == set) {
+        return uint16_t(i);
+      }
+    }
+    work.push_back({set, decided});
+    t.nodes.push_back({});
+    return uint16_t(work.size() - 1);
+  };
+
+  std::vector<uint16_t> all;
+  for (uint16_t i = 0; i < count; i++) {
+    all.push_back(i);
+  }
+  const uint64_t word = (width >= 64) ? ~uint64_t(0)
+                                      : (uint64_t(1) << width) - 1;
+  node_for(all, ~word);
+
+  for (size_t id = 0; id < work.size(); id++) {
+    std::vector<uint16_t> set = work[id].set;
+    const uint64_t decided = work[id].decided;
+    // a candidate whose fixed bits are all decided always matches
+    for (size_t k = 0; k < set.size(); k++) {
+      if ((ps[set[k]].mask & ~decided) == 0) {
+        set.resize(k + 1);
+        break;
+      }
+    }
+
+    const auto [lo, w] = decoder_split(ps, set, ~decided);
+    const uint16_t first = uint16_t(t.entries.size());
+    if (w == 0) {
+      t.nodes[id] = {0, 0, uint16_t(set.size()), uint16_t(t.items.size()),
+                     first};
+      for (const uint16_t c : set) {
+        t.items.push_back(c);
+      }
+      continue;
+    }
+    t.entries.resize(first + (size_t(1) << w));
+
+    const uint64_t field = ((uint64_t(1) << w) - 1) << lo;
+    t.nodes[id] = {uint8_t(lo), uint8_t(w), 0, 0, first};
+    for (uint64_t v = 0; v < (uint64_t(1) << w); v++) {
+      std::vector<uint16_t> child;
+      for (const uint16_t c : set) {
+        if (((ps[c].value ^ (v << lo)) & ps[c].mask & field) == 0) {
+          child.push_back(c);
+        }
+      }
+      const uint16_t next = node_for(child, decided | field);
+      t.entries[first + v] = next;
+    }
+  }
+
+  // every step decides at least one more bit, so no path is longer than 64
+  std::vector<uint16_t> height(t.nodes.size(), 0);
+  for (uint16_t round = 0; round <= 64; round++) {
+    for (size_t id = 0; id < t.nodes.size(); id++) {
+      const DecoderNode &n = t.nodes[id];
+      for (size_t v = 0; n.width != 0 && v < (size_t(1) << n.width); v++) {
+        const uint16_t h = height[t.entries[n.entries + v]] + 1;
+        height[id] = (h > height[id]) ? h : height[id];
+      }
+    }
+  }
+  t.depth = height[0];
+  return t;
+}
+
+// Dispatches an N-bit word (N <= 64) to the first of the MaskedBits
+// patterns that matches it, like a linear scan over the patterns but with a
+// decision tree of jump tables built at compile time:
+//
+//    using D = Decoder<MaskedBits<32, Nat<0xff000000>, Nat<0x1a000000>>,
+//                      MaskedBits<32, Nat<0xff000000>, Nat<0x3a000000>>>;
+//    D::decode(word, [](const auto ins) { ... }, [](Bits<32>) { ... });
+//
+// The handler is called with the matching MaskedBits type, the miss handler
+// with the word. Both must return the same type (or void).
+template <typename... Patterns> struct Decoder;
+
+template <uint16_t N, typename... Masks, typename... Values>
+struct Decoder<MaskedBits<N, Masks, Values>...> {
+  static_assert(N <= 64, "Decoder works on words of up to 64 bits");
+  static_assert(sizeof...(Masks) < 65535, "too many patterns");
+
+  constexpr static uint16_t WIDTH = N;
+  constexpr static uint16_t COUNT = sizeof...(Masks);
+
+  template <size_t I>
+  using Pattern = std::tuple_element_t<
+      I, std::tuple<MaskedBits<N, Masks, Values>...>>;
+
+  constexpr static std::array<DecoderPattern, COUNT> PATTERNS{
+      {{Masks{}.get(0), Values{}.get(0)}...}};
+
+  static_assert(((Values{}.bit_size() <= N) && ...));
+  static_assert(((Masks{}.bit_size() <= N) && ...));
+  static_assert(((((Values{}.get(0) & ~Masks{}.get(0))) == 0) && ...),
+                "a pattern value has bits outside its mask");
+
+  constexpr static auto SIZES = [] {
+    const auto t = build_decoder(PATTERNS.data(), COUNT, N);
+    return std::array<size_t, 4>{t.nodes.size(), t.entries.size(),
+                                 t.items.size(), t.depth};
+  }();
+
+  constexpr static uint16_t DEPTH = uint16_t(SIZES[3]);
+  static_assert(SIZES[0] <= 65536 && SIZES[1] <= 65536,
+                "the decoder tables are too large");
+
+  struct Tables {
+    std::array<DecoderNode, SIZES[0]> nodes;
+    std::array<uint16_t, SIZES[1]> entries;
+    std::array<uint16_t, SIZES[2]> items;
+  };
+
+  constexpr static Tables TABLES = [] {
+    const auto t = build_decoder(PATTERNS.data(), COUNT, N);
+    Tables out{};
+    for (size_t i = 0; i < SIZES[0]; i++) {
+      out.nodes[i] = t.nodes[i];
+    }
+    for (size_t i = 0; i < SIZES[1]; i++) {
+      out.entries[i] = t.entries[i];
+    }
+    for (size_t i = 0; i < SIZES[2]; i++) {
+      out.items[i] = t.items[i];
+    }
+    return out;
+  }();
+
+  // index of the first pattern that matches bits, COUNT when none does. The
+  // walk stops at the first leaf, at most DEPTH lookups.
+  constexpr static uint16_t match(const Bits<N> &bits) noexcept {
+    const uint64_t w = bits.get(0);
+    const DecoderNode *node = &TABLES.nodes[0];
+    while (node->width != 0) {
+      const uint64_t v = (w >> node->lo) & ((uint64_t(1) << node->width) - 1);
+      node = &TABLES.nodes[TABLES.entries[node->entries + v]];
+    }
+    const DecoderNode &leaf = *node;
+    for (uint16_t i = 0; i < leaf.count; i++) {
+      const uint16_t p = TABLES.items[leaf.items + i];
+      if ((w & PATTERNS[p].mask) == PATTERNS[p].value) {
+        return p;
+      }
+    }
+    return COUNT;
+  }
+
+  template <typename Handler, typename Miss>
+  using Result = std::common_type_t<
+      std::invoke_result_t<Handler &, MaskedBits<N, Masks, Values>>...,
+      std::invoke_result_t<Miss &, const Bits<N> &>>;
+
+  // calls the handler through a table indexed by the pattern, one indirect
+  // jump like a switch
+  template <typename Handler, typename Miss>
+  constexpr static Result<Handler, Miss>
+  decode(const Bits<N> &bits, Handler &&handler, Miss &&miss) {
+    return CALLS<std::remove_reference_t<Handler>,
+                 std::remove_reference_t<Miss>>[match(bits)](bits, handler,
+                                                             miss);
+  }
+
+private:
+  template <size_t I, typename R, typename Handler, typename Miss>
+  constexpr static R call(const Bits<N> &bits, Handler &handler, Miss &miss) {
+    if constexpr (I == COUNT) {
+      return miss(bits);
+    } else {
+      return handler(Pattern<I>{bits});
+    }
+  }
+
+  template <typename Handler, typename Miss>
+  using Call = Result<Handler, Miss> (*)(const Bits<N> &, Handler &, Miss &);
+
+  // call<I> for every pattern, then the miss handler
+  template <typename Handler, typename Miss>
+  constexpr static std::array<Call<Handler, Miss>, COUNT + 1> CALLS =
+      []<size_t... Is>(std::index_sequence<Is...>) {
+        using R = Result<Handler, Miss>;
+        return std::array<Call<Handler, Miss>, COUNT + 1>{
+            &call<Is, R, Handler, Miss>..., &call<COUNT, R, Handler, Miss>};
+      }(std::make_index_sequence<COUNT>{});
+};
+
+} // namespace mango
@@ -0,0 +1,595 @@
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <memory_resource>
+#include <type_traits>
+#include <utility>
+
+#include "mango/bits.h"
+#include "mango/limbs.h"
+
+namespace mango {
+
+// A Bits whose width is only known at run time, up to 65535 bits:
+//
+//    std::array<std::byte, 4096> buffer;
+//    std::pmr::monotonic_buffer_resource arena{buffer.data(), buffer.size()};
+//    DynBits a{width, &arena};
+//    auto b = a + Bits<64>{x};   // DynBits of max(width, 64) + 1 bits
+//
+// Values of up to 128 bits live in the object. Wider ones take their limbs
+// from a std::pmr::memory_resource, the default resource (new / delete)
+// unless one is given. The result of an operation uses the arena of its left
+// DynBits operand, so temporaries in a loop over a monotonic arena never
+// call malloc. Operations have the result widths of the Bits<N> operations
+// and run on the same limb kernels. Bits at and above width() are zero.
+
+struct DynBits;
+
+// the limbs of a Bits or DynBits operand
+struct DynBitsView {
+  const uint64_t *limbs;
+  uint16_t width;
+
+  uint16_t size() const noexcept { return limb_count(width); }
+
+  uint64_t get(const uint64_t i) const noexcept {
+    return (i < size()) ? limbs[i] : 0;
+  }
+
+  // limb i of the value sign extended to any width
+  uint64_t sign_extended(const uint64_t i) const noexcept {
+    if (width == 0) {
+      return 0;
+    }
+    const uint16_t top = size() - 1;
+    const uint64_t sign = (limbs[top] >> ((width - 1) % 64)) & 1;
+    const uint64_t fill = uint64_t(0) - sign;
+    if (i < top) {
+      return limbs[i];
+    } else if (i == top) {
+      const uint64_t mask = (width % 64 == 0)
+                                ? ~uint64_t(0)
+                                : (uint64_t(1) << (width % 64)) - 1;
+      return limbs[i] | (fill & ~mask);
+    } else {
+      return fill;
+    }
+  }
+};
+
+template <typename T> struct is_dyn_operand : std::false_type {};
+template <uint16_t N> struct is_dyn_operand<Bits<N>> : std::true_type {};
+template <> struct is_dyn_operand<DynBits> : std::true_type {};
+
+// at least one side is a DynBits, the other one may be a Bits<N>
+template <typename L, typename R>
+concept DynOperands =
+    is_dyn_operand<L>::value && is_dyn_operand<R>::value &&
+    (std::is_same_v<L, DynBits> || std::is_same_v<R, DynBits>);
+
+struct DynBits {
+  using Arena = std::pmr::memory_resource;
+
+  constexpr static uint16_t INLINE_LIMBS = 2;
+
+  // zero
+  explicit DynBits(const uint16_t width = 0,
+                   Arena *arena = std::pmr::get_default_resource())
+      : DynBits(width, 0, arena) {}
+
+  // v truncated to width bits, like Bits<N>{v}
+  template <typename T>
+    requires std::is_integral_v<T>
+  DynBits(const uint16_t width, const T v,
+          Arena *arena = std::pmr::get_default_resource())
+      : arena_(arena) {
+    resize(width);
+    uint64_t *out = limbs();
+    for (uint16_t i = 0; i < size(); i++) {
+      out[i] = (i == 0) ? uint64_t(int64_t(v)) : 0;
+    }
+    mask_top();
+  }
+
+  template <uint16_t N>
+  explicit DynBits(const Bits<N> &bits,
+                   Arena *arena = std::pmr::get_default_resource())
+      : DynBits(view(bits), arena) {}
+
+  DynBits(const DynBits &rhs, Arena *arena) : DynBits(view(rhs), arena) {}
+
+  DynBits(const DynBits &rhs) : DynBits(rhs, rhs.arena_) {}
+
+  DynBits(DynBits &&rhs) noexcept
+      : width_(rhs.width_), capacity_(rhs.capacity_), arena_(rhs.arena_) {
+    if (is_inline()) {
+      small_[0] = rhs.small_[0];
+      small_[1] = rhs.small_[1];
+    } else {
+      large_ = rhs.large_;
+      rhs.capacity_ = INLINE_LIMBS;
+      rhs.width_ = 0;
+    }
+  }
+
+  DynBits &operator=(const DynBits &rhs) {
+    if (this != &rhs) {
+      assign(view(rhs));
+    }
+    return *this;
+  }
+
+  // the limbs move when both sides use the same arena, otherwise they are
+  // copied into this arena, which can allocate and throw
+  DynBits &operator=(DynBits &&rhs) {
+    if (this == &rhs) {
+      return *this;
+    }
+    if (rhs.is_inline() || (arena_ != rhs.arena_)) {
+      assign(view(rhs));
+    } else {
+      release();
+      width_ = rhs.width_;
+      capacity_ = rhs.capacity_;
+      large_ = rhs.large_;
+      rhs.capacity_ = INLINE_LIMBS;
+      rhs.width_ = 0;
+    }
+    return *this;
+  }
+
+  ~DynBits() { release(); }
+
+  uint16_t width() const noexcept { return width_; }
+  Arena *arena() const noexcept { return arena_; }
+
+  // number of limbs
+  uint16_t size() const noexcept { return limb_count(width_); }
+
+  const uint64_t *data() const noexcept {
+    return is_inline() ? small_ : large_;
+  }
+
+  uint64_t get(const uint64_t i) const noexcept {
+    return (i < size()) ? data()[i] : 0;
+  }
+
+  // the low N bits, zero extended when N > width()
+  template <uint16_t N> Bits<N> to_bits() const noexcept {
+    typename Bits<N>::Limbs out{};
+    for (uint16_t i = 0; i < Bits<N>::LIMBS; i++) {
+      out[i] = get(i);
+    }
+    return Bits<N>{out};
+  }
+
+  // resizing
+
+  DynBits zero_extend(const uint16_t width) const {
+    assert(width >= width_);
+    return resized(width, 0);
+  }
+
+  DynBits sign_extend(const uint16_t width) const {
+    assert(width >= width_);
+    return resized(width, 1);
+  }
+
+  DynBits trim(const uint16_t width) const {
+    assert(width <= width_);
+    return resized(width, 0);
+  }
+
+  // bits [low, high]
+  DynBits extract(const uint16_t high, const uint16_t low) const {
+    assert((high >= low) && (high < width_));
+    return shifted_right(view(*this), low, high - low + 1, arena_);
+  }
+
+  // shifts by a runtime amount, shl grows the result to hold every bit and
+  // shr drops the bits shifted out
+
+  DynBits shl(const uint16_t s) const {
+    assert(uint32_t(width_) + s <= UINT16_MAX);
+    DynBits out{uint16_t(width_ + s), arena_, Uninitialized{}};
+    uint64_t *o = out.limbs();
+    const uint16_t q = s / 64;
+    const uint16_t r = s % 64;
+    for (uint16_t i = 0; i < out.size(); i++) {
+      const uint64_t lo = (i > q) ? get(i - q - 1) : 0;
+      const uint64_t hi = (i >= q) ? get(i - q) : 0;
+      o[i] = funnel_shl(hi, lo, r);
+    }
+    return out;
+  }
+
+  DynBits shr(const uint16_t s) const {
+    return shifted_right(view(*this), s, safe_sub(width_, s), arena_);
+  }
+
+  // arithmetic, see the operators below
+
+  static DynBits add(const DynBitsView a, const DynBitsView b, Arena *arena) {
+    if (b.width == 0) {
+      return DynBits{a, arena};
+    } else if (a.width == 0) {
+      return DynBits{b, arena};
+    }
+    const uint16_t width = wider(a.width, b.width);
+    DynBits out{width, arena, Uninitialized{}};
+    uint64_t *o = out.limbs();
+    for (uint16_t i = 0; i < out.size(); i++) {
+      o[i] = a.get(i);
+    }
+    add_limbs(o, b.limbs, out.size(), b.size());
+    return out;
+  }
+
+  // both sides are sign extended, like Bits<N> - Bits<M>
+  static DynBits sub(const DynBitsView a, const DynBitsView b, Arena *arena) {
+    DynBits out{wider(a.width, b.width), arena, Uninitialized{}};
+    uint64_t *o = out.limbs();
+    uint64_t borrow = 0;
+    for (uint16_t i = 0; i < out.size(); i++) {
+      o[i] = subb(a.sign_extended(i), b.sign_extended(i), borrow, borrow);
+    }
+    out.mask_top();
+    return out;
+  }
+
+  static DynBits mul(const DynBitsView a, const DynBitsView b, Arena *arena) {
+    assert(uint32_t(a.width) + b.width <= UINT16_MAX);
+    const uint16_t width = a.width + b.width;
+    if ((a.width == 0) || (b.width == 0)) {
+      return DynBits{width, arena};
+    }
+    // the product fits in width bits, the limbs above it are zero and are
+    // not computed, so a product of up to 128 bits stays inline
+    DynBits out{width, arena, Uninitialized{}};
+    mul_low_limbs(a.limbs, a.size(), b.limbs, b.size(), out.limbs(),
+                  out.size());
+    return out;
+  }
+
+  static std::pair<DynBits, DynBits> divide(const DynBitsView a,
+                                            const DynBitsView b,
+                                            Arena *arena) {
+    assert(bit_width_limbs(b.limbs, b.size()) != 0);
+    const uint16_t la = a.size();
+    const uint16_t lb = b.size();
+    DynBits q{a.width, arena, Uninitialized{}};
+    DynBits r{min(a.width, b.width), arena, Uninitialized{}};
+    // scratch space for the remainder, on the stack for narrow operands
+    std::array<uint64_t, 4 * INLINE_LIMBS + 1> stack;
+    const size_t work_size = size_t(la) + lb + 1;
+    const size_t work_bytes = work_size * sizeof(uint64_t);
+    uint64_t *work = (work_size <= stack.size())
+                         ? stack.data()
+                         : static_cast<uint64_t *>(
+                               arena->allocate(work_bytes, alignof(uint64_t)));
+    if (la == 0) {
+      for (uint16_t i = 0; i < lb; i++) {
+        work[i] = 0;
+      }
+    } else {
+      divmod_limbs(a.limbs, la, b.limbs, lb, q.limbs(), work);
+    }
+    uint64_t *rem = r.limbs();
+    for (uint16_t i = 0; i < r.size(); i++) {
+      rem[i] = work[i];
+    }
+    if (work != stack.data()) {
+      arena->deallocate(work, work_bytes, alignof(uint64_t));
+    }
+    return {std::move(q), std::move(r)};
+  }
+
+  // bitwise, the shorter operand is zero extended
+
+  template <BitOp Op>
+  static DynBits bitwise(const DynBitsView a, const DynBitsView b,
+                         Arena *arena) {
+    const uint16_t width = (Op == BitOp::AND)      ? min(a.width, b.width)
+                           : (Op == BitOp::ANDNOT) ? a.width
+                                                   : max(a.width, b.width);
+    DynBits out{width, arena, Uninitialized{}};
+    uint64_t *o = out.limbs();
+    const uint16_t common = min(min(a.size(), b.size()), out.size());
+    bitwise_limbs<Op>(o, a.limbs, b.limbs, common);
+    // past the shorter operand OR and XOR copy the longer one, ANDNOT
+    // copies a
+    const DynBitsView &tail = (a.size() > common) ? a : b;
+    for (uint16_t i = common; i < out.size(); i++) {
+      o[i] = tail.limbs[i];
+    }
+    return out;
+  }
+
+  // wrapping arithmetic keeps the width of *this, like Bits<N>::add_wrap
+
+  template <typename R>
+    requires is_dyn_operand<R>::value
+  DynBits add_wrap(const R &rhs) const {
+    const DynBitsView b = view(rhs);
+    DynBits out{*this};
+    add_limbs(out.limbs(), b.limbs, size(), min(b.size(), size()));
+    out.mask_top();
+    return out;
+  }
+
+  template <typename R>
+    requires is_dyn_operand<R>::value
+  DynBits sub_wrap(const R &rhs) const {
+    const DynBitsView b = view(rhs);
+    DynBits out{width_, arena_, Uninitialized{}};
+    uint64_t *o = out.limbs();
+    uint64_t borrow = 0;
+    for (uint16_t i = 0; i < size(); i++) {
+      const uint64_t r = (b.width < width_) ? b.sign_extended(i) : b.get(i);
+      o[i] = subb(data()[i], r, borrow, borrow);
+    }
+    out.mask_top();
+    return out;
+  }
+
+  template <typename R>
+    requires is_dyn_operand<R>::value
+  DynBits mul_wrap(const R &rhs) const {
+    const DynBitsView b = view(rhs);
+    DynBits out{width_, arena_, Uninitialized{}};
+    mul_low_limbs(data(), size(), b.limbs, min(b.size(), size()), out.limbs(),
+                  size());
+    out.mask_top();
+    return out;
+  }
+
+  // rhs is a Bits<N> or a DynBits, the quotient has the width of *this and
+  // the remainder the smaller width, rhs must not be zero
+  template <typename R>
+    requires is_dyn_operand<R>::value
+  std::pair<DynBits, DynBits> divmod(const R &rhs) const {
+    return divide(view(*this), view(rhs), arena_);
+  }
+
+  // *this & ~rhs, keeps the width of *this
+  template <typename R>
+    requires is_dyn_operand<R>::value
+  DynBits andnot(const R &rhs) const {
+    return bitwise<BitOp::ANDNOT>(view(*this), view(rhs), arena_);
+  }
+
+  template <typename R>
+    requires is_dyn_operand<R>::value
+  Cmp cmp(const R &rhs) const noexcept {
+    return compare(view(*this), view(rhs));
+  }
+
+  DynBits operator~() const {
+    DynBits out{width_, arena_, Uninitialized{}};
+    uint64_t *o = out.limbs();
+    for (uint16_t i = 0; i < size(); i++) {
+      o[i] = ~data()[i];
+    }
+    out.mask_top();
+    return out;
+  }
+
+  // comparison, from the top limb down
+
+  static Cmp compare(const DynBitsView a, const DynBitsView b) noexcept {
+    for (uint16_t i = max(a.size(), b.size()); i-- > 0;) {
+      const uint64_t left = a.get(i);
+      const uint64_t right = b.get(i);
+      if (left != right) {
+        return (left > right) ? Cmp::GT : Cmp::LT;
+      }
+    }
+    return Cmp::EQ;
+  }
+
+  // counting
+
+  uint16_t count_ones() const noexcept {
+    return popcount_limbs(data(), size());
+  }
+
+  uint16_t leading_zeros() const noexcept {
+    return width_ - bit_width_limbs(data(), size());
+  }
+
+  uint16_t trailing_zeros() const noexcept {
+    return min(width_, countr_zero_limbs(data(), size()));
+  }
+
+  bool any() const noexcept { return limbs_used(data(), size()) != 0; }
+  bool none() const noexcept { return !any(); }
+
+  static DynBitsView view(const DynBits &b) noexcept {
+    return {b.data(), b.width_};
+  }
+
+  template <uint16_t N> static DynBitsView view(const Bits<N> &b) noexcept {
+    if constexpr (N == 0) {
+      return {nullptr, 0};
+    } else {
+      return {b.limbs, N};
+    }
+  }
+
+private:
+  struct Uninitialized {};
+
+  uint16_t width_ = 0;
+  uint16_t capacity_ = INLINE_LIMBS; // limbs, inline up to INLINE_LIMBS
+  Arena *arena_;
+  union {
+    uint64_t small_[INLINE_LIMBS]{};
+    uint64_t *large_;
+  };
+
+  // width bits with room for capacity limbs, the limbs are not set
+  DynBits(const uint16_t width, Arena *arena, Uninitialized,
+          const uint16_t capacity = 0)
+      : arena_(arena) {
+    reserve(max(capacity, limb_count(width)));
+    width_ = width;
+  }
+
+  DynBits(const DynBitsView v, Arena *arena) : arena_(arena) { assign(v); }
+
+  // max(a, b) + 1, the width of a sum or a difference
+  static uint16_t wider(const uint16_t a, const uint16_t b) noexcept {
+    assert(max(a, b) < UINT16_MAX);
+    return max(a, b) + 1;
+  }
+
+  bool is_inline() const noexcept { return capacity_ <= INLINE_LIMBS; }
+
+  uint64_t *limbs() noexcept { return is_inline() ? small_ : large_; }
+
+  void release() noexcept {
+    if (!is_inline()) {
+      arena_->deallocate(large_, capacity_ * sizeof(uint64_t),
+                         alignof(uint64_t));
+      capacity_ = INLINE_LIMBS;
+    }
+  }
+
+  // room for at least n limbs, the current limbs are lost when they move
+  void reserve(const uint16_t n) {
+    if (n > capacity_) {
+      release();
+      large_ = static_cast<uint64_t *>(
+          arena_->allocate(n * sizeof(uint64_t), alignof(uint64_t)));
+      capacity_ = n;
+    }
+  }
+
+  void resize(const uint16_t width) {
+    reserve(limb_count(width));
+    width_ = width;
+  }
+
+  void assign(const DynBitsView v) {
+    resize(v.width);
+    uint64_t *out = limbs();
+    for (uint16_t i = 0; i < size(); i++) {
+      out[i] = v.limbs[i];
+    }
+  }
+
+  void mask_top() noexcept {
+    if (width_ % 64 != 0) {
+      limbs()[size() - 1] &= (uint64_t(1) << (width_ % 64)) - 1;
+    }
+  }
+
+  // sign = 1 extends with the top bit, sign = 0 with zeros
+  DynBits resized(const uint16_t width, const uint64_t sign) const {
+    const DynBitsView v = view(*this);
+    DynBits out{width, arena_, Uninitialized{}};
+    uint64_t *o = out.limbs();
+    for (uint16_t i = 0; i < out.size(); i++) {
+      o[i] = (sign != 0) ? v.sign_extended(i) : v.get(i);
+    }
+    out.mask_top();
+    return out;
+  }
+
+  // width bits of v >> s
+  static DynBits shifted_right(const DynBitsView v, const uint16_t s,
+                               const uint16_t width, Arena *arena) {
+    DynBits out{width, arena, Uninitialized{}};
+    uint64_t *o = out.limbs();
+    const uint16_t q = s / 64;
+    const uint16_t r = s % 64;
+    for (uint16_t i = 0; i < out.size(); i++) {
+      o[i] = funnel_shr(v.get(i + q + 1), v.get(i + q), r);
+    }
+    out.mask_top();
+    return out;
+  }
+};
+
+namespace dyn_bits {
+
+// the arena of the left DynBits operand
+template <typename L, typename R>
+DynBits::Arena *arena(const L &lhs, const R &rhs) noexcept {
+  if constexpr (std::is_same_v<L, DynBits>) {
+    return lhs.arena();
+  } else {
+    return rhs.arena();
+  }
+}
+
+} // namespace dyn_bits
+
+template <typename L, typename R>
+  requires DynOperands<L, R>
+DynBits operator+(const L &lhs, const R &rhs) {
+  return DynBits::add(DynBits::view(lhs), DynBits::view(rhs),
+                      dyn_bits::arena(lhs, rhs));
+}
+
+template <typename L, typename R>
+  requires DynOperands<L, R>
+DynBits operator-(const L &lhs, const R &rhs) {
+  return DynBits::sub(DynBits::view(lhs), DynBits::view(rhs),
+                      dyn_bits::arena(lhs, rhs));
+}
+
+template <typename L, typename R>
+  requires DynOperands<L, R>
+DynBits operator*(const L &lhs, const R &rhs) {
+  return DynBits::mul(DynBits::view(lhs), DynBits::view(rhs),
+                      dyn_bits::arena(lhs, rhs));
+}
+
+template <typename L, typename R>
+  requires DynOperands<L, R>
+DynBits operator/(const L &lhs, const R &rhs) {
+  return DynBits::divide(DynBits::view(lhs), DynBits::view(rhs),
+                         dyn_bits::arena(lhs, rhs))
+      .first;
+}
+
+template <typename L, typename R>
+  requires DynOperands<L, R>
+DynBits operator%(const L &lhs, const R &rhs) {
+  return DynBits::divide(DynBits::view(lhs), DynBits::view(rhs),
+                         dyn_bits::arena(lhs, rhs))
+      .second;
+}
+
+template <typename L, typename R>
+  requires DynOperands<L, R>
+DynBits operator&(const L &lhs, const R &rhs) {
+  return DynBits::bitwise<BitOp::AND>(DynBits::view(lhs), DynBits::view(rhs),
+                                      dyn_bits::arena(lhs, rhs));
+}
+
+template <typename L, typename R>
+  requires DynOperands<L, R>
+DynBits operator|(const L &lhs, const R &rhs) {
+  return DynBits::bitwise<BitOp::OR>(DynBits::view(lhs), DynBits::view(rhs),
+                                     dyn_bits::arena(lhs, rhs));
+}
+
+template <typename L, typename R>
+  requires DynOperands<L, R>
+DynBits operator^(const L &lhs, const R &rhs) {
+  return DynBits::bitwise<BitOp::XOR>(DynBits::view(lhs), DynBits::view(rhs),
+                                      dyn_bits::arena(lhs, rhs));
+}
+
+// equal values, the widths may differ
+template <typename L, typename R>
+  requires DynOperands<L, R>
+bool operator==(const L &lhs, const R &rhs) noexcept {
+  return DynBits::compare(DynBits::view(lhs), DynBits::view(rhs)) == Cmp::EQ;
+}
+
+} // namespace mango
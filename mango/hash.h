@@ -0,0 +1,295 @@
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+
+#include "mango/bits.h"
+#include "mango/common.h"
+#include "mango/int.h"
+#include "mango/masked_bits.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace mango {
+
+// Hashes of Bits<N>, Int and MaskedBits values:
+//
+//    std::unordered_map<Bits<256>, int> m;       // std::hash<Bits<256>>
+//    uint64_t h = hash(x, seed);
+//    hash_batch(std::span{keys}, std::span{hashes}, seed);
+//
+// One limb is a single multiply-mix: the 128-bit product of the value and a
+// constant, high half xor low half. Up to HASH_STRIPE_LIMBS limbs are mixed
+// in independent pairs like wyhash. Wider values go through an XXH3 style
+// accumulator a stripe of 8 limbs at a time in the vector unit, and the
+// accumulators are mixed like a narrow value at the end. The hash of a value
+// is the same on every target and in constant evaluation, but it is not a
+// stable format and may change between versions.
+
+// limbs per stripe of the wide mixer, wider values are accumulated
+constexpr uint16_t HASH_STRIPE_LIMBS = 8;
+
+// the fractional digits of pi, nothing up the sleeve
+constexpr std::array<uint64_t, HASH_STRIPE_LIMBS> HASH_SECRET = {
+    0x243f6a8885a308d3, 0x13198a2e03707344, 0xa4093822299f31d0,
+    0x082efa98ec4e6c89, 0x452821e638d01377, 0xbe5466cf34e90c6c,
+    0xc0ac29b7c97c50dd, 0x3f84d5b5b5470917};
+
+// odd, so the low half of a product is a bijection of the low bits (2^64 over
+// the golden ratio)
+constexpr uint64_t HASH_MULTIPLIER = 0x9e3779b97f4a7c15;
+
+// the 128-bit product of a and b folded to 64 bits (wyhash's mum)
+constexpr uint64_t hash_mum(const uint64_t a, const uint64_t b) noexcept {
+  const uint128_t p = uint128_t(a) * b;
+  return uint64_t(p) ^ uint64_t(p >> 64);
+}
+
+// For every full stripe of a[0 .. 8 n), lane j:
+//
+//    acc[j ^ 1] += a[j]
+//    acc[j] += lo32(a[j] ^ key[j]) * hi32(a[j] ^ key[j])
+//
+// then key[j] += HASH_SECRET[j + 1] so that the order of the stripes
+// matters. Same vector units as bitwise_limbs, one 32 x 32 -> 64 bit
+// multiplication per lane.
+constexpr void hash_stripes(uint64_t *acc, uint64_t *key, const uint64_t *a,
+                            const uint16_t n) noexcept {
+  uint16_t s = 0;
+  if !consteval {
+#if defined(__AVX512F__)
+    __m512i va = _mm512_loadu_si512(acc);
+    __m512i vk = _mm512_loadu_si512(key);
+    const __m512i step = _mm512_set_epi64(
+        HASH_SECRET[0], HASH_SECRET[7], HASH_SECRET[6], HASH_SECRET[5],
+        HASH_SECRET[4], HASH_SECRET[3], HASH_SECRET[2], HASH_SECRET[1]);
+    for (; s < n; s++) {
+      // the zero masked forms, GCC 12 warns about the unmasked ones
+      const __m512i d = _mm512_loadu_si512(a + s * HASH_STRIPE_LIMBS);
+      const __m512i dk = _mm512_xor_si512(d, vk);
+      const __m512i p = _mm512_maskz_mul_epu32(
+          0xff, dk, _mm512_maskz_srli_epi64(0xff, dk, 32));
+      va = _mm512_add_epi64(
+          va, _mm512_maskz_shuffle_epi32(0xffff, d, _MM_PERM_BADC));
+      va = _mm512_add_epi64(va, p);
+      vk = _mm512_add_epi64(vk, step);
+    }
+    _mm512_storeu_si512(acc, va);
+    _mm512_storeu_si512(key, vk);
+#elif defined(__AVX2__)
+    __m256i va[2], vk[2];
+    const __m256i step[2] = {
+        _mm256_set_epi64x(HASH_SECRET[4], HASH_SECRET[3], HASH_SECRET[2],
+                          HASH_SECRET[1]),
+        _mm256_set_epi64x(HASH_SECRET[0], HASH_SECRET[7], HASH_SECRET[6],
+                          HASH_SECRET[5])};
+#pragma GCC unroll 2
+    for (int h = 0; h < 2; h++) {
+      va[h] = _mm256_loadu_si256((const __m256i *)(acc + 4 * h));
+      vk[h] = _mm256_loadu_si256((const __m256i *)(key + 4 * h));
+    }
+    for (; s < n; s++) {
+#pragma GCC unroll 2
+      for (int h = 0; h < 2; h++) {
+        const __m256i d = _mm256_loadu_si256(
+            (const __m256i *)(a + s * HASH_STRIPE_LIMBS + 4 * h));
+        const __m256i dk = _mm256_xor_si256(d, vk[h]);
+        const __m256i p = _mm256_mul_epu32(dk, _mm256_srli_epi64(dk, 32));
+        va[h] = _mm256_add_epi64(va[h], _mm256_shuffle_epi32(d, 0x4e));
+        va[h] = _mm256_add_epi64(va[h], p);
+        vk[h] = _mm256_add_epi64(vk[h], step[h]);
+      }
+    }
+#pragma GCC unroll 2
+    for (int h = 0; h < 2; h++) {
+      _mm256_storeu_si256((__m256i *)(acc + 4 * h), va[h]);
+      _mm256_storeu_si256((__m256i *)(key + 4 * h), vk[h]);
+    }
+#elif defined(__SSE2__)
+    __m128i va[4], vk[4], step[4];
+#pragma GCC unroll 4
+    for (int h = 0; h < 4; h++) {
+      va[h] = _mm_loadu_si128((const __m128i *)(acc + 2 * h));
+      vk[h] = _mm_loadu_si128((const __m128i *)(key + 2 * h));
+      step[h] = _mm_set_epi64x(HASH_SECRET[(2 * h + 2) % HASH_STRIPE_LIMBS],
+                               HASH_SECRET[2 * h + 1]);
+    }
+    for (; s < n; s++) {
+#pragma GCC unroll 4
+      for (int h = 0; h < 4; h++) {
+        const __m128i d = _mm_loadu_si128(
+            (const __m128i *)(a + s * HASH_STRIPE_LIMBS + 2 * h));
+        const __m128i dk = _mm_xor_si128(d, vk[h]);
+        const __m128i p = _mm_mul_epu32(dk, _mm_srli_epi64(dk, 32));
+        va[h] = _mm_add_epi64(va[h], _mm_shuffle_epi32(d, 0x4e));
+        va[h] = _mm_add_epi64(va[h], p);
+        vk[h] = _mm_add_epi64(vk[h], step[h]);
+      }
+    }
+#pragma GCC unroll 4
+    for (int h = 0; h < 4; h++) {
+      _mm_storeu_si128((__m128i *)(acc + 2 * h), va[h]);
+      _mm_storeu_si128((__m128i *)(key + 2 * h), vk[h]);
+    }
+#elif defined(__ARM_NEON)
+    uint64x2_t va[4], vk[4], step[4];
+#pragma GCC unroll 4
+    for (int h = 0; h < 4; h++) {
+      va[h] = vld1q_u64(acc + 2 * h);
+      vk[h] = vld1q_u64(key + 2 * h);
+      step[h] = vcombine_u64(
+          vcreate_u64(HASH_SECRET[2 * h + 1]),
+          vcreate_u64(HASH_SECRET[(2 * h + 2) % HASH_STRIPE_LIMBS]));
+    }
+    for (; s < n; s++) {
+#pragma GCC unroll 4
+      for (int h = 0; h < 4; h++) {
+        const uint64x2_t d = vld1q_u64(a + s * HASH_STRIPE_LIMBS + 2 * h);
+        const uint64x2_t dk = veorq_u64(d, vk[h]);
+        va[h] = vaddq_u64(va[h], vextq_u64(d, d, 1));
+        va[h] = vmlal_u32(va[h], vmovn_u64(dk), vshrn_n_u64(dk, 32));
+        vk[h] = vaddq_u64(vk[h], step[h]);
+      }
+    }
+#pragma GCC unroll 4
+    for (int h = 0; h < 4; h++) {
+      vst1q_u64(acc + 2 * h, va[h]);
+      vst1q_u64(key + 2 * h, vk[h]);
+    }
+#endif
+  }
+  for (; s < n; s++) {
+    const uint64_t *d = a + s * HASH_STRIPE_LIMBS;
+#pragma GCC unroll 8
+    for (uint16_t j = 0; j < HASH_STRIPE_LIMBS; j++) {
+      const uint64_t dk = d[j] ^ key[j];
+      acc[j ^ 1] += d[j];
+      acc[j] += (dk & 0xffffffff) * (dk >> 32);
+      key[j] += HASH_SECRET[(j + 1) % HASH_STRIPE_LIMBS];
+    }
+  }
+}
+
+// the hash of a[0 .. L), the width is a template argument so that every
+// branch on it is resolved at compile time and the narrow cases inline
+template <uint16_t L>
+constexpr uint64_t hash_limbs(const uint64_t *a, const uint64_t seed) noexcept {
+  if constexpr (L <= 1) {
+    uint64_t v = 0;
+    if constexpr (L == 1) {
+      v = a[0];
+    }
+    return hash_mum(v ^ seed ^ HASH_SECRET[0], HASH_MULTIPLIER);
+  } else {
+    uint64_t h = seed ^ HASH_SECRET[L % HASH_STRIPE_LIMBS];
+    if constexpr (L <= HASH_STRIPE_LIMBS) {
+      // the products are independent, only the xors are serial
+#pragma GCC unroll 4
+      for (uint16_t i = 0; i + 2 <= L; i += 2) {
+        h ^= hash_mum(a[i] ^ HASH_SECRET[i],
+                      a[i + 1] ^ HASH_SECRET[i + 1] ^ seed);
+      }
+      if constexpr (L % 2 != 0) {
+        h ^= hash_mum(a[L - 1] ^ HASH_SECRET[L - 1], seed ^ HASH_SECRET[0]);
+      }
+    } else {
+      std::array<uint64_t, HASH_STRIPE_LIMBS> acc = HASH_SECRET;
+      std::array<uint64_t, HASH_STRIPE_LIMBS> key;
+      for (uint16_t j = 0; j < HASH_STRIPE_LIMBS; j++) {
+        key[j] = HASH_SECRET[j] ^ seed;
+      }
+      hash_stripes(acc.data(), key.data(), a, L / HASH_STRIPE_LIMBS);
+      if constexpr (L % HASH_STRIPE_LIMBS != 0) {
+        // the last stripe is zero padded, L is mixed in below
+        constexpr uint16_t DONE = L - L % HASH_STRIPE_LIMBS;
+        std::array<uint64_t, HASH_STRIPE_LIMBS> last{};
+        for (uint16_t j = 0; DONE + j < L; j++) {
+          last[j] = a[DONE + j];
+        }
+        hash_stripes(acc.data(), key.data(), last.data(), 1);
+      }
+#pragma GCC unroll 4
+      for (uint16_t j = 0; j < HASH_STRIPE_LIMBS; j += 2) {
+        h ^= hash_mum(acc[j] ^ key[j], acc[j + 1] ^ key[j + 1]);
+      }
+    }
+    return hash_mum(h ^ L, HASH_MULTIPLIER);
+  }
+}
+
+// equal values have equal hashes for a given width and seed
+
+template <uint16_t N>
+constexpr uint64_t hash(const Bits<N> &x, const uint64_t seed = 0) noexcept {
+  if constexpr (N == 0) {
+    return hash_limbs<0>(nullptr, seed);
+  } else {
+    return hash_limbs<Bits<N>::LIMBS>(x.limbs, seed);
+  }
+}
+
+// the biased value, the range is part of the type
+template <typename Min, typename Max>
+constexpr uint64_t hash(const Int<Min, Max> &x,
+                        const uint64_t seed = 0) noexcept {
+  return hash(x.biased_bits, seed);
+}
+
+// a fixed pattern compares as its value whatever the bits are
+template <uint16_t N, typename MaskType, typename ValueType>
+constexpr uint64_t hash(const MaskedBits<N, MaskType, ValueType> &x,
+                        const uint64_t seed = 0) noexcept {
+  if constexpr (MaskedBits<N, MaskType, ValueType>::is_fixed()) {
+    return hash(Bits<N>{to_bits(x.fixed())}, seed);
+  } else {
+    return hash(x.bits, seed);
+  }
+}
+
+// out[i] = hash(keys[i], seed), the same values as one key at a time. For
+// building a table: all the hashes are computed before the table is
+// touched, and the multiplications of consecutive keys overlap.
+template <typename T>
+void hash_batch(const std::span<T> keys, const std::span<uint64_t> out,
+                const uint64_t seed = 0) noexcept {
+  assert(out.size() >= keys.size());
+  for (size_t i = 0; i < keys.size(); i++) {
+    out[i] = hash(keys[i], seed);
+  }
+}
+
+} // namespace mango
+
+template <uint16_t N> struct std::hash<mango::Bits<N>> {
+  size_t operator()(const mango::Bits<N> &x) const noexcept {
+    return size_t(mango::hash(x));
+  }
+};
+
+template <typename Min, typename Max> struct std::hash<mango::Int<Min, Max>> {
+  size_t operator()(const mango::Int<Min, Max> &x) const noexcept {
+    return size_t(mango::hash(x));
+  }
+};
+
+template <uint64_t N> struct std::hash<mango::SignedInt<N>> {
+  size_t operator()(const mango::SignedInt<N> &x) const noexcept {
+    return size_t(mango::hash(x));
+  }
+};
+
+template <uint16_t N, typename MaskType, typename ValueType>
+struct std::hash<mango::MaskedBits<N, MaskType, ValueType>> {
+  size_t operator()(
+      const mango::MaskedBits<N, MaskType, ValueType> &x) const noexcept {
+    return size_t(mango::hash(x));
+  }
+};
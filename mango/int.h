@@ -1,20 +1,26 @@
 #pragma once
 
 #include <cassert>
+#include <compare>
 #include <cstdint>
 #include <iostream>
 #include <mango/bits.h>
+#include <mango/charconv.h>
 #include <mango/nat.h>
 #include <type_traits>
+#include <utility>
 
 namespace mango {
 
 template <typename Min, typename Max> struct Int {
+  using MinType = Min;
+  using MaxType = Max;
   constexpr static Min min{};
   constexpr static Max max{};
   static_assert(Min{} <= Max{}, "Min must be less than or equal to Max");
   constexpr static auto range = max - min + Nat<1>{};
-  constexpr static uint64_t bitsize = range.bit_size();
+  // biased values are in [0, Max - Min]
+  constexpr static uint64_t bitsize = (max - min).bit_size();
   Bits<bitsize> biased_bits; // value - Min
 
   constexpr Int() noexcept : biased_bits{0} {}
@@ -36,10 +42,481 @@ template <typename Min, typename Max> struct Int {
   template <typename Min2, typename Max2>
   constexpr const Int<decltype(Min{} + Min2{}), decltype(Max{} + Max2{})>
   operator+(const Int<Min2, Max2> &other) const noexcept {
+    static_assert(Int<decltype(Min{} + Min2{}),
+                      decltype(Max{} + Max2{})>::bitsize <=
+                  mango::max(bitsize, Int<Min2, Max2>::bitsize) + 1);
     return {biased_bits + other.biased_bits, true};
   }
+
+  // -value is in [-Max, -Min], its biased value is (Max - Min) - biased
+  constexpr auto operator-() const noexcept {
+    using Out = Int<decltype(Nat<>{} - Max{}), decltype(Nat<>{} - Min{})>;
+    static_assert(Out::bitsize == bitsize);
+    return Out{(to_bits_mod<bitsize>(Max{} - Min{}) - biased_bits)
+                   .template trim<bitsize>(),
+               true};
+  }
+
+  template <typename Min2, typename Max2>
+  constexpr auto operator-(const Int<Min2, Max2> &other) const noexcept {
+    return *this + (-other);
+  }
+
+  // adding a constant moves the range, the biased value is unchanged
+
+  template <uint64_t... Vs>
+  constexpr auto operator+(const Nat<Vs...> c) const noexcept {
+    return Int<std::remove_const_t<decltype(Min{} + c)>,
+               std::remove_const_t<decltype(Max{} + c)>>{biased_bits, true};
+  }
+
+  template <uint64_t... Vs>
+  constexpr auto operator+(const Neg<Vs...> c) const noexcept {
+    return Int<std::remove_const_t<decltype(Min{} + c)>,
+               std::remove_const_t<decltype(Max{} + c)>>{biased_bits, true};
+  }
+
+  template <uint64_t... Vs>
+  constexpr auto operator-(const Nat<Vs...> c) const noexcept {
+    return *this + (-c);
+  }
+
+  template <uint64_t... Vs>
+  constexpr auto operator-(const Neg<Vs...> c) const noexcept {
+    return *this + c.abs();
+  }
+
+  // value * c for c >= 0 is biased * c in [Min c, Max c], see Bits * Nat
+  template <uint64_t... Vs>
+  constexpr auto operator*(const Nat<Vs...> c) const noexcept {
+    using Out = Int<std::remove_const_t<decltype(Min{} * c)>,
+                    std::remove_const_t<decltype(Max{} * c)>>;
+    static_assert(Out::bitsize <= bitsize + c.bit_size());
+    return Out{Bits<Out::bitsize>{biased_bits * c}, true};
+  }
+
+  template <uint64_t... Vs>
+  constexpr auto operator*(const Neg<Vs...> c) const noexcept {
+    return -(*this * c.abs());
+  }
+
+  // value <=> c, constant when c is outside [Min, Max]
+  template <typename C> constexpr Cmp cmp_constant(const C c) const noexcept {
+    if constexpr (c.cmp(Min{}) == Cmp::LT) {
+      return Cmp::GT;
+    } else if constexpr (c.cmp(Max{}) == Cmp::GT) {
+      return Cmp::LT;
+    } else {
+      return biased_bits.cmp(c - Min{});
+    }
+  }
+
+  template <uint64_t... Vs>
+  constexpr Cmp cmp(const Nat<Vs...> c) const noexcept {
+    return cmp_constant(c);
+  }
+
+  template <uint64_t... Vs>
+  constexpr Cmp cmp(const Neg<Vs...> c) const noexcept {
+    return cmp_constant(c);
+  }
+
+  template <uint64_t... Vs>
+  constexpr bool operator==(const Nat<Vs...> c) const noexcept {
+    if constexpr (c.cmp(Min{}) == Cmp::LT || c.cmp(Max{}) == Cmp::GT) {
+      return false;
+    } else {
+      return biased_bits == c - Min{};
+    }
+  }
+
+  template <uint64_t... Vs>
+  constexpr bool operator==(const Neg<Vs...> c) const noexcept {
+    if constexpr (c.cmp(Min{}) == Cmp::LT || c.cmp(Max{}) == Cmp::GT) {
+      return false;
+    } else {
+      return biased_bits == c - Min{};
+    }
+  }
+
+  // both biased values in the frame of the lower minimum, see common_biased.
+  // The bias of SignedInt<N> is 2^(N-1) so its signed order is the unsigned
+  // order of the biased bits.
+  template <typename Min2, typename Max2>
+  constexpr Cmp cmp(const Int<Min2, Max2> &other) const noexcept {
+    if constexpr (Max{}.cmp(Min2{}) == Cmp::LT) {
+      return Cmp::LT;
+    } else if constexpr (Min{}.cmp(Max2{}) == Cmp::GT) {
+      return Cmp::GT;
+    } else {
+      const auto [x, y] = common_biased(*this, other);
+      return x.cmp(y);
+    }
+  }
+
+  template <typename Min2, typename Max2>
+  constexpr bool operator==(const Int<Min2, Max2> &other) const noexcept {
+    if constexpr (Max{}.cmp(Min2{}) == Cmp::LT ||
+                  Min{}.cmp(Max2{}) == Cmp::GT) {
+      return false;
+    } else {
+      const auto [x, y] = common_biased(*this, other);
+      return x == y;
+    }
+  }
+
+  // value order, with Int, Nat and Neg
+  template <typename Rhs>
+    requires requires(const Int &a, const Rhs &b) { a.cmp(b); }
+  constexpr std::strong_ordering operator<=>(const Rhs &rhs) const noexcept {
+    return int(cmp(rhs)) <=> 0;
+  }
+
+  // value * 2^S, the biased value is shifted along
+  template <uint64_t... Ss>
+  constexpr auto operator<<(const Nat<Ss...> s) const noexcept {
+    static_assert(s.bit_size() <= 16, "shift amount is too large");
+    constexpr uint16_t S = s.get(0);
+    constexpr auto p = Nat<1>{} << s;
+    using Out = Int<decltype(Min{} * p), decltype(Max{} * p)>;
+    static_assert(Out::bitsize <= bitsize + S);
+    return Out{biased_bits.template shl<S>(), true};
+  }
+
+  // floor(value / 2^S) like >> on the built-in signed types. With
+  // Min = m * 2^S + r and 0 <= r < 2^S the biased result is
+  // (biased + r) >> S.
+  template <uint64_t... Ss>
+  constexpr auto operator>>(const Nat<Ss...> s) const noexcept {
+    static_assert(s.bit_size() <= 16, "shift amount is too large");
+    constexpr uint16_t S = s.get(0);
+    constexpr auto p = Nat<1>{} << s;
+    using Out =
+        Int<decltype(floor_div(Min{}, p)), decltype(floor_div(Max{}, p))>;
+    const auto shifted =
+        (biased_bits + to_bits_mod<S>(Min{})).template shr<S>();
+    static_assert(Out::bitsize <= decltype(shifted)::WIDTH);
+    return Out{Bits<Out::bitsize>{shifted}, true};
+  }
+
+  // Bitwise operators on non-negative ranges: a & b is at most min(Max, Max2),
+  // a | b is at least max(Min, Min2) and at most Max + Max2 and the all ones
+  // value of the wider operand.
+
+  template <typename Min2, typename Max2>
+  constexpr auto operator&(const Int<Min2, Max2> &other) const noexcept {
+    static_assert(Min{}.cmp(Nat<>{}) != Cmp::LT &&
+                      Min2{}.cmp(Nat<>{}) != Cmp::LT,
+                  "bitwise operators need non-negative ranges");
+    using Out = Int<Nat<>, decltype(min_value(Max{}, Max2{}))>;
+    const auto v = sign_magnitude().first & other.sign_magnitude().first;
+    static_assert(Out::bitsize <= decltype(v)::WIDTH);
+    return Out{Bits<Out::bitsize>{v}, true};
+  }
+
+  template <typename Min2, typename Max2>
+  constexpr auto operator|(const Int<Min2, Max2> &other) const noexcept {
+    static_assert(Min{}.cmp(Nat<>{}) != Cmp::LT &&
+                      Min2{}.cmp(Nat<>{}) != Cmp::LT,
+                  "bitwise operators need non-negative ranges");
+    constexpr auto ones =
+        (Nat<1>{} << Nat<mango::max(Max{}.bit_size(), Max2{}.bit_size())>{}) -
+        Nat<1>{};
+    using Lo = decltype(max_value(Min{}, Min2{}));
+    using Out = Int<Lo, decltype(min_value(Max{} + Max2{}, ones))>;
+    constexpr uint16_t K = Out::bitsize;
+    const auto v = sign_magnitude().first | other.sign_magnitude().first;
+    static_assert(K <= decltype(v)::WIDTH);
+    return Out{(Bits<K>{v} + to_bits_mod<K>(-Lo{})).template trim<K>(), true};
+  }
+
+  // |value|, in [0, max(|Min|, |Max|)] when the range straddles zero
+  constexpr auto abs() const noexcept {
+    if constexpr (Min{}.cmp(Nat<>{}) != Cmp::LT) {
+      return *this;
+    } else if constexpr (Max{}.cmp(Nat<>{}) != Cmp::GT) {
+      return -*this;
+    } else {
+      using Out = Int<Nat<>, decltype(max_value(Min{}.abs(), Max{}.abs()))>;
+      const auto m = sign_magnitude().first;
+      static_assert(Out::bitsize <= decltype(m)::WIDTH);
+      return Out{Bits<Out::bitsize>{m}, true};
+    }
+  }
+
+  // exact product range: the extremes are among the four corner products
+  template <typename Min2, typename Max2>
+  constexpr auto operator*(const Int<Min2, Max2> &other) const noexcept {
+    constexpr auto lo =
+        min_value(min_value(Min{} * Min2{}, Min{} * Max2{}),
+                  min_value(Max{} * Min2{}, Max{} * Max2{}));
+    constexpr auto hi =
+        max_value(max_value(Min{} * Min2{}, Min{} * Max2{}),
+                  max_value(Max{} * Min2{}, Max{} * Max2{}));
+    using Out = Int<std::remove_const_t<decltype(lo)>,
+                    std::remove_const_t<decltype(hi)>>;
+    constexpr uint16_t K = Out::bitsize;
+
+    if constexpr (Min{}.is_zero() && Min2{}.is_zero()) {
+      return Out{(biased_bits * other.biased_bits).template trim<K>(), true};
+    } else {
+      // the biased result fits in K bits so the whole computation can be
+      // done modulo 2^K: (a + Min)(b + Min2) - lo
+      constexpr auto min1 = to_bits_mod<K>(Min{});
+      constexpr auto min2 = to_bits_mod<K>(Min2{});
+      constexpr auto bias = to_bits_mod<K>(-lo);
+      const auto a = (Bits<K>{biased_bits} + min1).template trim<K>();
+      const auto b = (Bits<K>{other.biased_bits} + min2).template trim<K>();
+      return Out{((a * b).template trim<K>() + bias).template trim<K>(), true};
+    }
+  }
+
+  // |value| in the fewest bits and whether the value is negative
+  constexpr auto sign_magnitude() const noexcept {
+    if constexpr (Min{}.cmp(Nat<>{}) != Cmp::LT) {
+      constexpr uint16_t W = Max{}.bit_size();
+      return std::pair{(Bits<W>{biased_bits} + to_bits_mod<W>(min))
+                           .template trim<W>(),
+                       false};
+    } else {
+      constexpr uint16_t W =
+          mango::max(Min{}.abs().bit_size(), Max{}.abs().bit_size());
+      // two's complement value in W + 1 bits
+      const auto v =
+          (Bits<W + 1>{biased_bits} + to_bits_mod<W + 1>(min)).template trim<
+              W + 1>();
+      const bool negative = v.is_signed();
+      const Bits<W> magnitude =
+          negative ? Bits<W>{Bits<W + 1>{} - v} : Bits<W>{v};
+      return std::pair{magnitude, negative};
+    }
+  }
+
+  // biased bits of an Int<Lo, ...> with the value (negative ? -m : m)
+  template <uint16_t K, typename Lo, uint16_t M>
+  constexpr static Bits<K> rebias(const Bits<M> &magnitude,
+                                  const bool negative) noexcept {
+    const Bits<K> m{magnitude};
+    const Bits<K> v = negative ? Bits<K>{Bits<K>{} - m} : m;
+    return (v + to_bits_mod<K>(-Lo{})).template trim<K>();
+  }
+
+  // Branch on value < c once and hand each side the narrowed value:
+  // below(Int<Min, c - 1>) or above(Int<c, Max>). Both must return the same
+  // type. A side that cannot happen is not called (nor instantiated).
+  template <typename C, typename Below, typename Above>
+  constexpr auto refine_lt(const C c, Below &&below,
+                           Above &&above) const noexcept {
+    if constexpr (c.cmp(Min{}) != Cmp::GT) {
+      return above(*this);
+    } else if constexpr (c.cmp(Max{}) == Cmp::GT) {
+      return below(*this);
+    } else {
+      using Lo = Int<Min, decltype(c - Nat<1>{})>;
+      using Hi = Int<C, Max>;
+      constexpr auto k = to_bits_mod<bitsize>(c - Min{});
+      if (biased_bits.cmp(k) == Cmp::LT) {
+        return below(Lo{Bits<Lo::bitsize>{biased_bits}, true});
+      } else {
+        return above(Hi{
+            Bits<Hi::bitsize>{(biased_bits - k).template trim<bitsize>()},
+            true});
+      }
+    }
+  }
+
+  // a < b as the borrow out of a - b, no branches unlike cmp. Both sides are
+  // unsigned: Bits - Bits would sign extend them, so the subtraction wraps
+  // one bit above the values instead
+  constexpr static bool borrows(const Bits<bitsize> &a,
+                                const Bits<bitsize> &b) noexcept {
+    return a.template zero_extend<bitsize + 1>()
+        .sub_wrap(b.template zero_extend<bitsize + 1>())
+        .is_signed();
+  }
+
+  // min(max(value, NewMin), NewMax) in the range
+  // [clamp(Min), clamp(Max)], the comparisons are on the biased value so
+  // narrow ranges compile to cmov
+  template <typename NewMin, typename NewMax>
+  constexpr auto clamp() const noexcept {
+    static_assert(NewMin{}.cmp(NewMax{}) != Cmp::GT,
+                  "NewMin must be at most NewMax");
+    using Lo = decltype(min_value(max_value(Min{}, NewMin{}), NewMax{}));
+    using Hi = decltype(max_value(min_value(Max{}, NewMax{}), NewMin{}));
+    using Out = Int<Lo, Hi>;
+    if constexpr (Lo{}.cmp(Hi{}) == Cmp::EQ) {
+      // no overlap (or a single value), the result is a constant
+      return Out{};
+    } else {
+      // here Min <= Lo <= Hi <= Max
+      auto r = biased_bits;
+      if constexpr (NewMin{}.cmp(Min{}) == Cmp::GT) {
+        constexpr auto low = to_bits_mod<bitsize>(NewMin{} - Min{});
+        r = borrows(r, low) ? low : r;
+      }
+      if constexpr (NewMax{}.cmp(Max{}) == Cmp::LT) {
+        constexpr auto high = to_bits_mod<bitsize>(NewMax{} - Min{});
+        r = borrows(high, r) ? high : r;
+      }
+      const auto v = (r + to_bits_mod<bitsize>(Min{} - Lo{}))
+                         .template trim<bitsize>();
+      static_assert(Out::bitsize <= bitsize);
+      return Out{Bits<Out::bitsize>{v}, true};
+    }
+  }
+
+  // saturating narrowing to N bits: the value clamped to [0, 2^N - 1]
+  template <uint16_t N> constexpr Bits<N> saturate() const noexcept {
+    using Top = decltype((Nat<1>{} << Nat<N>{}) - Nat<1>{});
+    return Bits<N>{clamp<Nat<>, Top>().sign_magnitude().first};
+  }
+
+  // saturating narrowing to N bits two's complement: the value clamped to
+  // [-2^(N-1), 2^(N-1) - 1]
+  template <uint16_t N>
+    requires(N > 0)
+  constexpr Bits<N> saturate_signed() const noexcept {
+    using Half = decltype(Nat<1>{} << Nat<N - 1>{});
+    const auto c = clamp<decltype(-Half{}), decltype(Half{} - Nat<1>{})>();
+    using C = decltype(c);
+    return (Bits<N>{c.biased_bits} + to_bits_mod<N>(typename C::MinType{}))
+        .template trim<N>();
+  }
+
+  // truncating division, the divisor range must be positive
+  template <typename Min2, typename Max2>
+  constexpr auto divmod(const Int<Min2, Max2> &other) const noexcept {
+    static_assert(Min2{}.cmp(Nat<>{}) == Cmp::GT,
+                  "the divisor range must be positive");
+    constexpr bool nonneg_lo = Min{}.cmp(Nat<>{}) != Cmp::LT;
+    constexpr bool nonneg_hi = Max{}.cmp(Nat<>{}) != Cmp::LT;
+
+    constexpr auto q_lo = [] {
+      if constexpr (nonneg_lo) {
+        return Min{} / Max2{};
+      } else {
+        return Min{} / Min2{};
+      }
+    }();
+    constexpr auto q_hi = [] {
+      if constexpr (nonneg_hi) {
+        return Max{} / Min2{};
+      } else {
+        return Max{} / Max2{};
+      }
+    }();
+    constexpr auto r_lo = [] {
+      if constexpr (nonneg_lo) {
+        return Nat<>{};
+      } else {
+        return max_value(Min{}, -(Max2{} - Nat<1>{}));
+      }
+    }();
+    constexpr auto r_hi = [] {
+      if constexpr (nonneg_hi) {
+        return min_value(Max{}, Max2{} - Nat<1>{});
+      } else {
+        return Nat<>{};
+      }
+    }();
+    using Q = Int<std::remove_const_t<decltype(q_lo)>,
+                  std::remove_const_t<decltype(q_hi)>>;
+    using R = Int<std::remove_const_t<decltype(r_lo)>,
+                  std::remove_const_t<decltype(r_hi)>>;
+
+    const auto [magnitude, negative] = sign_magnitude();
+    const auto [q, r] = magnitude.divmod(other.sign_magnitude().first);
+    return std::pair{
+        Q{rebias<Q::bitsize, typename Q::MinType>(q, negative), true},
+        R{rebias<R::bitsize, typename R::MinType>(r, negative), true}};
+  }
+
+  template <typename Min2, typename Max2>
+  constexpr auto operator/(const Int<Min2, Max2> &other) const noexcept {
+    return divmod(other).first;
+  }
+
+  template <typename Min2, typename Max2>
+  constexpr auto operator%(const Int<Min2, Max2> &other) const noexcept {
+    return divmod(other).second;
+  }
+
+  // division by a positive constant goes through Bits / Nat
+  template <uint64_t... Ds>
+  constexpr auto operator/(const Nat<Ds...> d) const noexcept {
+    using Q = Int<std::remove_const_t<decltype(Min{} / d)>,
+                  std::remove_const_t<decltype(Max{} / d)>>;
+    const auto [magnitude, negative] = sign_magnitude();
+    return Q{rebias<Q::bitsize, typename Q::MinType>(magnitude / d, negative),
+             true};
+  }
+
+  template <uint64_t... Ds>
+  constexpr auto operator%(const Nat<Ds...> d) const noexcept {
+    constexpr auto r_lo = [] {
+      if constexpr (Min{}.cmp(Nat<>{}) != Cmp::LT) {
+        return Nat<>{};
+      } else {
+        return max_value(Min{}, -(Nat<Ds...>{} - Nat<1>{}));
+      }
+    }();
+    constexpr auto r_hi = [] {
+      if constexpr (Max{}.cmp(Nat<>{}) != Cmp::LT) {
+        return min_value(Max{}, Nat<Ds...>{} - Nat<1>{});
+      } else {
+        return Nat<>{};
+      }
+    }();
+    using R = Int<std::remove_const_t<decltype(r_lo)>,
+                  std::remove_const_t<decltype(r_hi)>>;
+    const auto [magnitude, negative] = sign_magnitude();
+    return R{rebias<R::bitsize, typename R::MinType>(magnitude % d, negative),
+             true};
+  }
 };
 
+///////////////// min / max /////////////////////
+
+// Both values are compared in the frame of the lower minimum
+// Lo = min(Min1, Min2), where they are unsigned and W bits wide.
+template <typename Min1, typename Max1, typename Min2, typename Max2>
+constexpr auto common_biased(const Int<Min1, Max1> &a,
+                             const Int<Min2, Max2> &b) noexcept {
+  using Lo = decltype(min_value(Min1{}, Min2{}));
+  constexpr uint16_t W = (max_value(Max1{}, Max2{}) - Lo{}).bit_size();
+  return std::pair{
+      (Bits<W>{a.biased_bits} + to_bits_mod<W>(Min1{} - Lo{}))
+          .template trim<W>(),
+      (Bits<W>{b.biased_bits} + to_bits_mod<W>(Min2{} - Lo{}))
+          .template trim<W>()};
+}
+
+template <typename Min1, typename Max1, typename Min2, typename Max2>
+constexpr auto min(const Int<Min1, Max1> &a,
+                   const Int<Min2, Max2> &b) noexcept {
+  using Out = Int<decltype(min_value(Min1{}, Min2{})),
+                  decltype(min_value(Max1{}, Max2{}))>;
+  const auto [x, y] = common_biased(a, b);
+  // Out has the same minimum, the smaller value fits in Out::bitsize
+  static_assert(Out::bitsize <= decltype(x)::WIDTH);
+  return Out{Bits<Out::bitsize>{(x.cmp(y) == Cmp::LT) ? x : y}, true};
+}
+
+template <typename Min1, typename Max1, typename Min2, typename Max2>
+constexpr auto max(const Int<Min1, Max1> &a,
+                   const Int<Min2, Max2> &b) noexcept {
+  using Lo = decltype(min_value(Min1{}, Min2{}));
+  using Hi = decltype(max_value(Min1{}, Min2{}));
+  using Out = Int<Hi, decltype(max_value(Max1{}, Max2{}))>;
+  constexpr uint16_t W = (Out::max - Lo{}).bit_size();
+  const auto [x, y] = common_biased(a, b);
+  static_assert(Out::bitsize <= W);
+  // move from the Lo frame to the Hi frame, Lo - Hi <= 0
+  const auto r = ((x.cmp(y) == Cmp::LT) ? y : x) + to_bits_mod<W>(Lo{} - Hi{});
+  return Out{Bits<Out::bitsize>{r.template trim<W>()}, true};
+}
+
 ///////////////// UnsignedInt /////////////////////
 
 template <uint16_t N>
@@ -60,14 +537,66 @@ template <> struct SignedInt<0> : Int<Nat<>, Nat<>> {
       : Int<Nat<>, Nat<>>(bv, h) {}
 };
 
+// like std::to_chars for a signed integer, base 2 .. 36
 template <typename Min, typename Max>
-std::ostream &operator<<(std::ostream &os, const Int<Min, Max> &value) {
-  os << "Int<" << value.min << ", " << value.max << "> = ";
-  for (uint64_t i = 0; i < value.LEN; ++i) {
-    os << value.get(value.LEN - i);
+std::to_chars_result to_chars(char *first, char *last,
+                              const Int<Min, Max> &value,
+                              const int base = 10) noexcept {
+  const auto [magnitude, negative] = value.sign_magnitude();
+  if (negative) {
+    if (first == last) {
+      return {last, std::errc::value_too_large};
+    }
+    *first++ = '-';
   }
+  return to_chars(first, last, magnitude, base);
+}
 
-  return os;
+// like std::from_chars for a signed integer, values outside [Min, Max] are
+// result_out_of_range and leave value unchanged
+template <typename Min, typename Max>
+std::from_chars_result from_chars(const char *first, const char *last,
+                                  Int<Min, Max> &value,
+                                  const int base = 10) noexcept {
+  // |Min| and |Max| fit in W bits, value - Min in W + 2 bit two's complement
+  constexpr uint16_t W =
+      mango::max(Min{}.abs().bit_size(), Max{}.abs().bit_size());
+  using Magnitude = Bits<W>;
+  typename Magnitude::Limbs limbs;
+  bool negative;
+  const auto r = signed_limbs_from_chars<Magnitude::LIMBS>(
+      first, last, limbs.data(), negative, base);
+  if (r.ec != std::errc{}) {
+    return r;
+  }
+  if constexpr (W > 0) {
+    if ((limbs[Magnitude::LIMBS - 1] & ~Magnitude::TOP_MASK) != 0) {
+      return {r.ptr, std::errc::result_out_of_range};
+    }
+  } else {
+    negative = false;
+  }
+  const auto biased = Int<Min, Max>::template rebias<W + 2, Min>(
+      Magnitude{limbs}, negative);
+  if (biased.is_signed() ||
+      biased.cmp(to_bits(Max{} - Min{})) == Cmp::GT) {
+    return {r.ptr, std::errc::result_out_of_range};
+  }
+  value = Int<Min, Max>{Bits<Int<Min, Max>::bitsize>{biased}, true};
+  return r;
+}
+
+// the signed value in the stream's base
+template <typename Min, typename Max>
+std::ostream &operator<<(std::ostream &os, const Int<Min, Max> &value) {
+  const auto [magnitude, negative] = value.sign_magnitude();
+  using Magnitude = std::remove_const_t<decltype(magnitude)>;
+  typename Magnitude::Limbs limbs;
+  for (uint16_t i = 0; i < Magnitude::LIMBS; i++) {
+    limbs[i] = magnitude.get(i);
+  }
+  return print_limbs<Magnitude::LIMBS, Magnitude::WIDTH>(os, limbs.data(),
+                                                        negative);
 }
 
 template <uint64_t... Vs>
@@ -83,6 +612,25 @@ template <uint16_t N> constexpr SignedInt<N> SInt(const Bits<N> &b) noexcept {
   return {b.template flip_bit<N - 1>(), true};
 }
 
+// bit counts of a Bits<N> are in [0, N]
+template <uint16_t N>
+using BitCount = Int<Nat<>, std::conditional_t<N == 0, Nat<>, Nat<N>>>;
+
+template <uint16_t N>
+constexpr BitCount<N> popcount(const Bits<N> &b) noexcept {
+  return {Bits<BitCount<N>::bitsize>{b.count_ones()}, true};
+}
+
+template <uint16_t N>
+constexpr BitCount<N> countl_zero(const Bits<N> &b) noexcept {
+  return {Bits<BitCount<N>::bitsize>{b.leading_zeros()}, true};
+}
+
+template <uint16_t N>
+constexpr BitCount<N> countr_zero(const Bits<N> &b) noexcept {
+  return {Bits<BitCount<N>::bitsize>{b.trailing_zeros()}, true};
+}
+
 } // namespace mango
 
 template <typename T, typename MIN, typename MAX>
@@ -91,3 +639,21 @@ constexpr auto operator-(const T lhs,
                          const mango::Int<MIN, MAX> &rhs) noexcept {
   return -(rhs - lhs);
 }
+
+#ifdef __cpp_lib_format
+
+template <typename Min, typename Max>
+struct std::formatter<mango::Int<Min, Max>> : mango::DigitsFormatter {
+  auto format(const mango::Int<Min, Max> &value, auto &ctx) const {
+    const auto [magnitude, negative] = value.sign_magnitude();
+    using Magnitude = std::remove_const_t<decltype(magnitude)>;
+    typename Magnitude::Limbs limbs;
+    for (uint16_t i = 0; i < Magnitude::LIMBS; i++) {
+      limbs[i] = magnitude.get(i);
+    }
+    return format_limbs<Magnitude::LIMBS, Magnitude::WIDTH>(limbs.data(),
+                                                           negative, ctx);
+  }
+};
+
+#endif
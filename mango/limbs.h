@@ -0,0 +1,677 @@
+#pragma once
+
+// Kernels over little endian arrays of 64-bit limbs. Sizes are template
+// parameters so every loop has a compile-time trip count. They are shared by
+// the compile-time (Nat) and runtime (Bits) representations. Most of them
+// forward to a version that takes the sizes as arguments, which DynBits uses
+// directly.
+
+#include <array>
+#include <bit>
+#include <cstdint>
+
+#include "common.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace mango {
+
+// operands with at least this many limbs are multiplied with Karatsuba
+constexpr uint16_t KARATSUBA_LIMBS = 32;
+
+// a * b + c + d, the result always fits in 128 bits
+constexpr uint64_t mul_add(const uint64_t a, const uint64_t b,
+                           const uint64_t c, const uint64_t d,
+                           uint64_t &high) noexcept {
+  const uint128_t t = uint128_t(a) * b + c + d;
+  high = uint64_t(t >> 64);
+  return uint64_t(t);
+}
+
+// out[0 .. l) += a[0 .. la), returns the carry out of the top limb
+constexpr uint64_t add_limbs(uint64_t *out, const uint64_t *a,
+                             const uint16_t l, const uint16_t la) noexcept {
+  uint64_t carry = 0;
+  for (uint16_t i = 0; i < l; i++) {
+    out[i] = addc(out[i], (i < la) ? a[i] : 0, carry, carry);
+  }
+  return carry;
+}
+
+template <uint16_t L, uint16_t LA>
+constexpr uint64_t add_limbs(uint64_t *out, const uint64_t *a) noexcept {
+  return add_limbs(out, a, L, LA);
+}
+
+// out[0 .. l) -= a[0 .. la), returns the borrow out of the top limb
+constexpr uint64_t sub_limbs(uint64_t *out, const uint64_t *a,
+                             const uint16_t l, const uint16_t la) noexcept {
+  uint64_t borrow = 0;
+  for (uint16_t i = 0; i < l; i++) {
+    out[i] = subb(out[i], (i < la) ? a[i] : 0, borrow, borrow);
+  }
+  return borrow;
+}
+
+template <uint16_t L, uint16_t LA>
+constexpr uint64_t sub_limbs(uint64_t *out, const uint64_t *a) noexcept {
+  return sub_limbs(out, a, L, LA);
+}
+
+template <uint16_t LA, uint16_t LB>
+constexpr void mul_limbs(const uint64_t *a, const uint64_t *b,
+                         uint64_t *out) noexcept;
+
+// out[0 .. la + lb) = a[0 .. la) * b[0 .. lb)
+constexpr void mul_schoolbook(const uint64_t *a, const uint16_t la,
+                              const uint64_t *b, const uint16_t lb,
+                              uint64_t *out) noexcept {
+  for (uint16_t i = 0; i < la + lb; i++) {
+    out[i] = 0;
+  }
+  for (uint16_t i = 0; i < la; i++) {
+    uint64_t carry = 0;
+    for (uint16_t j = 0; j < lb; j++) {
+      out[i + j] = mul_add(a[i], b[j], out[i + j], carry, carry);
+    }
+    out[i + lb] = carry;
+  }
+}
+
+template <uint16_t LA, uint16_t LB>
+constexpr void mul_schoolbook(const uint64_t *a, const uint64_t *b,
+                              uint64_t *out) noexcept {
+  mul_schoolbook(a, LA, b, LB, out);
+}
+
+// out[0 .. l) = a[0 .. la) * b[0 .. lb) mod 2^(64 l), the limbs of the
+// product at and above l are never computed
+constexpr void mul_low_limbs(const uint64_t *a, const uint16_t la,
+                             const uint64_t *b, const uint16_t lb,
+                             uint64_t *out, const uint16_t l) noexcept {
+  for (uint16_t i = 0; i < l; i++) {
+    out[i] = 0;
+  }
+  for (uint16_t i = 0; (i < la) && (i < l); i++) {
+    uint64_t carry = 0;
+    const uint16_t end = min(lb, uint16_t(l - i));
+    for (uint16_t j = 0; j < end; j++) {
+      out[i + j] = mul_add(a[i], b[j], out[i + j], carry, carry);
+    }
+    if (i + lb < l) {
+      out[i + lb] = carry;
+    }
+  }
+}
+
+template <uint16_t L, uint16_t LA, uint16_t LB>
+constexpr void mul_low_limbs(const uint64_t *a, const uint64_t *b,
+                             uint64_t *out) noexcept {
+  mul_low_limbs(a, LA, b, LB, out, L);
+}
+
+// out[0 .. LA + LB - T) = the sum of a[i] b[j] 2^(64 (i + j - T)) over
+// i + j >= T. The partial products below limb T are never computed, so the
+// result is below a * b / 2^(64 T) by less than 2 T 2^64: the carries out of
+// the dropped columns are lost.
+template <uint16_t LA, uint16_t LB, uint16_t T>
+constexpr void mul_high_limbs(const uint64_t *a, const uint64_t *b,
+                              uint64_t *out) noexcept {
+  for (uint16_t i = 0; i < LA + LB - T; i++) {
+    out[i] = 0;
+  }
+#pragma GCC unroll 16
+  for (uint16_t i = 0; i < LA; i++) {
+    if (i + LB > T) {
+      uint64_t carry = 0;
+#pragma GCC unroll 16
+      for (uint16_t j = (i < T) ? T - i : 0; j < LB; j++) {
+        out[i + j - T] = mul_add(a[i], b[j], out[i + j - T], carry, carry);
+      }
+      out[i + LB - T] = carry;
+    }
+  }
+}
+
+// out[0 .. 2L) = a[0 .. L) * b[0 .. L)
+//
+// a * b = z2 B^2H + (z1 - z0 - z2) B^H + z0 where B = 2^64, a = a1 B^H + a0,
+// b = b1 B^H + b0, z0 = a0 b0, z2 = a1 b1 and z1 = (a0 + a1)(b0 + b1)
+template <uint16_t L>
+constexpr void mul_karatsuba(const uint64_t *a, const uint64_t *b,
+                             uint64_t *out) noexcept {
+  constexpr uint16_t H = L / 2;
+  constexpr uint16_t T = L - H;
+
+  std::array<uint64_t, T + 1> sa{};
+  std::array<uint64_t, T + 1> sb{};
+  for (uint16_t i = 0; i < T; i++) {
+    sa[i] = a[H + i];
+    sb[i] = b[H + i];
+  }
+  sa[T] = add_limbs<T, H>(sa.data(), a);
+  sb[T] = add_limbs<T, H>(sb.data(), b);
+
+  std::array<uint64_t, 2 * T + 2> z1{};
+  mul_limbs<T + 1, T + 1>(sa.data(), sb.data(), z1.data());
+
+  // z0 and z2 land directly in their final position
+  mul_limbs<H, H>(a, b, out);
+  mul_limbs<T, T>(a + H, b + H, out + 2 * H);
+
+  sub_limbs<2 * T + 2, 2 * H>(z1.data(), out);
+  sub_limbs<2 * T + 2, 2 * T>(z1.data(), out + 2 * H);
+
+  // z1 - z0 - z2 = a0 b1 + a1 b0 < B^(H + T + 1)
+  add_limbs<2 * L - H, H + T + 1>(out + H, z1.data());
+}
+
+// out[J .. LS + LL) += s[0 .. LS) * l[J .. LL), one LS-limb block of l at a
+// time. out[J + LS ..) is still zero and the partial product
+// s * l[0 .. J + B) fits in J + LS + B limbs, so there is no carry past the
+// block.
+template <uint16_t LS, uint16_t LL, uint16_t J>
+constexpr void mul_blocks(const uint64_t *s, const uint64_t *l,
+                          uint64_t *out) noexcept {
+  constexpr uint16_t B = min(LS, uint16_t(LL - J));
+  std::array<uint64_t, LS + B> block{};
+  mul_limbs<B, LS>(l + J, s, block.data());
+  add_limbs<LS + B, LS + B>(out + J, block.data());
+  if constexpr (J + B < LL) {
+    mul_blocks<LS, LL, J + B>(s, l, out);
+  }
+}
+
+template <uint16_t LA, uint16_t LB>
+constexpr void mul_limbs(const uint64_t *a, const uint64_t *b,
+                         uint64_t *out) noexcept {
+  if constexpr ((LA == 0) || (LB == 0)) {
+    for (uint16_t i = 0; i < LA + LB; i++) {
+      out[i] = 0;
+    }
+  } else if constexpr ((LA < KARATSUBA_LIMBS) || (LB < KARATSUBA_LIMBS)) {
+    mul_schoolbook<LA, LB>(a, b, out);
+  } else if constexpr (LA == LB) {
+    mul_karatsuba<LA>(a, b, out);
+  } else if constexpr (max(LA, LB) >= 2 * min(LA, LB)) {
+    // the longer operand is cut into blocks as long as the shorter one, so
+    // the products are balanced instead of padded to the longer size
+    for (uint16_t i = 0; i < LA + LB; i++) {
+      out[i] = 0;
+    }
+    if constexpr (LA < LB) {
+      mul_blocks<LA, LB, 0>(a, b, out);
+    } else {
+      mul_blocks<LB, LA, 0>(b, a, out);
+    }
+  } else {
+    // nearly balanced, zero pad the shorter operand
+    constexpr uint16_t L = max(LA, LB);
+    std::array<uint64_t, L> pa{};
+    std::array<uint64_t, L> pb{};
+    for (uint16_t i = 0; i < LA; i++) {
+      pa[i] = a[i];
+    }
+    for (uint16_t i = 0; i < LB; i++) {
+      pb[i] = b[i];
+    }
+    std::array<uint64_t, 2 * L> product{};
+    mul_karatsuba<L>(pa.data(), pb.data(), product.data());
+    for (uint16_t i = 0; i < LA + LB; i++) {
+      out[i] = product[i];
+    }
+  }
+}
+
+/////////////// bitwise ///////////////
+
+// values at least this wide use the vector kernels for bitwise operations
+constexpr uint16_t SIMD_BITWISE_BITS = 256;
+
+enum struct BitOp { AND, OR, XOR, ANDNOT };
+
+// ANDNOT is a & ~b
+template <BitOp Op>
+constexpr uint64_t bit_op(const uint64_t a, const uint64_t b) noexcept {
+  if constexpr (Op == BitOp::AND) {
+    return a & b;
+  } else if constexpr (Op == BitOp::OR) {
+    return a | b;
+  } else if constexpr (Op == BitOp::XOR) {
+    return a ^ b;
+  } else {
+    return a & ~b;
+  }
+}
+
+// out[i] = a[i] Op b[i] for i < l
+//
+// Wide values go through the widest vector unit the target was compiled for
+// (AVX-512, AVX2, SSE2 or NEON), the scalar loop handles the tail and
+// constant evaluation.
+template <BitOp Op>
+constexpr void bitwise_limbs(uint64_t *out, const uint64_t *a,
+                             const uint64_t *b, const uint16_t l) noexcept {
+  uint16_t i = 0;
+  if !consteval {
+    if (l * 64 >= SIMD_BITWISE_BITS) {
+#if defined(__AVX512F__)
+#pragma GCC unroll 128
+      for (; i + 8 <= l; i += 8) {
+        const __m512i x = _mm512_loadu_si512(a + i);
+        const __m512i y = _mm512_loadu_si512(b + i);
+        __m512i z;
+        if constexpr (Op == BitOp::AND) {
+          z = _mm512_and_si512(x, y);
+        } else if constexpr (Op == BitOp::OR) {
+          z = _mm512_or_si512(x, y);
+        } else if constexpr (Op == BitOp::XOR) {
+          z = _mm512_xor_si512(x, y);
+        } else {
+          // x & ~y as a truth table (x = 0xf0, y = 0xcc), GCC 12 warns
+          // about _mm512_andnot_si512
+          z = _mm512_ternarylogic_epi64(x, y, y, 0x30);
+        }
+        _mm512_storeu_si512(out + i, z);
+      }
+#endif
+#if defined(__AVX2__)
+#pragma GCC unroll 128
+      for (; i + 4 <= l; i += 4) {
+        const __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+        const __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+        __m256i z;
+        if constexpr (Op == BitOp::AND) {
+          z = _mm256_and_si256(x, y);
+        } else if constexpr (Op == BitOp::OR) {
+          z = _mm256_or_si256(x, y);
+        } else if constexpr (Op == BitOp::XOR) {
+          z = _mm256_xor_si256(x, y);
+        } else {
+          z = _mm256_andnot_si256(y, x);
+        }
+        _mm256_storeu_si256((__m256i *)(out + i), z);
+      }
+#endif
+#if defined(__SSE2__)
+#pragma GCC unroll 128
+      for (; i + 2 <= l; i += 2) {
+        const __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+        const __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+        __m128i z;
+        if constexpr (Op == BitOp::AND) {
+          z = _mm_and_si128(x, y);
+        } else if constexpr (Op == BitOp::OR) {
+          z = _mm_or_si128(x, y);
+        } else if constexpr (Op == BitOp::XOR) {
+          z = _mm_xor_si128(x, y);
+        } else {
+          z = _mm_andnot_si128(y, x);
+        }
+        _mm_storeu_si128((__m128i *)(out + i), z);
+      }
+#elif defined(__ARM_NEON)
+#pragma GCC unroll 128
+      for (; i + 2 <= l; i += 2) {
+        const uint64x2_t x = vld1q_u64(a + i);
+        const uint64x2_t y = vld1q_u64(b + i);
+        uint64x2_t z;
+        if constexpr (Op == BitOp::AND) {
+          z = vandq_u64(x, y);
+        } else if constexpr (Op == BitOp::OR) {
+          z = vorrq_u64(x, y);
+        } else if constexpr (Op == BitOp::XOR) {
+          z = veorq_u64(x, y);
+        } else {
+          z = vbicq_u64(x, y);
+        }
+        vst1q_u64(out + i, z);
+      }
+#endif
+    }
+  }
+  for (; i < l; i++) {
+    out[i] = bit_op<Op>(a[i], b[i]);
+  }
+}
+
+template <BitOp Op, uint16_t L>
+constexpr void bitwise_limbs(uint64_t *out, const uint64_t *a,
+                             const uint64_t *b) noexcept {
+  bitwise_limbs<Op>(out, a, b, L);
+}
+
+// a[i] == b[i] for all i < l
+//
+// The differences are or-ed into one vector that is tested once at the end,
+// there is no branch per limb. Same vector units and threshold as
+// bitwise_limbs.
+constexpr bool equal_limbs(const uint64_t *a, const uint64_t *b,
+                           const uint16_t l) noexcept {
+  uint16_t i = 0;
+  uint64_t diff = 0;
+  if !consteval {
+    if (l * 64 >= SIMD_BITWISE_BITS) {
+#if defined(__AVX512F__)
+      if (i + 8 <= l) {
+        __m512i acc = _mm512_setzero_si512();
+#pragma GCC unroll 128
+        for (; i + 8 <= l; i += 8) {
+          acc = _mm512_or_si512(acc,
+                                _mm512_xor_si512(_mm512_loadu_si512(a + i),
+                                                 _mm512_loadu_si512(b + i)));
+        }
+        diff |= _mm512_test_epi64_mask(acc, acc);
+      }
+#endif
+#if defined(__AVX2__)
+      if (i + 4 <= l) {
+        __m256i acc = _mm256_setzero_si256();
+#pragma GCC unroll 128
+        for (; i + 4 <= l; i += 4) {
+          const __m256i x = _mm256_loadu_si256((const __m256i *)(a + i));
+          const __m256i y = _mm256_loadu_si256((const __m256i *)(b + i));
+          acc = _mm256_or_si256(acc, _mm256_xor_si256(x, y));
+        }
+        diff |= !_mm256_testz_si256(acc, acc);
+      }
+#endif
+#if defined(__SSE2__)
+      if (i + 2 <= l) {
+        __m128i acc = _mm_setzero_si128();
+#pragma GCC unroll 128
+        for (; i + 2 <= l; i += 2) {
+          const __m128i x = _mm_loadu_si128((const __m128i *)(a + i));
+          const __m128i y = _mm_loadu_si128((const __m128i *)(b + i));
+          acc = _mm_or_si128(acc, _mm_xor_si128(x, y));
+        }
+        // one mask bit per zero byte, SSE2 has no ptest
+        diff |= _mm_movemask_epi8(_mm_cmpeq_epi8(acc, _mm_setzero_si128())) ^
+                0xffff;
+      }
+#elif defined(__ARM_NEON)
+      if (i + 2 <= l) {
+        uint64x2_t acc = vdupq_n_u64(0);
+#pragma GCC unroll 128
+        for (; i + 2 <= l; i += 2) {
+          acc = vorrq_u64(acc, veorq_u64(vld1q_u64(a + i), vld1q_u64(b + i)));
+        }
+        diff |= vgetq_lane_u64(acc, 0) | vgetq_lane_u64(acc, 1);
+      }
+#endif
+    }
+  }
+  for (; i < l; i++) {
+    diff |= a[i] ^ b[i];
+  }
+  return diff == 0;
+}
+
+template <uint16_t L>
+constexpr bool equal_limbs(const uint64_t *a, const uint64_t *b) noexcept {
+  return equal_limbs(a, b, L);
+}
+
+// number of limbs below the most significant non-zero one
+constexpr uint16_t limbs_used(const uint64_t *a, const uint16_t l) noexcept {
+  uint16_t n = l;
+  while ((n > 0) && (a[n - 1] == 0)) {
+    n--;
+  }
+  return n;
+}
+
+template <uint16_t L>
+constexpr uint16_t limbs_used(const uint64_t *a) noexcept {
+  return limbs_used(a, L);
+}
+
+/////////////// counting ///////////////
+
+constexpr uint16_t popcount_limbs(const uint64_t *a, const uint16_t l) {
+  uint16_t n = 0;
+  for (uint16_t i = 0; i < l; i++) {
+    n += popcnt(a[i]);
+  }
+  return n;
+}
+
+template <uint16_t L> constexpr uint16_t popcount_limbs(const uint64_t *a) {
+  return popcount_limbs(a, L);
+}
+
+// position of the most significant set bit plus one, 0 when a is zero
+constexpr uint16_t bit_width_limbs(const uint64_t *a, const uint16_t l) {
+  const uint16_t n = limbs_used(a, l);
+  return (n == 0) ? 0 : uint16_t(64 * n - clz(a[n - 1]));
+}
+
+template <uint16_t L> constexpr uint16_t bit_width_limbs(const uint64_t *a) {
+  return bit_width_limbs(a, L);
+}
+
+// number of zero bits below the least significant set bit, 64 * l when a is
+// zero
+constexpr uint16_t countr_zero_limbs(const uint64_t *a, const uint16_t l) {
+  for (uint16_t i = 0; i < l; i++) {
+    if (a[i] != 0) {
+      return uint16_t(64 * i + ctz(a[i]));
+    }
+  }
+  return uint16_t(64 * l);
+}
+
+template <uint16_t L> constexpr uint16_t countr_zero_limbs(const uint64_t *a) {
+  return countr_zero_limbs(a, L);
+}
+
+// q[0 .. ln) = n / d, d must not be zero. work holds ln + ld + 1 limbs of
+// scratch space and n % d is left in work[0 .. ld).
+//
+// Knuth, TAOCP vol. 2, 4.3.1, algorithm D. Kept out of line, with constant
+// sizes g++ -O3 would inline the whole loop nest into every division.
+[[gnu::noinline]] constexpr void
+divmod_limbs(const uint64_t *n, const uint16_t ln, const uint64_t *d,
+             const uint16_t ld, uint64_t *q, uint64_t *work) noexcept {
+  uint64_t *const un = work;
+  uint64_t *const vn = work + ln + 1;
+  for (uint16_t i = 0; i < ln; i++) {
+    q[i] = 0;
+  }
+
+  const uint16_t dn = limbs_used(d, ld);
+  const uint16_t nn = limbs_used(n, ln);
+
+  if (nn < dn) {
+    for (uint16_t i = 0; i < ld; i++) {
+      un[i] = (i < nn) ? n[i] : 0;
+    }
+  } else if (dn == 1) {
+    uint64_t rem = 0;
+    for (uint16_t j = nn; j-- > 0;) {
+      q[j] = div128(rem, n[j], d[0], rem);
+    }
+    un[0] = rem;
+    for (uint16_t i = 1; i < ld; i++) {
+      un[i] = 0;
+    }
+  } else {
+    // D1: normalize so the top limb of the divisor has its high bit set
+    const int s = std::countl_zero(d[dn - 1]);
+    const auto spill = [s](const uint64_t v) -> uint64_t {
+      return (s == 0) ? 0 : (v >> (64 - s));
+    };
+
+    for (uint16_t i = dn - 1; i > 0; i--) {
+      vn[i] = (d[i] << s) | spill(d[i - 1]);
+    }
+    vn[0] = d[0] << s;
+    un[nn] = spill(n[nn - 1]);
+    for (uint16_t i = nn - 1; i > 0; i--) {
+      un[i] = (n[i] << s) | spill(n[i - 1]);
+    }
+    un[0] = n[0] << s;
+
+    const uint64_t top = vn[dn - 1];
+    const uint64_t next = vn[dn - 2];
+
+    for (uint16_t j = nn - dn + 1; j-- > 0;) {
+      // D3: estimate the quotient limb from the top limbs
+      uint64_t qhat;
+      uint64_t rhat;
+      bool rhat_overflow = false;
+      if (un[j + dn] >= top) {
+        qhat = ~uint64_t(0);
+        rhat = un[j + dn - 1] + top;
+        rhat_overflow = rhat < top;
+      } else {
+        qhat = div128(un[j + dn], un[j + dn - 1], top, rhat);
+      }
+      while (!rhat_overflow &&
+             (uint128_t(qhat) * next >
+              ((uint128_t(rhat) << 64) | un[j + dn - 2]))) {
+        qhat--;
+        rhat += top;
+        rhat_overflow = rhat < top;
+      }
+
+      // D4: multiply and subtract
+      uint64_t carry = 0;
+      uint64_t borrow = 0;
+      for (uint16_t i = 0; i < dn; i++) {
+        const uint64_t p = mul_add(qhat, vn[i], carry, 0, carry);
+        un[i + j] = subb(un[i + j], p, borrow, borrow);
+      }
+      un[j + dn] = subb(un[j + dn], carry, borrow, borrow);
+
+      // D6: the estimate was one too large, add back
+      if (borrow) {
+        qhat--;
+        uint64_t c = 0;
+        for (uint16_t i = 0; i < dn; i++) {
+          un[i + j] = addc(un[i + j], vn[i], c, c);
+        }
+        un[j + dn] += c;
+      }
+
+      q[j] = qhat;
+    }
+
+    // D8: unnormalize the remainder in place
+    for (uint16_t i = 0; i < dn; i++) {
+      un[i] = (un[i] >> s) | ((s == 0) ? 0 : (un[i + 1] << (64 - s)));
+    }
+    for (uint16_t i = dn; i < ld; i++) {
+      un[i] = 0;
+    }
+  }
+}
+
+// q[0 .. LN) = n / d and r[0 .. LD) = n % d, d must not be zero
+template <uint16_t LN, uint16_t LD>
+constexpr void divmod_limbs(const uint64_t *n, const uint64_t *d, uint64_t *q,
+                            uint64_t *r) noexcept {
+  // written before it is read
+  std::array<uint64_t, LN + LD + 1> work;
+  divmod_limbs(n, LN, d, LD, q, work.data());
+  for (uint16_t i = 0; i < LD; i++) {
+    r[i] = work[i];
+  }
+}
+
+/////////////// modular ///////////////
+
+// -m^-1 mod 2^64 for odd m, Newton's iteration x = x (2 - m x) doubles the
+// number of correct low bits and m is its own inverse mod 8
+constexpr uint64_t neg_inverse_limb(const uint64_t m) noexcept {
+  uint64_t x = m;
+  for (int i = 0; i < 5; i++) {
+    x *= 2 - m * x;
+  }
+  return 0 - x;
+}
+
+// out = a < m ? a : a - m where a = (high, a[0 .. L)) < 2m, without a branch
+template <uint16_t L>
+constexpr void sub_if_above_limbs(uint64_t *out, const uint64_t *a,
+                                  const uint64_t high,
+                                  const uint64_t *m) noexcept {
+  std::array<uint64_t, L> d;
+  uint64_t borrow = 0;
+  for (uint16_t i = 0; i < L; i++) {
+    d[i] = subb(a[i], m[i], borrow, borrow);
+  }
+  subb(high, 0, borrow, borrow);
+  // ~0 when a < m
+  const uint64_t keep = 0 - borrow;
+  for (uint16_t i = 0; i < L; i++) {
+    out[i] = (a[i] & keep) | (d[i] & ~keep);
+  }
+}
+
+// out[0 .. L) = a b 2^(-64 L) mod m for a, b < m, m odd and
+// minv = -m^-1 mod 2^64. out may alias a or b.
+//
+// Montgomery multiplication, coarsely integrated operand scanning (Koc,
+// Acar and Kaliski 1996): each step adds a b[i] and the multiple of m that
+// clears the low limb, then drops it. The sum stays below 2m.
+template <uint16_t L>
+constexpr void mont_mul_limbs(const uint64_t *a, const uint64_t *b,
+                              const uint64_t *m, const uint64_t minv,
+                              uint64_t *out) noexcept {
+  std::array<uint64_t, L + 1> t{};
+  for (uint16_t i = 0; i < L; i++) {
+    uint64_t carry = 0;
+#pragma GCC unroll 128
+    for (uint16_t j = 0; j < L; j++) {
+      t[j] = mul_add(a[j], b[i], t[j], carry, carry);
+    }
+    uint64_t top = 0;
+    t[L] = addc(t[L], carry, 0, top);
+
+    const uint64_t u = t[0] * minv;
+    mul_add(u, m[0], t[0], 0, carry);
+#pragma GCC unroll 128
+    for (uint16_t j = 1; j < L; j++) {
+      t[j - 1] = mul_add(u, m[j], t[j], carry, carry);
+    }
+    t[L - 1] = addc(t[L], carry, 0, carry);
+    t[L] = top + carry;
+  }
+  sub_if_above_limbs<L>(out, t.data(), t[L], m);
+}
+
+// out[0 .. L) = a + b mod m for a, b < m
+template <uint16_t L>
+constexpr void add_mod_limbs(uint64_t *out, const uint64_t *a,
+                             const uint64_t *b, const uint64_t *m) noexcept {
+  std::array<uint64_t, L> s;
+  uint64_t carry = 0;
+  for (uint16_t i = 0; i < L; i++) {
+    s[i] = addc(a[i], b[i], carry, carry);
+  }
+  sub_if_above_limbs<L>(out, s.data(), carry, m);
+}
+
+// out[0 .. L) = a - b mod m for a, b < m
+template <uint16_t L>
+constexpr void sub_mod_limbs(uint64_t *out, const uint64_t *a,
+                             const uint64_t *b, const uint64_t *m) noexcept {
+  std::array<uint64_t, L> d;
+  uint64_t borrow = 0;
+  for (uint16_t i = 0; i < L; i++) {
+    d[i] = subb(a[i], b[i], borrow, borrow);
+  }
+  // add m back when a < b
+  const uint64_t fill = 0 - borrow;
+  uint64_t carry = 0;
+  for (uint16_t i = 0; i < L; i++) {
+    out[i] = addc(d[i], m[i] & fill, carry, carry);
+  }
+}
+
+} // namespace mango
@@ -13,7 +13,7 @@ template <uint16_t N, typename MaskType, typename ValueType> struct MaskedBits {
   static constexpr ValueType value{};
   const mango::Bits<N> bits;
 
-  MaskedBits(const mango::Bits<N> &bs) : bits(bs) {}
+  constexpr MaskedBits(const mango::Bits<N> &bs) : bits(bs) {}
 
   consteval static bool is_fixed() noexcept {
     return (MaskType{} + mango::Nat<1>{}) ==
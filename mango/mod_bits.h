@@ -0,0 +1,247 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include "mango/bits.h"
+#include "mango/limbs.h"
+#include "mango/nat.h"
+
+namespace mango {
+
+// MONTGOMERY keeps values as x 2^(64 L) mod m and reduces a product with L
+// multiply-add passes over m, it needs an odd modulus. BARRETT keeps plain
+// values and reduces a product with two multiplications by constants.
+enum class ModReduction { MONTGOMERY, BARRETT };
+
+// Montgomery whenever it applies: make mod measures it ahead of Barrett for
+// odd moduli at 256 and 1024 bits, so Barrett is only the even fallback
+template <typename M>
+constexpr ModReduction default_reduction =
+    ((M{}.get(0) & 1) == 1) ? ModReduction::MONTGOMERY : ModReduction::BARRETT;
+
+// Integers modulo a compile-time constant m, stored in Bits<bit_size(m)>:
+//
+//    using P = Nat<0xffffffffffffffed, ~0ULL, ~0ULL, 0x7fffffffffffffff>;
+//    using F = ModBits<P>;                     // 2^255 - 19
+//    F x{Bits<256>{...}};
+//    F y = (x * x + F{Nat<486662>{}}).pow(Bits<8>{5});
+//    Bits<255> v = (y * x.inverse()).value();
+//
+// Every constant of the reduction (2^(64 L) mod m, 2^(128 L) mod m,
+// -m^-1 mod 2^64, floor(2^(2 bit_size(m)) / m)) is computed at compile time
+// from the Nat. Odd moduli use Montgomery reduction, even ones Barrett.
+template <typename M, ModReduction Reduction = default_reduction<M>>
+struct ModBits;
+
+template <uint64_t... Ms, ModReduction Reduction>
+struct ModBits<Nat<Ms...>, Reduction> {
+  using Modulus = Nat<Ms...>;
+
+  constexpr static uint16_t WIDTH = Modulus{}.bit_size();
+  constexpr static uint16_t LIMBS = Bits<WIDTH>::LIMBS;
+  constexpr static ModReduction REDUCTION = Reduction;
+
+  static_assert(WIDTH >= 2, "the modulus must be at least 2");
+  static_assert(Reduction == ModReduction::BARRETT ||
+                    (Modulus{}.get(0) & 1) == 1,
+                "Montgomery reduction needs an odd modulus");
+
+  constexpr static Bits<WIDTH> MODULUS = to_bits(Modulus{});
+
+  // Montgomery: 2^(64 L) mod m (one), its square (conversion into the
+  // form) and -m^-1 mod 2^64
+  using R = decltype((Nat<1>{} << Nat<64 * LIMBS>{}) % Modulus{});
+  constexpr static Bits<WIDTH> R1 = Bits<WIDTH>{to_bits(R{})};
+  constexpr static Bits<WIDTH> R2 =
+      Bits<WIDTH>{to_bits((R{} * R{}) % Modulus{})};
+  constexpr static uint64_t MINV = neg_inverse_limb(Modulus{}.get(0));
+
+  // Barrett: floor(2^(2 WIDTH) / m), WIDTH + 1 bits unless m is a power of 2
+  constexpr static auto MU =
+      to_bits((Nat<1>{} << Nat<2 * WIDTH>{}) / Modulus{});
+
+  constexpr ModBits() noexcept = default;
+
+  // x mod m
+  template <uint16_t N>
+  constexpr ModBits(const Bits<N> &x) noexcept
+      : residue{to_form(reduce(x))} {}
+
+  template <uint64_t... Vs>
+  constexpr ModBits(const Nat<Vs...>) noexcept
+      : residue{to_form(Bits<WIDTH>{to_bits(Nat<Vs...>{} % Modulus{})})} {}
+
+  constexpr static ModBits one() noexcept {
+    if constexpr (Reduction == ModReduction::MONTGOMERY) {
+      return from_residue(R1);
+    } else {
+      return from_residue(Bits<WIDTH>{1});
+    }
+  }
+
+  // the value in [0, m)
+  constexpr Bits<WIDTH> value() const noexcept {
+    if constexpr (Reduction == ModReduction::MONTGOMERY) {
+      return mont_mul(residue, Bits<WIDTH>{1});
+    } else {
+      return residue;
+    }
+  }
+
+  // x mod m for any x, products of two values take the Barrett path
+  template <uint16_t N>
+  constexpr static Bits<WIDTH> reduce(const Bits<N> &x) noexcept {
+    if constexpr (N < WIDTH) {
+      return x.template zero_extend<WIDTH>();
+    } else if constexpr (N <= 2 * WIDTH) {
+      return barrett(x.template zero_extend<2 * WIDTH>());
+    } else {
+      return Bits<WIDTH>{x % MODULUS};
+    }
+  }
+
+  constexpr ModBits operator+(const ModBits &rhs) const noexcept {
+    ModBits out;
+    add_mod_limbs<LIMBS>(out.residue.limbs, residue.limbs, rhs.residue.limbs,
+                         MODULUS.limbs);
+    return out;
+  }
+
+  constexpr ModBits operator-(const ModBits &rhs) const noexcept {
+    ModBits out;
+    sub_mod_limbs<LIMBS>(out.residue.limbs, residue.limbs, rhs.residue.limbs,
+                         MODULUS.limbs);
+    return out;
+  }
+
+  constexpr ModBits operator-() const noexcept { return ModBits{} - *this; }
+
+  constexpr ModBits operator*(const ModBits &rhs) const noexcept {
+    if constexpr (Reduction == ModReduction::MONTGOMERY) {
+      return from_residue(mont_mul(residue, rhs.residue));
+    } else {
+      return from_residue(barrett(residue * rhs.residue));
+    }
+  }
+
+  constexpr ModBits &operator+=(const ModBits &rhs) noexcept {
+    return *this = *this + rhs;
+  }
+
+  constexpr ModBits &operator-=(const ModBits &rhs) noexcept {
+    return *this = *this - rhs;
+  }
+
+  constexpr ModBits &operator*=(const ModBits &rhs) noexcept {
+    return *this = *this * rhs;
+  }
+
+  // the representation is unique, both sides are fully reduced
+  constexpr bool operator==(const ModBits &rhs) const noexcept {
+    return residue == rhs.residue;
+  }
+
+  // this ** e, square and multiply from the top set bit of e
+  template <uint16_t E>
+  constexpr ModBits pow(const Bits<E> &e) const noexcept {
+    ModBits acc = one();
+    for (uint16_t i = E - e.leading_zeros(); i-- > 0;) {
+      acc = acc * acc;
+      if (((e.get(i / 64) >> (i % 64)) & 1) != 0) {
+        acc = acc * *this;
+      }
+    }
+    return acc;
+  }
+
+  template <uint64_t... Es>
+  constexpr ModBits pow(const Nat<Es...>) const noexcept {
+    return pow(to_bits(Nat<Es...>{}));
+  }
+
+  // x with this * x = 1, 0 when there is none (gcd(this, m) != 1). The
+  // extended Euclidean algorithm on (m, this): t0 and t1 follow r0 and r1 as
+  // multiples of this, so the last nonzero remainder is this * t0 mod m
+  constexpr ModBits inverse() const noexcept {
+    Bits<WIDTH> r0 = MODULUS;
+    Bits<WIDTH> r1 = value();
+    ModBits t0{};
+    ModBits t1 = one();
+    while (!(r1 == Nat<0>{})) {
+      const auto [q, r] = r0.divmod(r1);
+      const ModBits t = t0 - ModBits{q} * t1;
+      r0 = r1;
+      r1 = r;
+      t0 = t1;
+      t1 = t;
+    }
+    return (r0 == Nat<1>{}) ? t0 : ModBits{};
+  }
+
+private:
+  // x mod m, in Montgomery form when REDUCTION is MONTGOMERY
+  Bits<WIDTH> residue{};
+
+  constexpr static ModBits from_residue(const Bits<WIDTH> &r) noexcept {
+    ModBits out;
+    out.residue = r;
+    return out;
+  }
+
+  constexpr static Bits<WIDTH> to_form(const Bits<WIDTH> &x) noexcept {
+    if constexpr (Reduction == ModReduction::MONTGOMERY) {
+      return mont_mul(x, R2);
+    } else {
+      return x;
+    }
+  }
+
+  constexpr static Bits<WIDTH> mont_mul(const Bits<WIDTH> &a,
+                                        const Bits<WIDTH> &b) noexcept {
+    typename Bits<WIDTH>::Limbs out;
+    mont_mul_limbs<LIMBS>(a.limbs, b.limbs, MODULUS.limbs, MINV, out.data());
+    return Bits<WIDTH>{out};
+  }
+
+  // x mod m for x < 2^(2 WIDTH), after Barrett (Menezes et al., Handbook of
+  // Applied Cryptography, 14.42). With q1 = x >> K and MU = 2^K + mu,
+  // q = q1 + (q1 mu >> K) is at most 3 below x / m. Only the top half of
+  // q1 mu is computed: the partial products below limb T add up to less than
+  // 2^K and cost q one more. The remainder is then below 5m < 2^(K + 3), so
+  // only its low K + 4 bits are computed, and 4m, 2m and m are subtracted
+  // where they fit.
+  constexpr static Bits<WIDTH> barrett(const Bits<2 * WIDTH> &x) noexcept {
+    constexpr uint16_t K = WIDTH;
+    if constexpr (decltype(MU)::WIDTH > K + 1) {
+      // m = 2^(K - 1)
+      return Bits<WIDTH>{x.template trim<K - 1>()};
+    } else {
+      constexpr uint16_t L = LIMBS;
+      constexpr uint16_t T = (K / 64 >= 2) ? K / 64 - 2 : 0;
+      constexpr Bits<K> mu{MU};
+      const Bits<K> q1{x.template shr<K>()};
+      std::array<uint64_t, 2 * L - T> high{};
+      mul_high_limbs<L, L, T>(q1.limbs, mu.limbs, high.data());
+      const auto q =
+          q1 + Bits<K>{Bits<64 * (2 * L - T)>{high}.template shr<K - 64 * T>()};
+      // r < 5m < 2^(K + 3), the top bit of r - d is its sign
+      constexpr Bits<K + 4> m{MODULUS};
+      auto r = Bits<K + 4>{x}.sub_wrap(Bits<K + 4>{q}.mul_wrap(MODULUS));
+      r = subtract_if_fits(r, Bits<K + 4>{m.template shl<2>()});
+      r = subtract_if_fits(r, Bits<K + 4>{m.template shl<1>()});
+      r = subtract_if_fits(r, m);
+      return Bits<WIDTH>{r};
+    }
+  }
+
+  // r - d when d <= r, r otherwise, both are below 2^(N - 1)
+  template <uint16_t N>
+  constexpr static Bits<N> subtract_if_fits(const Bits<N> &r,
+                                            const Bits<N> &d) noexcept {
+    const auto diff = r.sub_wrap(d);
+    return diff.is_signed() ? r : diff;
+  }
+};
+
+} // namespace mango
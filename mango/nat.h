@@ -1,9 +1,14 @@
 #pragma once
 
+#include "charconv.h"
 #include "common.h"
+#include "limbs.h"
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <cstdint>
 #include <iostream>
+#include <utility>
 
 namespace mango {
 
@@ -11,6 +16,28 @@ namespace mango {
 template <uint64_t... Vs> struct Nat; // Little endian
 template <uint64_t... Vs> struct Neg;
 
+// The arithmetic below runs once over constexpr limb arrays (std::array is a
+// structural type, so it can be passed as a template argument) and only the
+// result is turned back into a Nat. Recursing over the parameter packs
+// instead creates a new class per limb and per intermediate value.
+template <auto Limbs> consteval auto to_nat() noexcept;
+
+// A copy of a built from a full initializer list. gcc 12 can treat two
+// std::array template arguments as equal when they were built by assigning
+// to the elements of a value initialized array, so the arrays handed to
+// to_nat go through here first.
+template <size_t N, size_t... Is>
+consteval std::array<uint64_t, N> rebuilt(const std::array<uint64_t, N> a,
+                                          std::index_sequence<Is...>) noexcept {
+  return {a[Is]...};
+}
+
+template <size_t N>
+consteval std::array<uint64_t, N>
+rebuilt(const std::array<uint64_t, N> a) noexcept {
+  return rebuilt(a, std::make_index_sequence<N>{});
+}
+
 /***************************/
 /* special case: not empty */
 /***************************/
@@ -19,28 +46,68 @@ template <uint64_t Low, uint64_t... High> struct Nat<Low, High...> {
 
   constexpr static uint64_t low = Low;
 
-  constexpr static const Nat<High...> high() noexcept { return {}; }
+  constexpr static uint16_t L = 1 + sizeof...(High);
 
-  constexpr uint64_t bit_size() const noexcept {
-    const auto t = Nat<High...>{}.bit_size();
+  constexpr static std::array<uint64_t, L> limbs{Low, High...};
 
-    if (t == 0) {
-      return 64 - clz(low);
-    } else {
-      return t + 64;
+  // limb kernels for the shifts and trim, see to_nat
+
+  template <uint64_t S>
+  consteval static std::array<uint64_t, L + S / 64 + 1>
+  shift_left_limbs() noexcept {
+    constexpr uint64_t q = S / 64;
+    constexpr uint64_t r = S % 64;
+    std::array<uint64_t, L + q + 1> out{};
+    for (uint64_t i = 0; i < L; i++) {
+      out[i + q] |= limbs[i] << r;
+      if (r != 0) {
+        out[i + q + 1] = limbs[i] >> (64 - r);
+      }
+    }
+    return out;
+  }
+
+  template <uint64_t S>
+  consteval static std::array<uint64_t, L> shift_right_limbs() noexcept {
+    constexpr uint64_t q = S / 64;
+    constexpr uint64_t r = S % 64;
+    std::array<uint64_t, L> out{};
+    for (uint64_t i = 0; i + q < L; i++) {
+      out[i] = limbs[i + q] >> r;
+      if ((r != 0) && (i + q + 1 < L)) {
+        out[i] |= limbs[i + q + 1] << (64 - r);
+      }
     }
+    return out;
   }
 
-  constexpr static uint64_t get(uint64_t i) noexcept {
-    if (i == 0) {
-      return low;
-    } else {
-      return high().get(i - 1);
+  template <uint16_t N>
+  consteval static std::array<uint64_t, L> trim_limbs() noexcept {
+    std::array<uint64_t, L> out{};
+    for (uint64_t i = 0; i < L; i++) {
+      if (64 * (i + 1) <= N) {
+        out[i] = limbs[i];
+      } else if (64 * i < N) {
+        out[i] = limbs[i] & ((uint64_t(1) << (N % 64)) - 1);
+      }
     }
+    return out;
+  }
+
+  constexpr static const Nat<High...> high() noexcept { return {}; }
+
+  consteval static const Nat abs() noexcept { return {}; }
+
+  constexpr uint64_t bit_size() const noexcept {
+    return bit_width_limbs<L>(limbs.data());
+  }
+
+  constexpr static uint64_t get(uint64_t i) noexcept {
+    return (i < L) ? limbs[i] : 0;
   }
 
   constexpr bool is_zero() const noexcept {
-    return Low == 0 && Nat<High...>{}.is_zero();
+    return (Low == 0) && ((High == 0) && ...);
   }
 
   template <uint64_t new_low>
@@ -48,123 +115,83 @@ template <uint64_t Low, uint64_t... High> struct Nat<Low, High...> {
     return {};
   }
 
-  constexpr auto succ() const noexcept {
-    if constexpr (low == ~uint64_t{0}) {
-      return Nat<High...>{}.succ().template inject_right<0>();
-    } else {
-      return Nat<low + 1, High...>{};
-    }
-  }
+  constexpr auto succ() const noexcept { return Nat{}.add(Nat<1>{}); }
 
   ///////////////// Nat<...>::shift_left ////////////////
 
   template <uint64_t... Rs>
   constexpr auto operator<<(const Nat<Rs...> rhs) const noexcept {
-    if constexpr (rhs.is_zero()) {
-      return *this;
-    } else {
-      if constexpr (rhs >= Nat<64>{}) {
-        return Nat<0, Low, High...>{} << (rhs - Nat<64>{});
-      } else {
-        static_assert(rhs.low < 64);
-        const auto new_high =
-            (high() << Nat<rhs.low>{}) + Nat<(low >> (64 - rhs.low))>{};
-        return new_high.template inject_right<Low << rhs.low>();
-      }
-    }
+    static_assert(rhs.bit_size() <= 16, "shift amount is too large");
+    return to_nat<rebuilt(shift_left_limbs<rhs.get(0)>())>();
   }
 
   //////////////// Nat<...>::shift_right /////////////////
 
   template <uint64_t... Rs>
   consteval auto operator>>(const Nat<Rs...> rhs) const noexcept {
-    if constexpr (rhs.is_zero()) {
-      return *this;
-    } else if constexpr (rhs >= Nat<64>{}) {
-      return Nat<High...>{} >> (rhs - Nat<64>{});
-    } else {
-      if constexpr (Nat<High...>{}.is_zero()) {
-        return Nat<(low >> rhs.low)>{};
-      } else {
-        static_assert(rhs.low < 64);
-        const auto new_high = high() >> rhs;
-        const auto new_low_low = low << (64 - rhs.low) >> (64 - rhs.low);
-        const auto new_low_high = high().low << rhs.low;
-        return new_high.template inject_right<new_low_high + new_low_low>();
-      }
-    }
+    // anything from 64 * L up shifts every bit out
+    constexpr uint64_t S = (rhs.bit_size() > 16) ? 64 * L : rhs.get(0);
+    return to_nat<rebuilt(shift_right_limbs<S>())>();
   }
 
   ///////////////// Nat<...>::trim<N> ////////
 
   template <uint16_t N> consteval auto trim() const noexcept {
-    if constexpr (N >= 64) {
-      return high().template trim<N - 64>().template inject_right<low>();
-    } else {
-      static_assert(N < 64);
-      return Nat<Low &((uint64_t(1) << N) - 1)>{};
-    }
+    return to_nat<rebuilt(trim_limbs<N>())>();
   }
 
   ///////////////// Nat<...>::extract<H,L> //////////
 
-  template <uint16_t H, uint16_t L>
-    requires(H >= L)
+  template <uint16_t H, uint16_t Lo>
+    requires(H >= Lo)
   consteval auto extract() const noexcept {
-    if constexpr (L >= 64) {
-      return high().template extract<H - 64, L - 64>();
-    } else if constexpr (L == 0) {
-      return this->template trim<H + 1>();
-    } else {
-      return (*this >> Nat<L>{}).template trim<H - L + 1>();
-    }
+    return (*this >> Nat<Lo>{}).template trim<H - Lo + 1>();
   }
 
   ///////////////// Nat<...>::addition ////////////////
 
   template <uint64_t... Rs>
-  consteval auto add(const Nat<Rs...> rhs) const noexcept {
-    const auto new_low = low + rhs.low;
-    const auto new_carry = (new_low < low) || (new_low < rhs.low);
-
-    if constexpr (new_carry) {
-      const auto new_high = high().add(rhs.high().succ());
-      return new_high.template inject_right<new_low>();
-    } else {
-      const auto new_high = high().add(rhs.high());
-      return new_high.template inject_right<new_low>();
-    }
+  consteval auto add(const Nat<Rs...>) const noexcept {
+    constexpr uint16_t LR = sizeof...(Rs);
+    constexpr auto out = [] {
+      constexpr std::array<uint64_t, LR> rhs{Rs...};
+      std::array<uint64_t, mango::max(L, LR) + 1> out{Low, High...};
+      add_limbs<mango::max(L, LR) + 1, LR>(out.data(), rhs.data());
+      return out;
+    }();
+    return to_nat<rebuilt(out)>();
   }
 
   ///////////////// Nat<...>::subtraction ////////////////
 
   template <uint64_t... Rs>
   consteval auto sub(const Nat<Rs...> rhs) const noexcept {
-    if constexpr (low < rhs.low) {
-      // need to borrow from the high part
-      const auto new_high = high().sub(rhs.high().succ());
-      return new_high
-          .template inject_right<(~uint64_t(0) - rhs.low) + 1 + low>();
-    } else {
-      // no borrow needed
-      const auto new_high = high().sub(rhs.high());
-      return new_high.template inject_right<low - rhs.low>();
-    }
+    static_assert(Nat{}.cmp(rhs) != Cmp::LT, "the difference is negative");
+    constexpr uint16_t LR = sizeof...(Rs);
+    constexpr auto out = [] {
+      constexpr std::array<uint64_t, LR> rhs{Rs...};
+      std::array<uint64_t, L> out{Low, High...};
+      // rhs <= *this so limbs of rhs past L are zero
+      sub_limbs<L, mango::min(L, LR)>(out.data(), rhs.data());
+      return out;
+    }();
+    return to_nat<rebuilt(out)>();
   }
 
   //////////////// Nat<...>::comparison ////////////////
 
   template <uint64_t... Rs>
-  constexpr Cmp cmp(const Nat<Rs...> rhs,
-                    const Cmp prev = Cmp::EQ) const noexcept {
-
-    if constexpr (low == rhs.low) {
-      return high().cmp(rhs.high(), prev);
-    } else if constexpr (low > rhs.low) {
-      return high().cmp(rhs.high(), Cmp::GT);
-    } else {
-      return high().cmp(rhs.high(), Cmp::LT);
-    }
+  constexpr Cmp cmp(const Nat<Rs...>, const Cmp prev = Cmp::EQ) const noexcept {
+    constexpr Cmp c = [] {
+      constexpr Nat<Rs...> rhs{};
+      for (uint64_t i = mango::max(L, uint16_t(sizeof...(Rs))); i-- > 0;) {
+        if (get(i) != rhs.get(i)) {
+          return (get(i) < rhs.get(i)) ? Cmp::LT : Cmp::GT;
+        }
+      }
+      return Cmp::EQ;
+    }();
+    return (c == Cmp::EQ) ? prev : c;
   }
 
   template <uint64_t... Rs>
@@ -229,6 +256,8 @@ template <> struct Nat<> {
 
   consteval static const Nat<> high() noexcept { return {}; }
 
+  consteval static const Nat<> abs() noexcept { return {}; }
+
   constexpr static uint64_t get(uint64_t) noexcept { return 0; }
 
   consteval uint64_t bit_size() const noexcept { return 0; }
@@ -242,6 +271,8 @@ template <> struct Nat<> {
     return {};
   }
 
+  template <uint16_t N> consteval auto trim() const noexcept { return *this; }
+
   ///////////////// Nat<>::Shift left /////////////////////
 
   template <uint64_t... Rs>
@@ -301,18 +332,31 @@ template <> struct Nat<> {
   }
 
   template <uint64_t... Rs>
-  consteval bool operator==(const Nat<Rs...> rhs) const noexcept {
+  constexpr Cmp cmp(const Neg<Rs...> rhs) const noexcept;
+
+  template <typename Rhs>
+  constexpr bool operator==(const Rhs rhs) const noexcept {
     return cmp(rhs) == Cmp::EQ;
   }
 
-  template <uint64_t... Rs>
-  consteval bool operator<=(const Nat<Rs...> rhs) const noexcept {
+  template <typename Rhs>
+  constexpr bool operator>(const Rhs rhs) const noexcept {
+    return cmp(rhs) == Cmp::GT;
+  }
+
+  template <typename Rhs>
+  constexpr bool operator<(const Rhs rhs) const noexcept {
+    return cmp(rhs) == Cmp::LT;
+  }
+
+  template <typename Rhs>
+  constexpr bool operator<=(const Rhs rhs) const noexcept {
     return cmp(rhs) != Cmp::GT;
   }
 
-  template <uint64_t... Rs>
-  consteval bool operator>(const Nat<Rs...> rhs) const noexcept {
-    return cmp(rhs) == Cmp::GT;
+  template <typename Rhs>
+  constexpr bool operator>=(const Rhs rhs) const noexcept {
+    return cmp(rhs) != Cmp::LT;
   }
 };
 
@@ -382,6 +426,15 @@ constexpr Cmp Nat<Low, High...>::cmp(const Neg<Rs...> rhs) const noexcept {
     return Cmp::GT;
 }
 
+template <uint64_t... Rs>
+constexpr Cmp Nat<>::cmp(const Neg<Rs...> rhs) const noexcept {
+  if constexpr (rhs.is_zero()) {
+    return Cmp::EQ;
+  } else {
+    return Cmp::GT;
+  }
+}
+
 template <uint64_t... Vs>
 consteval const Neg<Vs...> operator-(const Nat<Vs...>) noexcept {
   return {};
@@ -417,7 +470,7 @@ consteval auto operator-(const Nat<Vs...> lhs, const Neg<Rs...> rhs) noexcept {
 
 template <uint64_t... Vs, uint64_t... Rs>
 consteval auto operator-(const Neg<Vs...> lhs, const Nat<Rs...> rhs) noexcept {
-  return rhs + lhs.abs();
+  return Nat<>{} - (lhs.abs() + rhs);
 }
 
 template <uint64_t... Vs, uint64_t... Rs>
@@ -440,24 +493,305 @@ consteval auto operator+(const Neg<Vs...> lhs, const Neg<Rs...> rhs) noexcept {
   return -(lhs.abs() + rhs.abs());
 }
 
-} // namespace mango
+/////////////// limb arrays ///////////////
 
 template <uint64_t... Vs>
-std::ostream &operator<<(std::ostream &os, const mango::Nat<Vs...>) {
-  bool first = true;
-  for (const auto &v : {Vs...}) {
-    if (first) {
-      first = false;
-    } else {
-      os << "_";
+consteval std::array<uint64_t, sizeof...(Vs)> limbs(const Nat<Vs...>) noexcept {
+  return {Vs...};
+}
+
+// the number of limbs left after dropping the leading zero limbs
+template <auto Limbs> consteval size_t used_limbs() noexcept {
+  size_t n = Limbs.size();
+  while ((n > 0) && (Limbs[n - 1] == 0)) {
+    n--;
+  }
+  return n;
+}
+
+template <auto Limbs, size_t... Is>
+consteval auto to_nat(std::index_sequence<Is...>) noexcept {
+  return Nat<Limbs[Is]...>{};
+}
+
+// the Nat with the given little endian limbs, without leading zero limbs
+template <auto Limbs> consteval auto to_nat() noexcept {
+  return to_nat<Limbs>(std::make_index_sequence<used_limbs<Limbs>()>{});
+}
+
+/////////////// multiplication ///////////////
+
+template <uint64_t... Vs, uint64_t... Rs>
+consteval auto operator*(const Nat<Vs...>, const Nat<Rs...>) noexcept {
+  constexpr auto product = [] {
+    constexpr std::array<uint64_t, sizeof...(Vs)> a{Vs...};
+    constexpr std::array<uint64_t, sizeof...(Rs)> b{Rs...};
+    std::array<uint64_t, sizeof...(Vs) + sizeof...(Rs)> out{};
+    mul_limbs<sizeof...(Vs), sizeof...(Rs)>(a.data(), b.data(), out.data());
+    return out;
+  }();
+  return to_nat<rebuilt(product)>();
+}
+
+template <uint64_t... Vs, uint64_t... Rs>
+consteval auto operator*(const Nat<Vs...> lhs, const Neg<Rs...> rhs) noexcept {
+  return -(lhs * rhs.abs());
+}
+
+template <uint64_t... Vs, uint64_t... Rs>
+consteval auto operator*(const Neg<Vs...> lhs, const Nat<Rs...> rhs) noexcept {
+  return -(lhs.abs() * rhs);
+}
+
+template <uint64_t... Vs, uint64_t... Rs>
+consteval auto operator*(const Neg<Vs...> lhs, const Neg<Rs...> rhs) noexcept {
+  return lhs.abs() * rhs.abs();
+}
+
+/////////////// division ///////////////
+
+// quotient and remainder, truncated like the built-in integer types
+
+template <uint64_t... Vs, uint64_t... Rs>
+consteval auto divmod(const Nat<Vs...>, const Nat<Rs...> d) noexcept {
+  static_assert(!d.is_zero(), "division by zero");
+  constexpr auto qr = [] {
+    constexpr std::array<uint64_t, sizeof...(Vs)> a{Vs...};
+    constexpr std::array<uint64_t, sizeof...(Rs)> b{Rs...};
+    std::pair<std::array<uint64_t, sizeof...(Vs)>,
+              std::array<uint64_t, sizeof...(Rs)>>
+        out{};
+    divmod_limbs<sizeof...(Vs), sizeof...(Rs)>(
+        a.data(), b.data(), out.first.data(), out.second.data());
+    return out;
+  }();
+  return std::pair{to_nat<rebuilt(qr.first)>(),
+                   to_nat<rebuilt(qr.second)>()};
+}
+
+template <uint64_t... Vs, uint64_t... Rs>
+consteval auto operator/(const Nat<Vs...> n, const Nat<Rs...> d) noexcept {
+  return divmod(n, d).first;
+}
+
+template <uint64_t... Vs, uint64_t... Rs>
+consteval auto operator/(const Nat<Vs...> n, const Neg<Rs...> d) noexcept {
+  return -(n / d.abs());
+}
+
+template <uint64_t... Vs, uint64_t... Rs>
+consteval auto operator/(const Neg<Vs...> n, const Nat<Rs...> d) noexcept {
+  return -(n.abs() / d);
+}
+
+template <uint64_t... Vs, uint64_t... Rs>
+consteval auto operator/(const Neg<Vs...> n, const Neg<Rs...> d) noexcept {
+  return n.abs() / d.abs();
+}
+
+template <uint64_t... Vs, uint64_t... Rs>
+consteval auto operator%(const Nat<Vs...> n, const Nat<Rs...> d) noexcept {
+  return divmod(n, d).second;
+}
+
+template <uint64_t... Vs, uint64_t... Rs>
+consteval auto operator%(const Nat<Vs...> n, const Neg<Rs...> d) noexcept {
+  return n % d.abs();
+}
+
+template <uint64_t... Vs, uint64_t... Rs>
+consteval auto operator%(const Neg<Vs...> n, const Nat<Rs...> d) noexcept {
+  return -(n.abs() % d);
+}
+
+template <uint64_t... Vs, uint64_t... Rs>
+consteval auto operator%(const Neg<Vs...> n, const Neg<Rs...> d) noexcept {
+  return -(n.abs() % d.abs());
+}
+
+// quotient rounded toward negative infinity, d must be positive
+
+template <uint64_t... Vs, uint64_t... Rs>
+consteval auto floor_div(const Nat<Vs...> n, const Nat<Rs...> d) noexcept {
+  return n / d;
+}
+
+template <uint64_t... Vs, uint64_t... Rs>
+consteval auto floor_div(const Neg<Vs...> n, const Nat<Rs...> d) noexcept {
+  return Nat<>{} - (n.abs() + d - Nat<1>{}) / d;
+}
+
+/////////////// power ///////////////
+
+// b ** e, square and multiply from the top bit of e. Every partial result is
+// at most the final one so the products can be truncated to its limbs.
+
+template <uint64_t... Vs, uint64_t... Es>
+consteval auto pow(const Nat<Vs...> b, const Nat<Es...> e) noexcept {
+  static_assert(e.bit_size() <= 16, "exponent is too large");
+  static_assert(b.bit_size() * e.get(0) < (uint64_t(1) << 16),
+                "power is too large");
+  constexpr uint16_t LB = sizeof...(Vs);
+  constexpr uint16_t L =
+      mango::max<uint64_t>((b.bit_size() * e.get(0) + 63) / 64, 1);
+  constexpr auto out = [] {
+    constexpr std::array<uint64_t, LB> base{Vs...};
+    constexpr uint64_t E = Nat<Es...>::get(0);
+    std::array<uint64_t, L> acc{1};
+    for (uint16_t i = 64 - clz(E); i-- > 0;) {
+      std::array<uint64_t, 2 * L> square{};
+      mul_limbs<L, L>(acc.data(), acc.data(), square.data());
+      std::copy_n(square.begin(), L, acc.begin());
+      if ((E >> i) & 1) {
+        std::array<uint64_t, L + LB> product{};
+        mul_limbs<L, LB>(acc.data(), base.data(), product.data());
+        std::copy_n(product.begin(), L, acc.begin());
+      }
     }
-    os << v;
+    return acc;
+  }();
+  return to_nat<rebuilt(out)>();
+}
+
+template <uint64_t... Vs, uint64_t... Es>
+consteval auto pow(const Neg<Vs...> b, const Nat<Es...> e) noexcept {
+  if constexpr ((e.get(0) & 1) == 0) {
+    return pow(b.abs(), e);
+  } else {
+    return -pow(b.abs(), e);
   }
-  return os;
+}
+
+/////////////// ilog2 ///////////////
+
+// floor(log2(n)), the position of the most significant set bit
+template <uint64_t... Vs> consteval auto ilog2(const Nat<Vs...> n) noexcept {
+  static_assert(!n.is_zero(), "ilog2 of zero");
+  return Nat<n.bit_size() - 1>{};
+}
+
+/////////////// gcd ///////////////
+
+// Euclid on limb arrays, gcd(0, 0) is 0
+
+template <uint64_t... Vs, uint64_t... Rs>
+consteval auto gcd(const Nat<Vs...>, const Nat<Rs...>) noexcept {
+  constexpr uint16_t L = mango::max(sizeof...(Vs), sizeof...(Rs));
+  constexpr auto out = [] {
+    std::array<uint64_t, L> a{};
+    std::array<uint64_t, L> b{};
+    std::copy_n(std::array<uint64_t, sizeof...(Vs)>{Vs...}.begin(),
+                sizeof...(Vs), a.begin());
+    std::copy_n(std::array<uint64_t, sizeof...(Rs)>{Rs...}.begin(),
+                sizeof...(Rs), b.begin());
+    if constexpr (L > 0) {
+      while (limbs_used<L>(b.data()) != 0) {
+        std::array<uint64_t, L> q{};
+        std::array<uint64_t, L> r{};
+        divmod_limbs<L, L>(a.data(), b.data(), q.data(), r.data());
+        a = b;
+        b = r;
+      }
+    }
+    return a;
+  }();
+  return to_nat<rebuilt(out)>();
+}
+
+template <uint64_t... Vs, uint64_t... Rs>
+consteval auto gcd(const Nat<Vs...> a, const Neg<Rs...> b) noexcept {
+  return gcd(a, b.abs());
+}
+
+template <uint64_t... Vs, uint64_t... Rs>
+consteval auto gcd(const Neg<Vs...> a, const Nat<Rs...> b) noexcept {
+  return gcd(a.abs(), b);
+}
+
+template <uint64_t... Vs, uint64_t... Rs>
+consteval auto gcd(const Neg<Vs...> a, const Neg<Rs...> b) noexcept {
+  return gcd(a.abs(), b.abs());
+}
+
+/////////////// min / max ///////////////
+
+template <typename A, typename B>
+consteval auto min_value(const A a, const B b) noexcept {
+  if constexpr (A{} <= B{}) {
+    return a;
+  } else {
+    return b;
+  }
+}
+
+template <typename A, typename B>
+consteval auto max_value(const A a, const B b) noexcept {
+  if constexpr (A{} >= B{}) {
+    return a;
+  } else {
+    return b;
+  }
+}
+
+/////////////////////
+// text conversion //
+/////////////////////
+
+template <uint64_t... Vs>
+std::to_chars_result to_chars(char *first, char *last, const Nat<Vs...>,
+                              const int base = 10) noexcept {
+  constexpr std::array<uint64_t, sizeof...(Vs)> limbs{Vs...};
+  return limbs_to_chars<sizeof...(Vs)>(first, last, limbs.data(), base);
+}
+
+template <uint64_t... Vs>
+std::to_chars_result to_chars(char *first, char *last, const Neg<Vs...>,
+                              const int base = 10) noexcept {
+  if constexpr (Neg<Vs...>::is_zero()) {
+    return to_chars(first, last, Nat<>{}, base);
+  } else {
+    if (first == last) {
+      return {last, std::errc::value_too_large};
+    }
+    *first = '-';
+    return to_chars(first + 1, last, Neg<Vs...>::abs(), base);
+  }
+}
+
+} // namespace mango
+
+template <uint64_t... Vs>
+std::ostream &operator<<(std::ostream &os, const mango::Nat<Vs...>) {
+  constexpr std::array<uint64_t, sizeof...(Vs)> limbs{Vs...};
+  return mango::print_limbs<sizeof...(Vs), 64 * sizeof...(Vs)>(
+      os, limbs.data(), false);
 }
 
 template <uint64_t... Vs>
 std::ostream &operator<<(std::ostream &os, const mango::Neg<Vs...>) {
-  os << "-" << mango::Nat<Vs...>{};
-  return os;
+  constexpr std::array<uint64_t, sizeof...(Vs)> limbs{Vs...};
+  return mango::print_limbs<sizeof...(Vs), 64 * sizeof...(Vs)>(
+      os, limbs.data(), !mango::Neg<Vs...>::is_zero());
 }
+
+#ifdef __cpp_lib_format
+
+template <uint64_t... Vs>
+struct std::formatter<mango::Nat<Vs...>> : mango::DigitsFormatter {
+  auto format(const mango::Nat<Vs...>, auto &ctx) const {
+    constexpr std::array<uint64_t, sizeof...(Vs)> limbs{Vs...};
+    return format_limbs<sizeof...(Vs), 64 * sizeof...(Vs)>(limbs.data(),
+                                                           false, ctx);
+  }
+};
+
+template <uint64_t... Vs>
+struct std::formatter<mango::Neg<Vs...>> : mango::DigitsFormatter {
+  auto format(const mango::Neg<Vs...>, auto &ctx) const {
+    constexpr std::array<uint64_t, sizeof...(Vs)> limbs{Vs...};
+    return format_limbs<sizeof...(Vs), 64 * sizeof...(Vs)>(
+        limbs.data(), !mango::Neg<Vs...>::is_zero(), ctx);
+  }
+};
+
+#endif
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "mango/bits.h"
+#include "mango/int.h"
+
+namespace mango {
+
+// A string literal usable as a template argument: Field<"x", Bits<3>>
+template <size_t K> struct FieldName {
+  char chars[K]{};
+
+  constexpr FieldName(const char (&s)[K]) noexcept {
+    for (size_t i = 0; i < K; i++) {
+      chars[i] = s[i];
+    }
+  }
+
+  template <size_t K2>
+  constexpr bool operator==(const FieldName<K2> &rhs) const noexcept {
+    if constexpr (K != K2) {
+      return false;
+    } else {
+      for (size_t i = 0; i < K; i++) {
+        if (chars[i] != rhs.chars[i]) {
+          return false;
+        }
+      }
+      return true;
+    }
+  }
+};
+
+// number of bits a value of T takes in a PackedRecord
+template <typename T> struct PackedWidth;
+
+template <uint16_t N> struct PackedWidth<Bits<N>> {
+  constexpr static uint16_t WIDTH = N;
+};
+
+template <typename Min, typename Max> struct PackedWidth<Int<Min, Max>> {
+  constexpr static uint16_t WIDTH = Int<Min, Max>::bitsize;
+};
+
+template <uint64_t N> struct PackedWidth<SignedInt<N>> {
+  constexpr static uint16_t WIDTH = SignedInt<N>::bitsize;
+};
+
+template <FieldName Name, typename T> struct Field {
+  using Type = T;
+  constexpr static auto name = Name;
+  constexpr static uint16_t WIDTH = PackedWidth<T>::WIDTH;
+};
+
+// Fields laid out back to back at bit granularity, the first field in the
+// lowest bits. The record is a single Bits<WIDTH> so it takes the minimum
+// number of limbs, e.g. ten 6-bit fields share one uint64_t. Fields are read
+// with extract and written with concat.
+template <typename... Fields> struct PackedRecord {
+  constexpr static uint16_t WIDTH = (uint16_t(0) + ... + Fields::WIDTH);
+  constexpr static size_t COUNT = sizeof...(Fields);
+
+  Bits<WIDTH> bits{};
+
+  template <size_t I>
+  using FieldAt = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+  template <size_t I> using TypeAt = typename FieldAt<I>::Type;
+
+  // bit offset of field I
+  template <size_t I> constexpr static uint16_t offset() noexcept {
+    constexpr uint16_t widths[] = {Fields::WIDTH..., 0};
+    uint16_t off = 0;
+    for (size_t i = 0; i < I; i++) {
+      off += widths[i];
+    }
+    return off;
+  }
+
+  template <FieldName Name> constexpr static size_t index() noexcept {
+    size_t i = 0;
+    size_t found = COUNT;
+    ((found = (found == COUNT && Fields::name == Name) ? i : found, i++),
+     ...);
+    return found;
+  }
+
+  constexpr PackedRecord() noexcept = default;
+
+  // from the packed bits, like Int(raw_bits, true)
+  constexpr PackedRecord(const Bits<WIDTH> &raw, const bool) noexcept
+      : bits{raw} {}
+
+  constexpr explicit PackedRecord(
+      const typename Fields::Type &...values) noexcept {
+    set_all(std::index_sequence_for<Fields...>{}, values...);
+  }
+
+  template <size_t I> constexpr TypeAt<I> get_at() const noexcept {
+    constexpr uint16_t W = FieldAt<I>::WIDTH;
+    constexpr uint16_t L = offset<I>();
+    if constexpr (W == 0) {
+      return TypeAt<I>{};
+    } else {
+      const Bits<W> field = bits.template extract<L + W - 1, L>();
+      if constexpr (std::is_same_v<TypeAt<I>, Bits<W>>) {
+        return field;
+      } else {
+        return TypeAt<I>{field, true};
+      }
+    }
+  }
+
+  template <size_t I> constexpr void set_at(const TypeAt<I> &v) noexcept {
+    constexpr uint16_t W = FieldAt<I>::WIDTH;
+    constexpr uint16_t L = offset<I>();
+    if constexpr (W > 0) {
+      Bits<W> field;
+      if constexpr (std::is_same_v<TypeAt<I>, Bits<W>>) {
+        field = v;
+      } else {
+        field = v.biased_bits;
+      }
+      const auto low = [&] {
+        if constexpr (L == 0) {
+          return field;
+        } else {
+          return field.concat(bits.template extract<L - 1, 0>());
+        }
+      }();
+      if constexpr (L + W == WIDTH) {
+        bits = low;
+      } else {
+        bits = bits.template extract<WIDTH - 1, L + W>().concat(low);
+      }
+    }
+  }
+
+  template <FieldName Name> constexpr auto get() const noexcept {
+    static_assert(index<Name>() < COUNT, "no such field");
+    return get_at<index<Name>()>();
+  }
+
+  template <FieldName Name>
+  constexpr void set(const TypeAt<index<Name>()> &v) noexcept {
+    static_assert(index<Name>() < COUNT, "no such field");
+    set_at<index<Name>()>(v);
+  }
+
+private:
+  template <size_t... Is>
+  constexpr void set_all(std::index_sequence<Is...>,
+                         const typename Fields::Type &...values) noexcept {
+    (set_at<Is>(values), ...);
+  }
+};
+
+} // namespace mango
@@ -0,0 +1,376 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "mango/bits.h"
+#include "mango/int.h"
+
+namespace mango {
+
+// Stable radix sort of a span of Bits<N> (unsigned order) or Int<Min, Max>
+// (value order), optionally permuting a span of values along:
+//
+//    radix_sort(std::span{keys});
+//    radix_sort(std::span{keys}, std::span{payload});
+//    radix_sort(std::span{keys}, std::span{payload}, 8);  // 8 threads
+//
+// The key width W (N, or the bits of Max - Min) is known at compile time,
+// so the digits are planned exactly. Keys of at most RADIX_LSD_BITS bits
+// take ceil(W / 8) LSD passes of equal width: Int<0, 999999> has 20 bits,
+// three passes of 7 bits. Wider keys are sorted MSD 8 bits at a time from
+// the top, and buckets of at most RADIX_SMALL keys are finished by insertion
+// sort. A pass whose digit is the same for every key moves nothing. The sort
+// needs a scratch copy of the keys and of the values.
+//
+// With threads > 1 every pass splits the keys between the threads: each
+// counts its part in its own histogram, the histograms are combined into
+// per thread write offsets, and each thread scatters its part. MSD then
+// hands the buckets of the first pass to the threads.
+
+// digit width, 256 counters per histogram
+constexpr uint16_t RADIX_DIGIT_BITS = 8;
+
+// wider keys are sorted most significant digit first
+constexpr uint16_t RADIX_LSD_BITS = 32;
+
+// MSD buckets of at most this many keys are insertion sorted
+constexpr size_t RADIX_SMALL = 32;
+
+// fewer keys than this are not split between threads
+constexpr size_t RADIX_PARALLEL_MIN = size_t(1) << 16;
+
+// LSD digits for W-bit keys: ceil(W / 8) passes of equal width
+template <uint16_t W> struct RadixPlan {
+  constexpr static uint16_t PASSES =
+      (W + RADIX_DIGIT_BITS - 1) / RADIX_DIGIT_BITS;
+  constexpr static uint16_t DIGIT_BITS =
+      (PASSES == 0) ? 0 : (W + PASSES - 1) / PASSES;
+  constexpr static bool LSD = (W <= RADIX_LSD_BITS);
+};
+
+// the bits a key is sorted by
+template <uint16_t N>
+constexpr const Bits<N> &radix_bits(const Bits<N> &key) noexcept {
+  return key;
+}
+
+template <typename Min, typename Max>
+constexpr const auto &radix_bits(const Int<Min, Max> &key) noexcept {
+  return key.biased_bits;
+}
+
+template <typename K>
+concept RadixKey = requires(const K &k) { radix_bits(k); };
+
+// bits [SHIFT, SHIFT + BITS) of x, BITS <= RADIX_DIGIT_BITS
+template <uint16_t SHIFT, uint16_t BITS, uint16_t N>
+constexpr uint32_t radix_digit(const Bits<N> &x) noexcept {
+  constexpr uint16_t I = SHIFT / 64;
+  constexpr uint16_t O = SHIFT % 64;
+  uint64_t v = x.get(I) >> O;
+  if constexpr (O + BITS > 64) {
+    v |= x.get(I + 1) << (64 - O);
+  }
+  return uint32_t(v & ((uint64_t(1) << BITS) - 1));
+}
+
+// f(0) .. f(threads - 1), all but the first on new threads
+template <typename F> void radix_run(const unsigned threads, F f) {
+  if (threads <= 1) {
+    f(0);
+    return;
+  }
+  std::vector<std::thread> workers;
+  for (unsigned t = 1; t < threads; t++) {
+    workers.emplace_back(f, t);
+  }
+  f(0);
+  for (auto &w : workers) {
+    w.join();
+  }
+}
+
+using RadixCounts = std::array<size_t, size_t(1) << RADIX_DIGIT_BITS>;
+
+// Turns the counts of every digit into the offsets where its keys start,
+// offset[d] counts the keys of the smaller digits. Returns false when one
+// digit has all n keys, the pass would not move anything.
+inline bool radix_offsets(RadixCounts &h, const size_t n) noexcept {
+  size_t total = 0;
+  for (auto &c : h) {
+    if (c == n) {
+      return false;
+    }
+    const size_t next = total + c;
+    c = total;
+    total = next;
+  }
+  return true;
+}
+
+// dst[offset[digit(src[i])]++] = src[i] for i in [begin, end), stable
+template <uint16_t SHIFT, uint16_t BITS, typename K, typename V>
+void radix_scatter(const K *src, const V *src_values, K *dst, V *dst_values,
+                   const size_t begin, const size_t end,
+                   RadixCounts &offset) noexcept {
+  for (size_t i = begin; i < end; i++) {
+    const size_t j = offset[radix_digit<SHIFT, BITS>(radix_bits(src[i]))]++;
+    dst[j] = src[i];
+    if constexpr (!std::is_void_v<V>) {
+      dst_values[j] = src_values[i];
+    }
+  }
+}
+
+// One stable counting pass over digit (SHIFT, BITS) from src[0 .. n) into
+// dst, count[d] is the number of keys with digit d. Returns false, and
+// moves nothing, when every key has the same digit. V is void when there
+// are no values.
+template <uint16_t SHIFT, uint16_t BITS, typename K, typename V>
+bool radix_pass(const K *src, const V *src_values, K *dst, V *dst_values,
+                const size_t n, unsigned threads, RadixCounts &count) {
+  count.fill(0);
+  if (threads <= 1 || n < RADIX_PARALLEL_MIN) {
+    for (size_t i = 0; i < n; i++) {
+      count[radix_digit<SHIFT, BITS>(radix_bits(src[i]))]++;
+    }
+    RadixCounts offset = count;
+    if (!radix_offsets(offset, n)) {
+      return false;
+    }
+    radix_scatter<SHIFT, BITS>(src, src_values, dst, dst_values, 0, n,
+                               offset);
+    return true;
+  }
+
+  // every thread counts its part, then writes a digit's keys after the
+  // ones of the threads before it
+  std::vector<RadixCounts> offset(threads);
+  const auto begin = [&](const unsigned t) { return n * t / threads; };
+  radix_run(threads, [&](const unsigned t) {
+    offset[t].fill(0);
+    for (size_t i = begin(t); i < begin(t + 1); i++) {
+      offset[t][radix_digit<SHIFT, BITS>(radix_bits(src[i]))]++;
+    }
+  });
+  size_t total = 0;
+  for (size_t d = 0; d < count.size(); d++) {
+    for (unsigned t = 0; t < threads; t++) {
+      const size_t c = offset[t][d];
+      offset[t][d] = total;
+      total += c;
+      count[d] += c;
+    }
+    if (count[d] == n) {
+      return false;
+    }
+  }
+  radix_run(threads, [&](const unsigned t) {
+    radix_scatter<SHIFT, BITS>(src, src_values, dst, dst_values, begin(t),
+                               begin(t + 1), offset[t]);
+  });
+  return true;
+}
+
+// copies a[0 .. n) to b[0 .. n)
+template <typename K, typename V>
+void radix_copy(const K *a, const V *a_values, K *b, V *b_values,
+                const size_t n) {
+  std::copy(a, a + n, b);
+  if constexpr (!std::is_void_v<V>) {
+    std::copy(a_values, a_values + n, b_values);
+  }
+}
+
+// stable
+template <typename K, typename V>
+void radix_insertion_sort(K *a, V *a_values, const size_t n) {
+  for (size_t i = 1; i < n; i++) {
+    if (radix_bits(a[i]) < radix_bits(a[i - 1])) {
+      const K key = a[i];
+      size_t j = i;
+      if constexpr (std::is_void_v<V>) {
+        for (; j > 0 && radix_bits(key) < radix_bits(a[j - 1]); j--) {
+          a[j] = a[j - 1];
+        }
+      } else {
+        const V value = a_values[i];
+        for (; j > 0 && radix_bits(key) < radix_bits(a[j - 1]); j--) {
+          a[j] = a[j - 1];
+          a_values[j] = a_values[j - 1];
+        }
+        a_values[j] = value;
+      }
+      a[j] = key;
+    }
+  }
+}
+
+// Sorts a[0 .. n) by the low TOP bits of the keys (the ones above are
+// equal) into a when out_a, into b otherwise. b is scratch space.
+template <uint16_t TOP, typename K, typename V>
+void radix_msd(K *a, V *a_values, K *b, V *b_values, const size_t n,
+               const bool out_a, const unsigned threads) {
+  if constexpr (TOP > 0) {
+    constexpr uint16_t BITS = std::min(TOP, RADIX_DIGIT_BITS);
+    constexpr uint16_t SHIFT = TOP - BITS;
+    if (n > RADIX_SMALL) {
+      RadixCounts count;
+      if (!radix_pass<SHIFT, BITS>(a, a_values, b, b_values, n, threads,
+                                   count)) {
+        radix_msd<SHIFT>(a, a_values, b, b_values, n, out_a, threads);
+        return;
+      }
+      // the buckets are in b now and are sorted on the next digit, the
+      // small ones right here
+      RadixCounts start = count;
+      radix_offsets(start, n + 1);
+      const auto bucket = [&](const size_t d) {
+        const size_t off = start[d];
+        if constexpr (std::is_void_v<V>) {
+          if (count[d] > RADIX_SMALL) {
+            radix_msd<SHIFT, K, V>(b + off, nullptr, a + off, nullptr,
+                                   count[d], !out_a, 1);
+            return;
+          }
+          radix_insertion_sort<K, V>(b + off, nullptr, count[d]);
+          if (out_a) {
+            radix_copy<K, V>(b + off, nullptr, a + off, nullptr, count[d]);
+          }
+        } else {
+          if (count[d] > RADIX_SMALL) {
+            radix_msd<SHIFT>(b + off, b_values + off, a + off,
+                             a_values + off, count[d], !out_a, 1);
+            return;
+          }
+          radix_insertion_sort(b + off, b_values + off, count[d]);
+          if (out_a) {
+            radix_copy(b + off, b_values + off, a + off, a_values + off,
+                       count[d]);
+          }
+        }
+      };
+      if (threads <= 1) {
+        for (size_t d = 0; d < count.size(); d++) {
+          bucket(d);
+        }
+      } else {
+        std::atomic<size_t> next{0};
+        radix_run(threads, [&](unsigned) {
+          for (size_t d; (d = next++) < count.size();) {
+            bucket(d);
+          }
+        });
+      }
+      return;
+    }
+    radix_insertion_sort(a, a_values, n);
+  }
+  if (!out_a) {
+    radix_copy(a, a_values, b, b_values, n);
+  }
+}
+
+// counts[p][d] is the number of keys with digit d in LSD pass p, for every
+// pass in one read of the keys
+template <uint16_t W, uint16_t D, typename K, uint16_t... Ps>
+void radix_count_all(const K *a, const size_t n, RadixCounts *counts,
+                     std::integer_sequence<uint16_t, Ps...>) noexcept {
+  for (size_t p = 0; p < sizeof...(Ps); p++) {
+    counts[p].fill(0);
+  }
+  for (size_t i = 0; i < n; i++) {
+    const auto &x = radix_bits(a[i]);
+    (counts[Ps][radix_digit<Ps * D, std::min<uint16_t>(D, W - Ps * D)>(x)]++,
+     ...);
+  }
+}
+
+// LSD passes P, P + 1, ... of D bits from a into b, the sorted keys end up
+// in out. counts are the ones of radix_count_all, nullptr with threads.
+template <uint16_t W, uint16_t D, uint16_t P, typename K, typename V>
+void radix_lsd(K *a, V *a_values, K *b, V *b_values, K *out, V *out_values,
+               const size_t n, const unsigned threads, RadixCounts *counts) {
+  if constexpr (P * D < W) {
+    constexpr uint16_t SHIFT = P * D;
+    constexpr uint16_t BITS = std::min<uint16_t>(D, W - SHIFT);
+    bool moved;
+    if (counts != nullptr) {
+      moved = radix_offsets(counts[P], n);
+      if (moved) {
+        radix_scatter<SHIFT, BITS>(a, a_values, b, b_values, 0, n, counts[P]);
+      }
+    } else {
+      RadixCounts count;
+      moved = radix_pass<SHIFT, BITS>(a, a_values, b, b_values, n, threads,
+                                      count);
+    }
+    if (moved) {
+      radix_lsd<W, D, P + 1>(b, b_values, a, a_values, out, out_values, n,
+                             threads, counts);
+    } else {
+      radix_lsd<W, D, P + 1>(a, a_values, b, b_values, out, out_values, n,
+                             threads, counts);
+    }
+  } else if (a != out) {
+    radix_copy(a, a_values, out, out_values, n);
+  }
+}
+
+template <typename K, typename V>
+void radix_sort_items(K *keys, V *values, const size_t n,
+                      const unsigned threads) {
+  constexpr uint16_t W =
+      std::remove_cvref_t<decltype(radix_bits(keys[0]))>::WIDTH;
+  if (W == 0 || n < 2) {
+    return;
+  }
+  std::vector<K> scratch(n);
+  std::vector<std::conditional_t<std::is_void_v<V>, char, V>> scratch_values;
+  V *scratch_v = nullptr;
+  if constexpr (!std::is_void_v<V>) {
+    scratch_values.resize(n);
+    scratch_v = scratch_values.data();
+  }
+
+  if constexpr (!RadixPlan<W>::LSD) {
+    radix_msd<W>(keys, values, scratch.data(), scratch_v, n, true, threads);
+  } else {
+    constexpr uint16_t PASSES = RadixPlan<W>::PASSES;
+    constexpr uint16_t D = RadixPlan<W>::DIGIT_BITS;
+    std::array<RadixCounts, PASSES> counts;
+    RadixCounts *known = nullptr;
+    if (threads <= 1 || n < RADIX_PARALLEL_MIN) {
+      radix_count_all<W, D>(keys, n, counts.data(),
+                            std::make_integer_sequence<uint16_t, PASSES>{});
+      known = counts.data();
+    }
+    radix_lsd<W, D, 0>(keys, values, scratch.data(), scratch_v, keys, values,
+                       n, threads, known);
+  }
+}
+
+template <RadixKey K>
+void radix_sort(const std::span<K> keys, const unsigned threads = 1) {
+  radix_sort_items<K, void>(keys.data(), nullptr, keys.size(), threads);
+}
+
+// values[i] moves with keys[i], values.size() == keys.size()
+template <RadixKey K, typename V>
+void radix_sort(const std::span<K> keys, const std::span<V> values,
+                const unsigned threads = 1) {
+  assert(values.size() == keys.size());
+  radix_sort_items(keys.data(), values.data(), keys.size(), threads);
+}
+
+} // namespace mango